@@ -0,0 +1,226 @@
+/*
+ * bench.c
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Standalone CPU benchmark of the bubble spring solver
+//
+// Runs the physics passes of the bubble at a list of subdivision depths
+//   without creating a window, and reports the time per solver step. With
+//   -scene, runs that many bubbles of each depth side by side instead, one
+//   per thread at a time, and reports the vertices stepped per second.
+//
+
+#include <time.h>
+#include "nvgldemo.h"
+#include "shape.h"
+#include "scene.h"
+#include "workers.h"
+
+// Minimum time measured per depth, in seconds
+#define BENCH_MIN_TIME 1.0
+
+// Steps between pokes, to keep the bubble moving
+#define BENCH_POKE_INTERVAL 100
+
+// Current time in seconds. SYSTIME may need an EGL display, which the
+//   benchmark doesn't have.
+static double
+now(void)
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (double)tp.tv_sec + (double)tp.tv_nsec / 1000000000.0;
+}
+
+// Poke the bubble straight down the z axis
+static void
+poke(
+    Shape *b)
+{
+    const float3 e = {0.1f, 0.2f, 5.0f};
+    const float3 n = {0.0f, 0.0f, -2.0f};
+    Bubble_pick(b, e, n);
+}
+
+// Time the solver passes at one depth
+static int
+benchDepth(
+    int depth)
+{
+    double velocity = 0.0, filter = 0.0, normals = 0.0;
+    double t0, t1, t2, t3, start;
+    int    steps = 0;
+    Shape  *b;
+
+    b = Bubble_create(depth);
+    if (!b) {
+        return 0;
+    }
+    Bubble_calcNormals(b);
+
+    start = now();
+    do {
+        if (!(steps % BENCH_POKE_INTERVAL)) {
+            poke(b);
+        }
+        t0 = now();
+        Bubble_calcVelocity(b);
+        t1 = now();
+        Bubble_filterVelocity(b);
+        t2 = now();
+        Bubble_calcNormals(b);
+        t3 = now();
+        velocity += t1 - t0;
+        filter   += t2 - t1;
+        normals  += t3 - t2;
+        steps++;
+    } while (t3 - start < BENCH_MIN_TIME);
+
+    NvGlDemoLog("%6d %9d %9d %10.2f %10.2f %10.2f %10.2f %10.1f\n",
+                depth, b->numVerts, b->numEdges,
+                1.0e6 * velocity / steps,
+                1.0e6 * filter / steps,
+                1.0e6 * normals / steps,
+                1.0e6 * (velocity + filter + normals) / steps,
+                steps / (velocity + filter + normals));
+
+    Bubble_destroy(b);
+    return 1;
+}
+
+// Time the solver over a scene of bubbles of one depth
+static int
+benchScene(
+    int depth,
+    int count)
+{
+    int    depths[SCENE_MAX_BUBBLES];
+    double start, elapsed;
+    int    steps = 0;
+    Scene  *s;
+    int    i;
+
+    for (i = 0; i < count; i++) {
+        depths[i] = depth;
+    }
+    s = Scene_create(count, depths);
+    if (!s) {
+        return 0;
+    }
+
+    start = now();
+    do {
+        if (!(steps % BENCH_POKE_INTERVAL)) {
+            for (i = 0; i < s->numBubbles; i++) {
+                poke(s->bubbles[i].shape);
+            }
+        }
+        Scene_start(s, 1);
+        Scene_finish(s);
+        steps++;
+        elapsed = now() - start;
+    } while (elapsed < BENCH_MIN_TIME);
+
+    NvGlDemoLog("%6d %9d %9d %10.2f %10.1f %12.2f\n",
+                depth, s->numBubbles, s->numVerts,
+                1.0e6 * elapsed / steps,
+                steps / elapsed,
+                s->numVerts * (steps / elapsed) / 1.0e6);
+
+    Scene_destroy(s);
+    return 1;
+}
+
+static void
+usage(void)
+{
+    NvGlDemoLog("Usage: bubblebench [-threads <count>] [-scene <bubbles>]"
+                " [depth ...]\n");
+}
+
+int main(int argc, char **argv)
+{
+    static const int defaultDepths[] = {6, 13, 25, 50};
+    int threads = 1;
+    int bubbles = 0;
+    int first = 1;
+    int failure = 1;
+    int i;
+
+    while ((argc > first + 1) && (argv[first][0] == '-')) {
+        int value = (int)STRTOL(argv[first + 1], NULL, 10);
+        if (!STRCMP(argv[first], "-threads") &&
+            (value >= 1) && (value <= WORKERS_MAX)) {
+            threads = value;
+        } else if (!STRCMP(argv[first], "-scene") &&
+                   (value >= 1) && (value <= SCENE_MAX_BUBBLES)) {
+            bubbles = value;
+        } else {
+            usage();
+            return 1;
+        }
+        first += 2;
+    }
+    if (!Workers_initialize(threads)) {
+        return 1;
+    }
+
+    NvGlDemoLog("Bubble solver benchmark, %d thread(s)"
+                " (times in microseconds per step)\n", Workers_count());
+    if (bubbles) {
+        NvGlDemoLog("%6s %9s %9s %10s %10s %12s\n",
+                    "depth", "bubbles", "vertices", "total", "steps/s",
+                    "Mverts/s");
+    } else {
+        NvGlDemoLog("%6s %9s %9s %10s %10s %10s %10s %10s\n",
+                    "depth", "vertices", "edges",
+                    "velocity", "filter", "normals", "total", "steps/s");
+    }
+
+    if (argc > first) {
+        for (i = first; i < argc; i++) {
+            int depth = (int)STRTOL(argv[i], NULL, 10);
+            if (depth < 1) {
+                usage();
+                goto done;
+            }
+            if (!(bubbles ? benchScene(depth, bubbles)
+                          : benchDepth(depth))) {
+                goto done;
+            }
+        }
+    } else {
+        for (i = 0; i < (int)(sizeof(defaultDepths)/sizeof(int)); i++) {
+            if (!(bubbles ? benchScene(defaultDepths[i], bubbles)
+                          : benchDepth(defaultDepths[i]))) {
+                goto done;
+            }
+        }
+    }
+    failure = 0;
+
+    done:
+    Workers_deinitialize();
+    return failure;
+}
@@ -27,33 +27,163 @@
 //
 
 #include "nvgldemo.h"
+#include <unistd.h>
 #include "bubble.h"
 #include "shaders.h"
 
 /** Macro for determining the size of an array */
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 
+// Smallest depth given to the smaller bubbles of a scene
+#define SCENE_MIN_DEPTH 13
+
+// Fastest rotation, in radians per second, that lets the frame loop idle
+#define IDLE_SPIN 0.01f
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // Setup/shutdown
 //
 
+// Check whether GL_UNSIGNED_INT element indices can be used
+static bool
+BubbleState_hasUintIndices(void)
+{
+    const char *extensions = (const char*)glGetString(GL_EXTENSIONS);
+
+    if (NvGlDemoHasGlesVersion(3, 0)) {
+        return true;
+    }
+    return (extensions && STRSTR(extensions, "GL_OES_element_index_uint"))
+           ? true : false;
+}
+
+// Switch the spring solver between the CPU and the GPU. When switching
+//   back, the CPU carries on from the GPU state.
+static void
+BubbleState_setGpuPhysics(
+    BubbleState  *b,
+    bool         enable)
+{
+    if (enable && !b->gpu) {
+        b->gpu = GpuBubble_create(b->bubble);
+        if (!b->gpu) {
+            NvGlDemoLog("GPU physics unavailable, using the CPU\n");
+            enable = false;
+        }
+    } else if (!enable && b->gpu) {
+        if (!b->gpuVerify) {
+            GpuBubble_read(b->gpu, b->bubble);
+            Bubble_calcNormals(b->bubble);
+            Bubble_interpolate(b->bubble, 1.0f);
+        }
+        GpuBubble_destroy(b->gpu);
+        b->gpu = NULL;
+    }
+    b->gpuPhysics = enable;
+    b->asleep     = false;
+}
+
+// Reduce a depth to one the element indices can handle
+static int
+BubbleState_limitDepth(
+    BubbleState  *b,
+    int          depth)
+{
+    // Beyond 64K vertices the strips need 32-bit indices
+    if (BUBBLE_NEEDS_UINT_INDICES(depth) && !b->uintIndices) {
+        while (BUBBLE_NEEDS_UINT_INDICES(depth)) depth--;
+        NvGlDemoLog("32-bit indices not supported, using depth %d\n",
+                    depth);
+    }
+    return depth;
+}
+
 // Set up bubble geometry
 static void
 BubbleState_buildBubble(
     BubbleState  *b,
     int          depth)
 {
+    Shape *bubble;
+
+    depth = BubbleState_limitDepth(b, depth);
+
+    // Keep the current bubble if the new one can't be built
+    bubble = Bubble_create(depth);
+    if (!bubble) {
+        NvGlDemoLog("Could not build a bubble of depth %d\n", depth);
+        return;
+    }
+    if (b->gpu) {
+        GpuBubble_destroy(b->gpu);
+        b->gpu = NULL;
+    }
     if (b->bubble) {
         Bubble_destroy(b->bubble);
     }
-    switch (depth) {
-        case 2: b->bubble = Bubble_create( 6); break;
-        case 3: b->bubble = Bubble_create(13); break;
-        case 4: b->bubble = Bubble_create(25); break;
-        default: return;
+    b->bubble = bubble;
+    b->asleep = false;
+    if (!Bubble_createBuffers(b->bubble, b->gles3)) {
+        NvGlDemoLog("Could not create bubble buffers, drawing from"
+                    " client memory\n");
     }
     Bubble_calcNormals(b->bubble);
+    Bubble_interpolate(b->bubble, 1.0f);
+    if (b->gpuPhysics) {
+        BubbleState_setGpuPhysics(b, true);
+    }
+
+    if (b->stressFlag) {
+        NvGlDemoLog("Bubble depth %d: %d vertices, %d edges, %d triangles\n",
+                    depth, bubble->numVerts, bubble->numEdges,
+                    bubble->numFaces);
+    }
+}
+
+// Set up a scene of several bubbles. Every third bubble has the requested
+//   depth, and the others three quarters and half of it, so the bubbles
+//   give the solver threads uneven amounts of work.
+static void
+BubbleState_buildScene(
+    BubbleState  *b,
+    int          depth)
+{
+    int   depths[SCENE_MAX_BUBBLES];
+    int   least;
+    Scene *scene;
+    int   i;
+
+    depth = BubbleState_limitDepth(b, depth);
+    least = (depth < SCENE_MIN_DEPTH) ? depth : SCENE_MIN_DEPTH;
+    for (i = 0; i < b->sceneCount; i++) {
+        depths[i] = depth - (i % 3) * depth / 4;
+        if (depths[i] < least) depths[i] = least;
+    }
+
+    // Keep the current scene if the new one can't be built
+    scene = Scene_create(b->sceneCount, depths);
+    if (!scene) {
+        NvGlDemoLog("Could not build a scene of %d bubbles of depth %d\n",
+                    b->sceneCount, depth);
+        return;
+    }
+    if (b->scene) {
+        Scene_destroy(b->scene);
+    }
+    b->scene  = scene;
+    b->asleep = false;
+    for (i = 0; i < scene->numBubbles; i++) {
+        if (!Bubble_createBuffers(scene->bubbles[i].shape, b->gles3) &&
+            !i) {
+            NvGlDemoLog("Could not create bubble buffers, drawing from"
+                        " client memory\n");
+        }
+    }
+
+    NvGlDemoLog("Scene of %d bubbles of depth %d and below,"
+                " %d vertices in all\n",
+                scene->numBubbles, depth, scene->numVerts);
 }
 
 // Set up the bubble window state
@@ -61,10 +191,19 @@ int
 BubbleState_init(
     BubbleState  *b,
     int          autopoke,
+    int          autopokePoints,
     float        duration,
     int          fpsFlag,
     bool         fframeIncrement,
     float        delta,
+    int          depth,
+    int          sceneCount,
+    bool         stress,
+    float        physicsRate,
+    int          physicsMaxSteps,
+    float        idleRate,
+    bool         gpuPhysics,
+    bool         gpuVerify,
     GLsizei      width,
     GLsizei      height)
 {
@@ -85,9 +224,25 @@ BubbleState_init(
     b->fframeIncrement    = fframeIncrement;
     b->currentFrameNumber = 1;
 
+    // Initialize physics stepping
+    b->physicsRate        = physicsRate;
+    b->physicsMaxSteps    = physicsMaxSteps;
+    b->physicsTime        = 0.0f;
+    b->physicsCount       = 0;
+    b->physicsValue       = 0.0f;
+
+    // Initialize rest detection
+    b->asleep             = false;
+    b->timeAsleep         = 0.0;
+    b->timeAwake          = 0.0;
+    b->idle               = false;
+    b->idleRate           = idleRate;
+
     // Initialize autopoke
     b->autopokeInterval = autopoke;
     b->autopokeCount    = 0;
+    b->autopokePoints   = autopokePoints;
+    b->numPokes         = 0;
 
     // Initialize mouse state
     b->mouseX           = 0;
@@ -119,11 +274,38 @@ BubbleState_init(
     b->envCube          = NULL;
     b->cubeTexture      = 0;
     b->bubble           = NULL;
+    b->scene            = NULL;
+    b->sceneCount       = sceneCount;
     b->mouseFlag        = true;
     b->font             = NULL;
+    b->depth            = depth;
+    b->gles3            = NvGlDemoHasGlesVersion(3, 0) ? true : false;
+    b->uintIndices      = BubbleState_hasUintIndices();
+
+    // Initialize stage timing
+    b->stressFlag       = stress;
+    b->stressPhysics    = 0.0;
+    b->stressNormals    = 0.0;
+    b->stressDraw       = 0.0;
+    b->stressWait       = 0.0;
 
-    // Construct the bubble geometry with maximum subdivision
-    BubbleState_buildBubble(b, 4);
+    // The GPU solver is started once the shaders are loaded
+    b->gpuPhysics       = false;
+    b->gpuVerify        = gpuVerify;
+    b->gpu              = NULL;
+
+    // Construct the bubble geometry with the requested subdivision
+    if (b->sceneCount) {
+        BubbleState_buildScene(b, b->depth);
+        if (!b->scene) {
+            return 0;
+        }
+    } else {
+        BubbleState_buildBubble(b, b->depth);
+        if (!b->bubble) {
+            return 0;
+        }
+    }
 
     // Initialize GL settings
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -138,6 +320,12 @@ BubbleState_init(
     if (!LoadShaders()) {
         return 0;
     }
+    if (gpuPhysics && b->scene) {
+        NvGlDemoLog("GPU physics is not available for a scene,"
+                    " using the CPU\n");
+    } else if (gpuPhysics) {
+        BubbleState_setGpuPhysics(b, true);
+    }
 
     // Initialize the viewport
     BubbleState_reshapeViewport(b, width, height);
@@ -169,6 +357,8 @@ BubbleState_term(
 {
     if (b != NULL) {
         if (b->envCube != NULL) EnvCube_destroy(b->envCube);
+        if (b->scene != NULL)   Scene_destroy(b->scene);
+        if (b->gpu != NULL)     GpuBubble_destroy(b->gpu);
         if (b->bubble != NULL)  Bubble_destroy(b->bubble);
         if (b->font != NULL)    nvtexfontUnloadRasterFont(b->font);
     }
@@ -180,16 +370,26 @@ BubbleState_term(
 // Mouse/keyboard event handling
 //
 
-// Pick a point on the bubble to poke when mouse/space is pressed
+// Queue a poke at a point on the screen, in the [-1,+1] range used for
+//   the mouse. The pokes of a frame are applied together.
 static void
 BubbleState_pick(
-    BubbleState  *b)
+    BubbleState  *b,
+    float        screenX,
+    float        screenY)
 {
     float4x4 m;
-    float3 e;
-    float3 n;
-    float y = b->nearHeight * b->screenY;
-    float x = b->nearHeight * b->aspect * b->screenX;
+    float *e;
+    float *n;
+    float y = b->nearHeight * screenY;
+    float x = b->nearHeight * b->aspect * screenX;
+
+    if (b->numPokes == BUBBLE_MAX_POKES) {
+        return;
+    }
+    e = b->pokeEye[b->numPokes];
+    n = b->pokeDir[b->numPokes];
+    b->numPokes++;
 
     e[0] = 0.0f;
     e[1] = 0.0f;
@@ -201,7 +401,36 @@ BubbleState_pick(
     mat_invert(m);
     pnt_transform(e, m);
     vec_transform(n, m);
-    Bubble_pick(b->bubble, e, n);
+}
+
+// Apply the queued pokes in one batch. In a scene, each one is passed
+//   to the bubble it hits, for the scene's next job.
+static void
+BubbleState_poke(
+    BubbleState  *b)
+{
+    int i;
+
+    if (!b->numPokes) {
+        return;
+    }
+    if (b->scene) {
+        for (i = 0; i < b->numPokes; i++) {
+            Scene_pick(b->scene, b->pokeEye[i], b->pokeDir[i]);
+        }
+        b->numPokes = 0;
+        return;
+    }
+    b->asleep = false;
+    if (b->gpu) {
+        GpuBubble_pick(b->gpu, b->numPokes,
+                       (const float3*)b->pokeEye, (const float3*)b->pokeDir);
+    }
+    if (!b->gpu || b->gpuVerify) {
+        Bubble_pickMany(b->bubble, b->numPokes,
+                        (const float3*)b->pokeEye, (const float3*)b->pokeDir);
+    }
+    b->numPokes = 0;
 }
 
 // Handle left mouse button press
@@ -212,7 +441,7 @@ BubbleState_leftMouse(
 {
     b->mouseDown = click;
     if (click == true) {
-        BubbleState_pick(b);
+        BubbleState_pick(b, b->screenX, b->screenY);
     }
 }
 
@@ -239,6 +468,20 @@ BubbleState_mouse(
     b->mouseFlag = true;
 }
 
+// Count the triangles drawn for a bubble
+static int
+BubbleState_countTriangles(
+    Shape        *shape)
+{
+    int triCount = 0;
+    int i;
+
+    for ( i=0 ; i<shape->numTristrips ; i++ ) {
+        triCount += shape->tristrips[i].numVerts - 2;
+    }
+    return triCount;
+}
+
 // Handle key press
 void
 BubbleState_callback(
@@ -277,6 +520,8 @@ BubbleState_callback(
 #endif
                 "3: medium res bubble\n"
                 "4: high res bubble\n"
+                "5: bubble at the -depth resolution\n"
+                "g: toggle GPU physics\n"
 #ifdef USE_FAKE_MOUSE
                 "SPACE: poke the bubble\n"
 #else
@@ -325,8 +570,13 @@ BubbleState_callback(
         case 'T':
             triCount = 0;
             // count up the triangles in the tristrips
-            for ( i=0 ; i<(b->bubble)->numTristrips ; i++ ) {
-                triCount += (b->bubble)->tristrips[i].numVerts - 2;
+            if (b->scene) {
+                for ( i=0 ; i<b->scene->numBubbles ; i++ ) {
+                    triCount += BubbleState_countTriangles(
+                                    b->scene->bubbles[i].shape);
+                }
+            } else {
+                triCount += BubbleState_countTriangles(b->bubble);
             }
             // add in the 6 walls of the cube that we're in
             triCount += 6*2;
@@ -336,14 +586,30 @@ BubbleState_callback(
             break;
 #ifdef YOU_REALLY_WANT_UNSTABLE_GEOMETRY
         case '2':
-            BubbleState_buildBubble(b, 2);
+            if (b->scene) BubbleState_buildScene(b, 6);
+            else          BubbleState_buildBubble(b, 6);
             break;
 #endif
         case '3':
-            BubbleState_buildBubble(b, 3);
+            if (b->scene) BubbleState_buildScene(b, 13);
+            else          BubbleState_buildBubble(b, 13);
             break;
         case '4':
-            BubbleState_buildBubble(b, 4);
+            if (b->scene) BubbleState_buildScene(b, 25);
+            else          BubbleState_buildBubble(b, 25);
+            break;
+        case '5':
+            if (b->scene) BubbleState_buildScene(b, b->depth);
+            else          BubbleState_buildBubble(b, b->depth);
+            break;
+        case 'g':
+        case 'G':
+            if (b->scene) {
+                NvGlDemoLog("GPU physics is not available for a scene\n");
+                break;
+            }
+            BubbleState_setGpuPhysics(b, !b->gpuPhysics);
+            NvGlDemoLog("physics on the %s\n", b->gpuPhysics ? "GPU" : "CPU");
             break;
         case 'p':
         case 'P':
@@ -393,20 +659,56 @@ BubbleState_drawmouse(
     glDisableVertexAttribArray(aloc_mouseVertex);
 }
 
+// Draw one bubble in the current mode
+static void
+BubbleState_drawBubble(
+    BubbleState  *b,
+    Shape        *shape,
+    float4x4     modelview,
+    float4x4     projection)
+{
+    float4x4 normal;
+
+    // For full bubble we also need the normal matrix
+    if (b->mode == CUBE_MODE) {
+        glUseProgram(prog_bubble);
+        MEMCPY(normal, modelview, 16*sizeof(float));
+        mat_transpose(normal);
+        mat_invert_part(normal);
+        glUniformMatrix4fv(uloc_bubbleProjMat, 1, GL_FALSE,
+                           (GLfloat*)projection);
+        glUniformMatrix4fv(uloc_bubbleViewMat, 1, GL_FALSE,
+                           (GLfloat*)modelview);
+        glUniformMatrix4fv(uloc_bubbleNormMat, 1, GL_FALSE,
+                           (GLfloat*)normal);
+        Bubble_draw(shape, b->envCube->cubeTexture);
+    } else {
+        glUseProgram(prog_mesh);
+        glUniformMatrix4fv(uloc_meshProjMat, 1, GL_FALSE,
+                           (GLfloat*)projection);
+        glUniformMatrix4fv(uloc_meshViewMat, 1, GL_FALSE,
+                           (GLfloat*)modelview);
+        if (b->mode == WIRE_MODE)
+            Bubble_drawEdges(shape);
+        else
+            Bubble_drawVertices(shape);
+    }
+}
+
 // Draw the frame
 static void
 BubbleState_draw(
-    BubbleState  *b,
-    float        delta)
+    BubbleState  *b)
 {
     const float3 pitchAxis   = {1.0f, 0.0f, 0.0f};
     const float3 headingAxis = {0.0f, 1.0f, 0.0f};
     Quat     q1, q2;
     float4x4 modelview;
     float4x4 projection;
-    float4x4 normal;
     float4x4 m;
     float3   v;
+    double   drawStart;
+    int      i;
 
     // Clear the buffers
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -443,46 +745,30 @@ BubbleState_draw(
     glUniformMatrix4fv(uloc_cubeProjMat, 1, GL_FALSE, (GLfloat*)&projection);
     EnvCube_draw(b->envCube);
 
-    // Perform bubble dynamics
-    // TODO: These calculations should take the frame rate into account.
-    // TODO:   Currently the bubble dynamics just apply a fixed delta
-    // TODO:   per frame. So when running at a higher frame rate, the
-    // TODO:   bubble will appear more animated.
-    if(delta != 0.0) {
-        Bubble_calcVelocity(b->bubble);
-        Bubble_filterVelocity(b->bubble);
-        Bubble_calcNormals(b->bubble);
-    }
-
-    // Draw the bubble. For full bubble we also need the normal matrix
-    if (b->mode == CUBE_MODE) {
-        glUseProgram(prog_bubble);
-        MEMCPY(normal, modelview, 16*sizeof(float));
-        mat_transpose(normal);
-        mat_invert_part(normal);
-        glUniformMatrix4fv(uloc_bubbleProjMat, 1, GL_FALSE,
-                           (GLfloat*)&projection);
-        glUniformMatrix4fv(uloc_bubbleViewMat, 1, GL_FALSE,
-                           (GLfloat*)&modelview);
-        glUniformMatrix4fv(uloc_bubbleNormMat, 1, GL_FALSE,
-                           (GLfloat*)&normal);
-        Bubble_draw(b->bubble, b->envCube->cubeTexture);
+    // Draw the bubbles. The stage timing covers streaming the vertex data
+    //   and submitting the draw, which is where a large bubble's upload
+    //   cost shows.
+    drawStart = b->stressFlag ? (double)SYSTIME() / 1000000000.0 : 0.0;
+    if (b->scene) {
+        for (i = 0; i < b->scene->numBubbles; i++) {
+            SceneBubble *sb = &b->scene->bubbles[i];
+            MEMCPY(m, modelview, 16*sizeof(float));
+            mat_translate(m, sb->center[0], sb->center[1], sb->center[2]);
+            mat_scale(m, sb->radius, sb->radius, sb->radius);
+            BubbleState_drawBubble(b, sb->shape, m, projection);
+        }
     } else {
-        glUseProgram(prog_mesh);
-        glUniformMatrix4fv(uloc_meshProjMat, 1, GL_FALSE,
-                           (GLfloat*)&projection);
-        glUniformMatrix4fv(uloc_meshViewMat, 1, GL_FALSE,
-                           (GLfloat*)&modelview);
-        if (b->mode == WIRE_MODE)
-            Bubble_drawEdges(b->bubble);
-        else
-            Bubble_drawVertices(b->bubble);
+        BubbleState_drawBubble(b, b->bubble, modelview, projection);
+    }
+    if (b->stressFlag) {
+        b->stressDraw += (double)SYSTIME() / 1000000000.0 - drawStart;
     }
 
     // Update fps
     if (b->fpsFlag && b->fpsValue != 0.0f) {
-        char   buf[30];
-        SNPRINTF(buf, ARRAY_SIZE(buf), "FPS: %5.1f", b->fpsValue);
+        char   buf[40];
+        SNPRINTF(buf, ARRAY_SIZE(buf), "FPS: %5.1f  Steps/s: %5.1f",
+                 b->fpsValue, b->physicsValue);
         nvtexfontRenderString_All(b->font, buf,
                                   0.5f, -0.8f, 0.5f, 0.5f, 1.0f, 1.0f, 1.0f);
     }
@@ -545,6 +831,110 @@ BubbleState_rotate(
     }
 }
 
+// Count the physics steps due after a frame time, at most physicsMaxSteps,
+//   leaving the rest of a step in physicsTime
+static int
+BubbleState_countSteps(
+    BubbleState  *b,
+    float        delta)
+{
+    float  step  = 1.0f / b->physicsRate;
+    int    count = 0;
+
+    b->physicsTime += delta;
+    while ((b->physicsTime >= step) && (count < b->physicsMaxSteps)) {
+        b->physicsTime -= step;
+        count++;
+    }
+    if (b->physicsTime >= step) {
+        b->physicsTime -= step * (float)(int)(b->physicsTime / step);
+    }
+    b->physicsCount += count;
+    return count;
+}
+
+// Advance the bubble dynamics by a frame time. The physics runs in fixed
+//   steps, so it behaves the same at any frame rate, and the bubble is
+//   drawn between the last two steps. When a frame takes longer than
+//   physicsMaxSteps steps, the rest of its time is dropped and the bubble
+//   slows down instead of falling further behind. The GPU solver draws
+//   straight from its latest step.
+static void
+BubbleState_simulate(
+    BubbleState  *b,
+    float        delta)
+{
+    float  step  = 1.0f / b->physicsRate;
+    int    count;
+    int    i;
+    double t0, t1, t2;
+
+    if (delta <= 0.0f) {
+        return;
+    }
+    if (b->asleep) {
+        b->physicsTime = 0.0f;
+        return;
+    }
+
+    count = BubbleState_countSteps(b, delta);
+    for (i = 0; i < count; i++) {
+        t0 = b->stressFlag ? (double)SYSTIME() / 1000000000.0 : 0.0;
+        if (b->gpu) {
+            GpuBubble_step(b->gpu);
+        }
+        if (!b->gpu || b->gpuVerify) {
+            Bubble_step(b->bubble);
+        }
+        t1 = b->stressFlag ? (double)SYSTIME() / 1000000000.0 : 0.0;
+        if (!b->gpu || b->gpuVerify) {
+            Bubble_calcNormals(b->bubble);
+        }
+        t2 = b->stressFlag ? (double)SYSTIME() / 1000000000.0 : 0.0;
+        b->stressPhysics += t1 - t0;
+        b->stressNormals += t2 - t1;
+    }
+
+    // Once the CPU solver has settled, stop stepping until the next poke.
+    //   The GPU solver's motion is never read back, so it doesn't sleep.
+    if (!b->gpu && Bubble_isResting(b->bubble)) {
+        b->asleep = true;
+        Bubble_interpolate(b->bubble, 1.0f);
+    } else if (!b->gpu) {
+        Bubble_interpolate(b->bubble, b->physicsTime / step);
+    }
+}
+
+// Advance a scene of bubbles by a frame time. The steps run on the solver
+//   threads while the frame is drawn, so the bubbles are drawn between the
+//   last two steps that have finished, a frame behind the physics. The
+//   scene is asleep while all its bubbles are at rest.
+static void
+BubbleState_simulateScene(
+    BubbleState  *b,
+    float        delta)
+{
+    float  step  = 1.0f / b->physicsRate;
+    int    count = 0;
+    double t0;
+
+    t0 = b->stressFlag ? (double)SYSTIME() / 1000000000.0 : 0.0;
+    Scene_finish(b->scene);
+    if (b->stressFlag) {
+        b->stressWait += (double)SYSTIME() / 1000000000.0 - t0;
+    }
+
+    BubbleState_poke(b);
+    b->asleep = Scene_isResting(b->scene) ? true : false;
+    if (b->asleep) {
+        b->physicsTime = 0.0f;
+    } else if (delta > 0.0f) {
+        count = BubbleState_countSteps(b, delta);
+    }
+    Scene_interpolate(b->scene, b->physicsTime / step);
+    Scene_start(b->scene, count);
+}
+
 // Process the next frame
 void
 BubbleState_tick(
@@ -553,6 +943,16 @@ BubbleState_tick(
     double time;
     float  delta;
     float  fpsDelta;
+    int    i;
+
+    // While nothing moves, hold the frames back to the idle rate
+    if (b->idle) {
+        double wait = b->timeCurrent + 1.0 / b->idleRate
+                    - (double)SYSTIME() / 1000000000.0;
+        if (wait > 0.0) {
+            usleep((useconds_t)(1000000.0 * wait));
+        }
+    }
 
     // Get current time and calculate delta since last frame
     time = (double)SYSTIME() / 1000000000.0;
@@ -563,10 +963,48 @@ BubbleState_tick(
     fpsDelta = (float)(time - b->fpsTime);
     if (fpsDelta >= b->fpsInterval) {
         b->fpsValue = (float)b->fpsCount / fpsDelta;
+        b->physicsValue = (float)b->physicsCount / fpsDelta;
+        if (b->scene && (b->fpsFlag || b->stressFlag)) {
+            NvGlDemoLog("fps: %.1f  steps/s: %.1f  bubbles: %d"
+                        "  vertex steps/s: %.1fM\n",
+                        b->fpsValue, b->physicsValue, b->scene->numBubbles,
+                        b->scene->vertexSteps / fpsDelta / 1.0e6);
+            if (b->stressFlag) {
+                NvGlDemoLog("ms/frame: waiting for the solver %.2f,"
+                            " draw %.2f\n",
+                            1000.0 * b->stressWait / b->fpsCount,
+                            1000.0 * b->stressDraw / b->fpsCount);
+            }
+            b->stressWait = 0.0;
+            b->stressDraw = 0.0;
+        } else if (b->stressFlag) {
+            NvGlDemoLog("fps: %.1f  steps/s: %.1f  ms/frame: physics %.2f,"
+                        " normals %.2f, draw %.2f\n",
+                        b->fpsValue, b->physicsValue,
+                        1000.0 * b->stressPhysics / b->fpsCount,
+                        1000.0 * b->stressNormals / b->fpsCount,
+                        1000.0 * b->stressDraw / b->fpsCount);
+            b->stressPhysics = 0.0;
+            b->stressNormals = 0.0;
+            b->stressDraw    = 0.0;
+        } else if (b->fpsFlag) {
+            NvGlDemoLog("fps: %f  physics steps/s: %f\n",
+                        b->fpsValue, b->physicsValue);
+        }
+        if (b->fpsFlag || b->stressFlag) {
+            NvGlDemoLog("physics asleep %.1fs, active %.1fs\n",
+                        b->timeAsleep, b->timeAwake);
+        }
+        if (b->scene) {
+            b->scene->vertexSteps = 0.0;
+        }
+        if (b->gpu && b->gpuVerify) {
+            NvGlDemoLog("GPU physics differs from the CPU by up to %g\n",
+                        GpuBubble_compare(b->gpu, b->bubble));
+        }
         b->fpsCount = 0;
+        b->physicsCount = 0;
         b->fpsTime  = time;
-        if (b->fpsFlag)
-            NvGlDemoLog("fps: %f\n", b->fpsValue);
     }
     b->fpsCount++;
 
@@ -583,11 +1021,22 @@ BubbleState_tick(
         }
     }
 
-    // Update the orientation
+    // Update the orientation and dynamics
     BubbleState_rotate(b, delta);
+    if (b->scene) {
+        BubbleState_simulateScene(b, delta);
+    } else {
+        BubbleState_poke(b);
+        BubbleState_simulate(b, delta);
+    }
+    if (b->asleep) {
+        b->timeAsleep += delta;
+    } else {
+        b->timeAwake  += delta;
+    }
 
     // Draw the frame
-    BubbleState_draw(b, delta);
+    BubbleState_draw(b);
 
     // Update frame number
     if (b->currentFrameNumber == LONG_MAX) {
@@ -607,9 +1056,22 @@ BubbleState_tick(
     // Handle auto-poking
     (b->autopokeCount)++;
     if (b->autopokeInterval && b->autopokeCount == b->autopokeInterval) {
-        BubbleState_pick(b);
+        // the cursor, and any other points spread in a ring around it
+        BubbleState_pick(b, b->screenX, b->screenY);
+        for (i = 1; i < b->autopokePoints; i++) {
+            float angle = 2.0f * PI * (float)i / (float)(b->autopokePoints-1);
+            BubbleState_pick(b, b->screenX + 0.4f * COS(angle),
+                                b->screenY + 0.4f * SIN(angle));
+        }
         b->autopokeCount = 0;
     }
+
+    // Let the frame loop idle once the physics is asleep and the view is
+    //   nearly still. Pokes wake it on the next frame.
+    b->idle = ((b->idleRate > 0.0f) && b->asleep && !b->numPokes &&
+               !b->fframeIncrement &&
+               (b->hv < IDLE_SPIN) && (b->hv > -IDLE_SPIN) &&
+               (b->pv < IDLE_SPIN) && (b->pv > -IDLE_SPIN)) ? true : false;
 }
 
 // Initialize/change the viewport
@@ -34,8 +34,13 @@
 #include "algebra.h"
 #include "envcube.h"
 #include "shape.h"
+#include "gpushape.h"
+#include "scene.h"
 #include "nvtexfont.h"
 
+// Most pokes handled together in one frame
+#define BUBBLE_MAX_POKES 10
+
 // Simple boolean type
 typedef enum {false = 0, true} bool;
 
@@ -55,9 +60,26 @@ typedef struct {
     float           delta;          // delta time in-between frames
     bool            fframeIncrement;    // Run in Fixed-Frame Increment mode (Fixed increment of frames)
 
+    float           physicsRate;    // Physics steps per simulated second
+    int             physicsMaxSteps;    // Most physics steps per frame
+    float           physicsTime;    // Simulated time not yet stepped
+    int             physicsCount;   // Physics steps since last fps report
+    float           physicsValue;   // Last value computed for steps/sec
+    bool            asleep;         // Physics at rest, skipped until poked
+    double          timeAsleep;     // Time spent with the physics asleep
+    double          timeAwake;      //   and running, since the start
+    bool            idle;           // Nothing moving, frames held back
+    float           idleRate;       // Frames per second when idle (0 = no
+                                    //   limit)
+
     unsigned long   currentFrameNumber; // current frame number since start of app
     int             autopokeInterval;   // Autopoking interval (0 = disabled)
     int             autopokeCount;      // Frames since last autopoke
+    int             autopokePoints;     // Points poked at once by autopoke
+
+    int             numPokes;           // Pick rays waiting for the next
+    float3          pokeEye[BUBBLE_MAX_POKES];  //   physics update
+    float3          pokeDir[BUBBLE_MAX_POKES];
 
     int             mouseX, mouseY;     // Absolute mouse position (wrt corner)
     float           screenX, screenY;   // Relative mouse position (wrt center)
@@ -81,19 +103,43 @@ typedef struct {
     EnvCube         *envCube;       // Cubemap state
     unsigned int    cubeTexture;    // Cubemap texture ID
     Shape           *bubble;        // Bubble shape state
+    Scene           *scene;         // Several bubbles instead, if requested
+    int             sceneCount;     // Bubbles in the scene (0 = one bubble)
+    int             depth;          // Subdivision requested on command line
+    bool            gles3;          // OpenGL ES 3 context
+    bool            uintIndices;    // 32-bit element indices are supported
     int             mouseFlag;      // Enable mouse crosshair cursor
 
     NVTexfontRasterFont *font;      // Display font info
+
+    bool            stressFlag;     // Report time spent in each stage
+    double          stressPhysics;  // Time in each stage since last report
+    double          stressNormals;
+    double          stressDraw;
+    double          stressWait;     // Time waiting for the scene's solver
+
+    bool            gpuPhysics;     // Solve the springs on the GPU
+    bool            gpuVerify;      // Also solve on the CPU and compare
+    GpuShape        *gpu;           // GPU copy of the bubble, if in use
 } BubbleState;
 
 int
 BubbleState_init(
     BubbleState  *b,
     int          autopoke,
+    int          autopokePoints,
     float        duration,
     int          fpsFlag,
     bool         fframeIncrement,
     float        delta,
+    int          depth,
+    int          sceneCount,
+    bool         stress,
+    float        physicsRate,
+    int          physicsMaxSteps,
+    float        idleRate,
+    bool         gpuPhysics,
+    bool         gpuVerify,
     GLsizei      width,
     GLsizei      height);
 
@@ -0,0 +1,495 @@
+/*
+ * gpushape.c
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Bubble spring solver running on the GPU with transform feedback
+//
+// Each step is a pass per color class of edges, plus one to find the
+//   normals and pull the vertices home, exactly as Bubble_step and
+//   Bubble_calcNormals do on the CPU. Within a class no two edges share a
+//   vertex, so each vertex applies its own edge and works out the new
+//   velocity of the other end by itself. That keeps the order of the
+//   updates, and the results, the same as the CPU solver's.
+//
+
+#include "nvgldemo.h"
+#include "gpushape.h"
+#include "shaders.h"
+
+// Per vertex edge record for one color class
+typedef struct {
+    GLint   other;          // other end, or -1
+    GLint   second;         // 1 if this vertex is the edge's v1
+    GLfloat length;
+    GLfloat pad;
+} GpuEdge;
+
+// Allocate the arrays to read the state back into
+static int
+allocScratch(
+    GpuShape *g)
+{
+    int size = 3 * g->shape->numVerts * sizeof(float);
+
+    MEMSET(&g->scratch, 0, sizeof(Shape));
+    g->scratch.numVerts = g->shape->numVerts;
+    g->scratch.p = (float*)MALLOC(size);
+    g->scratch.n = (float*)MALLOC(size);
+    g->scratch.v = (float*)MALLOC(size);
+    return g->scratch.p && g->scratch.n && g->scratch.v;
+}
+
+// Create a buffer padded to whole texture rows, holding a vec4 per vertex.
+//   The xyz come from a vertex field and the w from an array of weights;
+//   either can be NULL for zeros.
+static GLuint
+createStateBuffer(
+    GpuShape    *g,
+    const float *src,
+    const float *w)
+{
+    int    count = g->rows * GPU_TEX_WIDTH;
+    float  *data = (float*)MALLOC(4 * count * sizeof(float));
+    GLuint buffer;
+    int    i;
+
+    if (!data) return 0;
+    MEMSET(data, 0, 4 * count * sizeof(float));
+    for (i = 0; i < g->shape->numVerts; i++) {
+        if (src) {
+            data[4*i+0] = src[3*i+0];
+            data[4*i+1] = src[3*i+1];
+            data[4*i+2] = src[3*i+2];
+        }
+        if (w) {
+            data[4*i+3] = w[i];
+        }
+    }
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, 4 * count * sizeof(float), data,
+                 GL_DYNAMIC_COPY);
+    FREE(data);
+    return buffer;
+}
+
+// Create a state texture
+static GLuint
+createStateTexture(
+    GpuShape *g)
+{
+    GLuint tex;
+
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, GPU_TEX_WIDTH, g->rows);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return tex;
+}
+
+// Copy one of the current state buffers to a texture
+static void
+updateTexture(
+    GpuShape *g,
+    GLuint   tex,
+    int      which)
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, g->state[g->current][which]);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, GPU_TEX_WIDTH, g->rows,
+                    GL_RGBA, GL_FLOAT, NULL);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+// Upload the static per vertex data
+static int
+createTopology(
+    GpuShape *g)
+{
+    Shape   *b = g->shape;
+    float   *home;
+    GLint   *faces;
+    GpuEdge *edges;
+    int     i, j, c;
+
+    home  = (float*)MALLOC(4 * b->numVerts * sizeof(float));
+    faces = (GLint*)MALLOC(4 * 5 * b->numVerts * sizeof(GLint));
+    edges = (GpuEdge*)MALLOC(b->numColors * b->numVerts * sizeof(GpuEdge));
+    if (!home || !faces || !edges) {
+        FREE(home);
+        FREE(faces);
+        FREE(edges);
+        return 0;
+    }
+
+    // home point and weight, and the faces used for the normal
+    for (i = 0; i < b->numVerts; i++) {
+        GLint *f = faces + 4*5*i;
+        int   count = b->vertFaceStart[i+1] - b->vertFaceStart[i];
+        home[4*i+0] = b->h[3*i+0];
+        home[4*i+1] = b->h[3*i+1];
+        home[4*i+2] = b->h[3*i+2];
+        home[4*i+3] = b->w[3*i];
+        for (j = 0; j < 4*5; j++) {
+            f[j] = -1;
+        }
+        if (count > GPU_MAX_FACES) {
+            NvGlDemoLog("Vertex %d has too many faces for the GPU\n", i);
+            count = GPU_MAX_FACES;
+        }
+        for (j = 0; j < count; j++) {
+            MEMCPY(f + 3*j, b->faces + 3*b->vertFaces[b->vertFaceStart[i]+j],
+                   3 * sizeof(GLint));
+        }
+    }
+
+    // the edge at each end, for each color class
+    for (i = 0; i < b->numColors * b->numVerts; i++) {
+        edges[i].other  = -1;
+        edges[i].second = 0;
+        edges[i].length = 0.0f;
+        edges[i].pad    = 0.0f;
+    }
+    for (c = 0; c < b->numColors; c++) {
+        GpuEdge *ce = edges + c * b->numVerts;
+        for (i = b->colorStart[c]; i < b->colorStart[c+1]; i++) {
+            const Edge *e = b->edges + i;
+            ce[e->v0id].other  = e->v1id;
+            ce[e->v0id].second = 0;
+            ce[e->v0id].length = e->l;
+            ce[e->v1id].other  = e->v0id;
+            ce[e->v1id].second = 1;
+            ce[e->v1id].length = e->l;
+        }
+    }
+
+    glGenBuffers(1, &g->home);
+    glBindBuffer(GL_ARRAY_BUFFER, g->home);
+    glBufferData(GL_ARRAY_BUFFER, 4 * b->numVerts * sizeof(float), home,
+                 GL_STATIC_DRAW);
+    glGenBuffers(1, &g->faces);
+    glBindBuffer(GL_ARRAY_BUFFER, g->faces);
+    glBufferData(GL_ARRAY_BUFFER, 4 * 5 * b->numVerts * sizeof(GLint), faces,
+                 GL_STATIC_DRAW);
+    glGenBuffers(1, &g->edges);
+    glBindBuffer(GL_ARRAY_BUFFER, g->edges);
+    glBufferData(GL_ARRAY_BUFFER,
+                 b->numColors * b->numVerts * sizeof(GpuEdge), edges,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    FREE(home);
+    FREE(faces);
+    FREE(edges);
+    return 1;
+}
+
+// Point the drawing code at the latest state
+static void
+setDrawBuffers(
+    GpuShape *g)
+{
+    g->shape->gpuP = g->state[g->current][GPU_POSITION];
+    g->shape->gpuN = g->state[g->current][GPU_NORMAL];
+}
+
+// Create the GPU copy of a bubble, starting from its current state.
+//   Returns NULL if the GPU path isn't available.
+GpuShape*
+GpuBubble_create(
+    Shape *b)
+{
+    GpuShape *g;
+    float    *scale;
+    GLint    maxSize;
+    int      i, s;
+
+    if (!prog_physics) {
+        NvGlDemoLog("GPU physics needs OpenGL ES 3.0\n");
+        return NULL;
+    }
+
+    g = (GpuShape*)MALLOC(sizeof(GpuShape));
+    if (!g) return NULL;
+    MEMSET(g, 0, sizeof(GpuShape));
+    g->shape = b;
+    g->rows  = (b->numVerts + GPU_TEX_WIDTH - 1) / GPU_TEX_WIDTH;
+    g->drag  = b->drag;
+
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (g->rows > maxSize) {
+        NvGlDemoLog("Bubble too large for GPU physics\n");
+        FREE(g);
+        return NULL;
+    }
+
+    // the edge weight of each vertex rides along in the position's w
+    scale = (float*)MALLOC(b->numVerts * sizeof(float));
+    if (!scale || !allocScratch(g) || !createTopology(g)) {
+        NvGlDemoLog("Could not set up GPU physics\n");
+        FREE(scale);
+        GpuBubble_destroy(g);
+        return NULL;
+    }
+    for (i = 0; i < b->numVerts; i++) {
+        scale[i] = (b->connectedness[i] == 4) ? 1.5f : 1.0f;
+    }
+    for (s = 0; s < 2; s++) {
+        g->state[s][GPU_POSITION] = createStateBuffer(g, b->p, scale);
+        g->state[s][GPU_VELOCITY] = createStateBuffer(g, b->v, NULL);
+        g->state[s][GPU_AVERAGE]  = createStateBuffer(g, NULL, NULL);
+        g->state[s][GPU_NORMAL]   = createStateBuffer(g, b->n, NULL);
+    }
+    FREE(scale);
+    for (s = 0; s < 2; s++) {
+        for (i = 0; i < GPU_NUM_STATES; i++) {
+            if (!g->state[s][i]) {
+                NvGlDemoLog("Could not set up GPU physics\n");
+                GpuBubble_destroy(g);
+                return NULL;
+            }
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    g->positions  = createStateTexture(g);
+    g->velocities = createStateTexture(g);
+    updateTexture(g, g->positions, GPU_POSITION);
+    glGenVertexArrays(1, &g->vao);
+
+    setDrawBuffers(g);
+    return g;
+}
+
+// Free the GPU copy, leaving the bubble to be drawn from its own state
+void
+GpuBubble_destroy(
+    GpuShape *g)
+{
+    int s;
+
+    if (!g) return;
+    if (g->shape->gpuP == g->state[g->current][GPU_POSITION]) {
+        g->shape->gpuP = 0;
+        g->shape->gpuN = 0;
+    }
+    for (s = 0; s < 2; s++) {
+        glDeleteBuffers(GPU_NUM_STATES, g->state[s]);
+    }
+    if (g->home)       glDeleteBuffers(1, &g->home);
+    if (g->faces)      glDeleteBuffers(1, &g->faces);
+    if (g->edges)      glDeleteBuffers(1, &g->edges);
+    if (g->positions)  glDeleteTextures(1, &g->positions);
+    if (g->velocities) glDeleteTextures(1, &g->velocities);
+    if (g->vao)        glDeleteVertexArrays(1, &g->vao);
+    FREE(g->scratch.p);
+    FREE(g->scratch.n);
+    FREE(g->scratch.v);
+    Bubble_freePickGrid(&g->scratch);
+    FREE(g);
+}
+
+// Run one solver pass over all vertices, from the current set of state
+//   buffers to the other one
+static void
+runPass(
+    GpuShape *g,
+    int      stage,
+    int      color)
+{
+    int src = g->current;
+    int dst = 1 - src;
+    int i;
+
+    // the texture updates in between passes disturb the bindings
+    glUniform1i(uloc_physicsStage, stage);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, g->velocities);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, g->positions);
+    for (i = 0; i < GPU_NUM_STATES; i++) {
+        glBindBuffer(GL_ARRAY_BUFFER, g->state[src][i]);
+        glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, 0, NULL);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, i, g->state[dst][i]);
+    }
+    if (stage & GPU_STAGE_EDGES) {
+        GLintptr offset = color * g->shape->numVerts * sizeof(GpuEdge);
+        glBindBuffer(GL_ARRAY_BUFFER, g->edges);
+        glVertexAttribIPointer(10, 2, GL_INT, sizeof(GpuEdge),
+                               (const void*)offset);
+        glVertexAttribPointer(11, 1, GL_FLOAT, GL_FALSE, sizeof(GpuEdge),
+                              (const void*)(offset + 2 * sizeof(GLint)));
+    }
+
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, g->shape->numVerts);
+    glEndTransformFeedback();
+
+    for (i = 0; i < GPU_NUM_STATES; i++) {
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, i, 0);
+    }
+    g->current = dst;
+}
+
+// Advance the bubble by one physics step on the GPU
+void
+GpuBubble_step(
+    GpuShape *g)
+{
+    int c, i;
+
+    g->drag += 0.01f;
+    if (g->drag > g->shape->final_drag)
+    g->drag = g->shape->final_drag;
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glUseProgram(prog_physics);
+    glUniform1f(uloc_physicsDrag, g->drag);
+
+    // static attributes
+    glBindVertexArray(g->vao);
+    for (i = 0; i <= 11; i++) {
+        glEnableVertexAttribArray(i);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, g->home);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 0, NULL);
+    glBindBuffer(GL_ARRAY_BUFFER, g->faces);
+    for (i = 0; i < 5; i++) {
+        glVertexAttribIPointer(5 + i, 4, GL_INT, 4*5*sizeof(GLint),
+                               (const void*)(i * 4 * sizeof(GLint)));
+    }
+    // the edge attributes must be valid in the first pass too
+    glBindBuffer(GL_ARRAY_BUFFER, g->edges);
+    glVertexAttribIPointer(10, 2, GL_INT, sizeof(GpuEdge), NULL);
+    glVertexAttribPointer(11, 1, GL_FLOAT, GL_FALSE, sizeof(GpuEdge),
+                          (const void*)(2 * sizeof(GLint)));
+
+    // normals and home springs, then the edges one color at a time; the
+    //   last color also applies the drag
+    runPass(g, GPU_STAGE_HOME, 0);
+    for (c = 0; c < g->shape->numColors; c++) {
+        int last = (c == g->shape->numColors - 1);
+        updateTexture(g, g->velocities, GPU_VELOCITY);
+        runPass(g, GPU_STAGE_EDGES | (last ? GPU_STAGE_DRAG : 0), c);
+    }
+    updateTexture(g, g->positions, GPU_POSITION);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    setDrawBuffers(g);
+}
+
+// Read a state buffer back into a vertex field
+static void
+readState(
+    GpuShape *g,
+    int      which,
+    float    *dst)
+{
+    const float *src;
+    int         i;
+
+    glBindBuffer(GL_ARRAY_BUFFER, g->state[g->current][which]);
+    src = (const float*)glMapBufferRange(GL_ARRAY_BUFFER, 0,
+                                         4 * g->shape->numVerts
+                                           * sizeof(float),
+                                         GL_MAP_READ_BIT);
+    if (src) {
+        for (i = 0; i < g->shape->numVerts; i++) {
+            dst[3*i+0] = src[4*i+0];
+            dst[3*i+1] = src[4*i+1];
+            dst[3*i+2] = src[4*i+2];
+        }
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Read the positions, normals and velocities back into a bubble, so the
+//   CPU solver can carry on from the GPU state
+void
+GpuBubble_read(
+    GpuShape *g,
+    Shape    *b)
+{
+    readState(g, GPU_POSITION, b->p);
+    readState(g, GPU_NORMAL,   b->n);
+    readState(g, GPU_VELOCITY, b->v);
+    b->drag = g->drag;
+}
+
+// Poke the bubble with a batch of rays. Finding the vertices to poke
+//   needs the state on the CPU, so this reads it back, pokes it there and
+//   uploads the new velocities.
+void
+GpuBubble_pick(
+    GpuShape     *g,
+    int          count,
+    const float3 *e,
+    const float3 *n)
+{
+    GLuint buffer = g->state[g->current][GPU_VELOCITY];
+    float  *dst;
+    int    i;
+
+    GpuBubble_read(g, &g->scratch);
+    g->scratch.grid.valid = 0;
+    Bubble_pickMany(&g->scratch, count, e, n);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    dst = (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0,
+                                   4 * g->shape->numVerts * sizeof(float),
+                                   GL_MAP_WRITE_BIT);
+    if (dst) {
+        for (i = 0; i < g->shape->numVerts; i++) {
+            dst[4*i+0] = g->scratch.v[3*i+0];
+            dst[4*i+1] = g->scratch.v[3*i+1];
+            dst[4*i+2] = g->scratch.v[3*i+2];
+            dst[4*i+3] = 0.0f;
+        }
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Largest difference between the GPU positions and a bubble's
+float
+GpuBubble_compare(
+    GpuShape    *g,
+    const Shape *b)
+{
+    float worst = 0.0f;
+    int   i;
+
+    readState(g, GPU_POSITION, g->scratch.p);
+    for (i = 0; i < 3 * b->numVerts; i++) {
+        float d = g->scratch.p[i] - b->p[i];
+        if (d < 0.0f) d = -d;
+        if (d > worst) worst = d;
+    }
+    return worst;
+}
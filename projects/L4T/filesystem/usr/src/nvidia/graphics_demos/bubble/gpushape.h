@@ -0,0 +1,98 @@
+/*
+ * gpushape.h
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Bubble spring solver running on the GPU with transform feedback
+//
+
+#ifndef __GPUSHAPE_H
+#define __GPUSHAPE_H
+
+#include <GLES3/gl3.h>
+#include "shape.h"
+
+//NOTE: any changes to these must also be made to physics_vert.glslv
+#define GPU_TEX_WIDTH   1024
+#define GPU_STAGE_HOME  1
+#define GPU_STAGE_EDGES 2
+#define GPU_STAGE_DRAG  4
+#define GPU_MAX_FACES   6
+
+// Vertex state buffers, each holding a vec4 per vertex
+enum {
+    GPU_POSITION,
+    GPU_VELOCITY,
+    GPU_AVERAGE,
+    GPU_NORMAL,
+    GPU_NUM_STATES
+};
+
+// GPU copy of a bubble. The vertex state ping-pongs between two sets of
+//   buffers, and the positions and velocities are also copied to textures
+//   so that each vertex can read its neighbors.
+typedef struct {
+    Shape  *shape;                  // Topology, and state when created
+    int    rows;                    // Rows of the state textures
+    int    current;                 // Set holding the latest state
+    float  drag;
+    GLuint state[2][GPU_NUM_STATES];
+    GLuint home;                    // Static per vertex data
+    GLuint faces;
+    GLuint edges;                   // Edge at each vertex for each color
+    GLuint positions;               // State textures
+    GLuint velocities;
+    GLuint vao;
+    Shape  scratch;                 // Read back state, same layout as shape
+} GpuShape;
+
+GpuShape*
+GpuBubble_create(
+    Shape *b);
+
+void
+GpuBubble_destroy(
+    GpuShape *g);
+
+void
+GpuBubble_step(
+    GpuShape *g);
+
+void
+GpuBubble_read(
+    GpuShape *g,
+    Shape    *b);
+
+void
+GpuBubble_pick(
+    GpuShape     *g,
+    int          count,
+    const float3 *e,
+    const float3 *n);
+
+float
+GpuBubble_compare(
+    GpuShape    *g,
+    const Shape *b);
+
+#endif // __GPUSHAPE_H
@@ -28,6 +28,19 @@
 
 #include "nvgldemo.h"
 #include "bubble.h"
+#include "workers.h"
+
+// Default bubble subdivisions
+#define DEFAULT_DEPTH   25
+#define STRESS_DEPTH    256
+#define STRESS_AUTOPOKE 30
+
+// Default physics stepping
+#define DEFAULT_PHYSICS_RATE  60.0f
+#define DEFAULT_PHYSICS_STEPS 4
+
+// Default frame rate once the bubble is at rest and the view is still
+#define DEFAULT_IDLE_RATE     10.0f
 
 // Bubble state info
 static BubbleState bubbleState;
@@ -81,8 +94,18 @@ int main(int argc, char **argv)
 {
     int         failure = 1;
     int         autopoke = 0;
+    int         multipoke = 1;
     int         fpsflag  = 0;
     int         startup  = 0;
+    int         threads  = 1;
+    int         depth    = 0;
+    int         scene    = 0;
+    bool        stress   = false;
+    bool        gpuPhysics = false;
+    bool        gpuVerify  = false;
+    float       physicsRate  = DEFAULT_PHYSICS_RATE;
+    int         physicsSteps = DEFAULT_PHYSICS_STEPS;
+    float       idleRate     = DEFAULT_IDLE_RATE;
     bool        fframeIncrement   = false;
     float       delta             = -1.0f;
 
@@ -100,6 +123,13 @@ int main(int argc, char **argv)
             // No additional action needed
         }
 
+        // Points poked at once by autopoke
+        else if (NvGlDemoArgMatchInt(&argc, argv, 1, "-multipoke",
+                                     "<points>", 1, BUBBLE_MAX_POKES,
+                                     1, &multipoke)) {
+            // No additional action needed
+        }
+
         // FPS output
         else if (NvGlDemoArgMatch(&argc, argv, 1, "-fps")) {
             fpsflag = 1;
@@ -117,6 +147,64 @@ int main(int argc, char **argv)
             // No additional action needed
         }
 
+        // Solver threads
+        else if (NvGlDemoArgMatchInt(&argc, argv, 1, "-threads",
+                                     "<count>", 1, WORKERS_MAX,
+                                     1, &threads)) {
+            // No additional action needed
+        }
+
+        // Bubble subdivision
+        else if (NvGlDemoArgMatchInt(&argc, argv, 1, "-depth",
+                                     "<depth>", 1, MAX_DEPTH,
+                                     1, &depth)) {
+            // No additional action needed
+        }
+
+        // Several bubbles
+        else if (NvGlDemoArgMatchInt(&argc, argv, 1, "-scene",
+                                     "<bubbles>", 1, SCENE_MAX_BUBBLES,
+                                     1, &scene)) {
+            // No additional action needed
+        }
+
+        // Physics steps per second
+        else if (NvGlDemoArgMatchFlt(&argc, argv, 1, "-rate",
+                                     "<steps/sec>", 1.0f, 10000.0f,
+                                     1, &physicsRate)) {
+            // No additional action needed
+        }
+
+        // Most physics steps per frame
+        else if (NvGlDemoArgMatchInt(&argc, argv, 1, "-maxsteps",
+                                     "<steps>", 1, 100,
+                                     1, &physicsSteps)) {
+            // No additional action needed
+        }
+
+        // Frame rate while idle
+        else if (NvGlDemoArgMatchFlt(&argc, argv, 1, "-idlerate",
+                                     "<frames/sec>", 0.0f, 1000.0f,
+                                     1, &idleRate)) {
+            // No additional action needed
+        }
+
+        // Stress mode
+        else if (NvGlDemoArgMatch(&argc, argv, 1, "-stress")) {
+            stress = true;
+        }
+
+        // Spring solver on the GPU
+        else if (NvGlDemoArgMatch(&argc, argv, 1, "-gpuphysics")) {
+            gpuPhysics = true;
+        }
+
+        // GPU solver checked against the CPU one
+        else if (NvGlDemoArgMatch(&argc, argv, 1, "-gpuverify")) {
+            gpuPhysics = true;
+            gpuVerify  = true;
+        }
+
         // Unknown or failure
         else {
             if (!NvGlDemoArgFailed())
@@ -128,6 +216,15 @@ int main(int argc, char **argv)
     // Parsing succeeded
     startup = 1;
 
+    // Stress mode defaults to a bubble of a quarter million vertices,
+    //   kept moving so that the solver never settles
+    if (!depth) {
+        depth = stress ? STRESS_DEPTH : DEFAULT_DEPTH;
+    }
+    if (stress && !autopoke) {
+        autopoke = STRESS_AUTOPOKE;
+    }
+
     // Set up callbacks
     NvGlDemoSetCloseCB(closeCB);
     NvGlDemoSetResizeCB(resizeCB);
@@ -137,10 +234,19 @@ int main(int argc, char **argv)
     NvGlDemoSetButtonCB(buttonCB);
 #endif
 
+    // Start the solver threads
+    if (!Workers_initialize(threads)) {
+        goto done;
+    }
+
     // Initialize bubble state
     if (!BubbleState_init(&bubbleState,
-                      autopoke, demoOptions.duration, fpsflag, fframeIncrement,
-                      delta, demoState.width, demoState.height)) {
+                      autopoke, multipoke,
+                      demoOptions.duration, fpsflag, fframeIncrement,
+                      delta, depth, scene, stress,
+                      physicsRate, physicsSteps, idleRate,
+                      gpuPhysics, gpuVerify,
+                      demoState.width, demoState.height)) {
         goto done;
     }
 
@@ -185,6 +291,7 @@ int main(int argc, char **argv)
 
     // Clean up the bubble resources
     BubbleState_term(&bubbleState);
+    Workers_deinitialize();
 
     // If basic startup failed, print usage message in case it was due
     //   to bad command line arguments.
@@ -192,6 +299,9 @@ int main(int argc, char **argv)
         NvGlDemoLog("Usage: bubble [options]"
                     "  Frequency with which to automatically poke bubble:\n"
                     "    [-autopoke <frames>]\n"
+                    "  Points poked at once by autopoke, spread around"
+                    " the cursor:\n"
+                    "    [-multipoke <points>]\n"
                     "  Turn on framerate logging:\n"
                     "    [-fps]\n"
                     "  To run in Fixed-Frame Increment mode"
@@ -199,7 +309,31 @@ int main(int argc, char **argv)
                     "    [-ff]\n"
                     "  Delta used in Fixed-Frame Increment which defines"
                     " amount of change in scene:\n"
-                    "    [-delta <value>]\n");
+                    "    [-delta <value>]\n"
+                    "  Number of threads sharing the spring solver:\n"
+                    "    [-threads <count>]\n"
+                    "  Bubble subdivision (4*depth*depth+2 vertices):\n"
+                    "    [-depth <depth>]\n"
+                    "  Scene of several bubbles, solved together by the"
+                    " solver threads:\n"
+                    "    [-scene <bubbles>]\n"
+                    "  Large bubble, reporting the time spent in physics,"
+                    " normals and drawing:\n"
+                    "    [-stress]\n"
+                    "  Physics steps per simulated second"
+                    " (independent of the frame rate):\n"
+                    "    [-rate <steps/sec>]\n"
+                    "  Most physics steps run in one frame:\n"
+                    "    [-maxsteps <steps>]\n"
+                    "  Frame rate once the bubble is at rest and the view"
+                    " is still (0 = no limit):\n"
+                    "    [-idlerate <frames/sec>]\n"
+                    "  Solve the springs on the GPU"
+                    " (OpenGL ES 3.0 transform feedback):\n"
+                    "    [-gpuphysics]\n"
+                    "  Solve on both, logging the largest difference"
+                    " between them:\n"
+                    "    [-gpuverify]\n");
         NvGlDemoLog(NvGlDemoArgUsageString());
     }
 
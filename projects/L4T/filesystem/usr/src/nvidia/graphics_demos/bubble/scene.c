@@ -0,0 +1,262 @@
+/*
+ * scene.c
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Scene of several independent bubbles, solved together on the worker pool
+//
+
+#include "nvgldemo.h"
+#include "scene.h"
+#include "workers.h"
+
+// Width of the grid the bubbles are placed on, and the radius of each
+//   bubble as a fraction of its cell
+#define SCENE_WIDTH  2.4f
+#define SCENE_RADIUS 0.4f
+
+// Distance from a bubble's center, in bubble radii, within which a pick
+//   ray is taken to hit it. The bubbles swell a little when poked.
+#define SCENE_PICK_RADIUS 1.1f
+
+// Build the bubbles, with depths[i] the subdivision of bubble i, on a
+//   square grid centered on the origin
+Scene*
+Scene_create(
+    int       count,
+    const int *depths)
+{
+    Scene *s;
+    float cell;
+    int   cols, rows;
+    int   i;
+
+    if ((count < 1) || (count > SCENE_MAX_BUBBLES)) {
+        return NULL;
+    }
+    s = (Scene*)MALLOC(sizeof(Scene));
+    if (!s) {
+        return NULL;
+    }
+    MEMSET(s, 0, sizeof(Scene));
+    s->bubbles = (SceneBubble*)MALLOC(count * sizeof(SceneBubble));
+    if (!s->bubbles) {
+        FREE(s);
+        return NULL;
+    }
+    MEMSET(s->bubbles, 0, count * sizeof(SceneBubble));
+
+    for (cols = 1; cols * cols < count; cols++);
+    rows = (count + cols - 1) / cols;
+    cell = SCENE_WIDTH / (float)cols;
+
+    for (i = 0; i < count; i++) {
+        SceneBubble *sb = &s->bubbles[i];
+        sb->shape = Bubble_create(depths[i]);
+        if (!sb->shape) {
+            Scene_destroy(s);
+            return NULL;
+        }
+        s->numBubbles++;
+        s->numVerts += sb->shape->numVerts;
+        Bubble_calcNormals(sb->shape);
+        Bubble_interpolate(sb->shape, 1.0f);
+
+        sb->center[0] = ((float)(i % cols) - 0.5f * (float)(cols - 1)) * cell;
+        sb->center[1] = (0.5f * (float)(rows - 1) - (float)(i / cols)) * cell;
+        sb->center[2] = 0.0f;
+        sb->radius    = SCENE_RADIUS * cell;
+    }
+
+    return s;
+}
+
+void
+Scene_destroy(
+    Scene *s)
+{
+    int i;
+
+    if (!s) {
+        return;
+    }
+    Scene_finish(s);
+    for (i = 0; i < s->numBubbles; i++) {
+        Bubble_destroy(s->bubbles[i].shape);
+    }
+    FREE(s->bubbles);
+    FREE(s);
+}
+
+// Queue a poke on the nearest bubble hit by a pick ray, from e along n
+//   in scene coordinates. Returns whether any bubble was hit.
+int
+Scene_pick(
+    Scene        *s,
+    const float3 e,
+    const float3 n)
+{
+    SceneBubble *sb;
+    float       nearest = 0.0f;
+    int         closest = -1;
+    int         i;
+
+    for (i = 0; i < s->numBubbles; i++) {
+        float3 t, p;
+        float  along, r;
+
+        sb = &s->bubbles[i];
+        vec_prescribe(t, sb->center);
+        vec_subs(t, e);
+        along = vec_dot(n, t) / vec_dot(n, n);
+        vec_prescribe(p, n);
+        vec_scale(p, along);
+        vec_subs(p, t);
+        r = SCENE_PICK_RADIUS * sb->radius;
+        if ((along > 0.0f) && (vec_dot(p, p) < r * r) &&
+            ((closest < 0) || (along < nearest))) {
+            nearest = along;
+            closest = i;
+        }
+    }
+    if ((closest < 0) || (s->bubbles[closest].numPokes == SCENE_MAX_POKES)) {
+        return 0;
+    }
+
+    // The bubble's shape is a unit bubble at the origin
+    sb = &s->bubbles[closest];
+    vec_prescribe(sb->pokeEye[sb->numPokes], e);
+    vec_subs(sb->pokeEye[sb->numPokes], sb->center);
+    vec_scale(sb->pokeEye[sb->numPokes], 1.0f / sb->radius);
+    vec_prescribe(sb->pokeDir[sb->numPokes], n);
+    sb->numPokes++;
+    return 1;
+}
+
+// Whether a bubble will be skipped by the next job
+static int
+isSkipped(
+    const SceneBubble *sb)
+{
+    return !sb->numPokes && Bubble_isResting(sb->shape);
+}
+
+// Set the drawn state of every bubble a fraction of the way through its
+//   last step, or to the last step of a bubble at rest. Must not be called
+//   while a job is running.
+void
+Scene_interpolate(
+    Scene *s,
+    float t)
+{
+    int i;
+
+    for (i = 0; i < s->numBubbles; i++) {
+        SceneBubble *sb = &s->bubbles[i];
+        Bubble_interpolate(sb->shape, isSkipped(sb) ? 1.0f : t);
+    }
+}
+
+// Apply the queued pokes and run the steps of a range of bubbles. Each
+//   bubble is solved by one thread; its own Workers_run calls run inline.
+static void
+stepBubbles(
+    void *data,
+    int  start,
+    int  end)
+{
+    Scene *s = (Scene*)data;
+    int   i, k;
+
+    for (i = start; i < end; i++) {
+        SceneBubble *sb = &s->bubbles[i];
+        if (isSkipped(sb)) {
+            continue;
+        }
+        if (sb->numPokes) {
+            Bubble_pickMany(sb->shape, sb->numPokes,
+                            (const float3*)sb->pokeEye,
+                            (const float3*)sb->pokeDir);
+            sb->numPokes = 0;
+        }
+        for (k = 0; k < s->steps; k++) {
+            Bubble_step(sb->shape);
+            Bubble_calcNormals(sb->shape);
+        }
+    }
+}
+
+// Start a job that pokes and steps all the bubbles. Only the drawn state
+//   (drawP and drawN) and the GL buffers may be used until Scene_finish,
+//   and pokes must not be queued meanwhile.
+void
+Scene_start(
+    Scene *s,
+    int   steps)
+{
+    int pokes = 0, active = 0;
+    int i;
+
+    Scene_finish(s);
+    for (i = 0; i < s->numBubbles; i++) {
+        SceneBubble *sb = &s->bubbles[i];
+        pokes += sb->numPokes;
+        if (!isSkipped(sb)) {
+            active += sb->shape->numVerts;
+        }
+    }
+    if ((!steps && !pokes) || !active) {
+        return;
+    }
+    s->vertexSteps += (double)active * steps;
+    s->steps   = steps;
+    s->running = 1;
+    Workers_start(stepBubbles, s, s->numBubbles, 1);
+}
+
+// Whether every bubble is at rest, with no pokes waiting. Must not be
+//   called while a job is running.
+int
+Scene_isResting(
+    const Scene *s)
+{
+    int i;
+
+    for (i = 0; i < s->numBubbles; i++) {
+        if (!isSkipped(&s->bubbles[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Wait for the current job, if any
+void
+Scene_finish(
+    Scene *s)
+{
+    if (s->running) {
+        Workers_wait();
+        s->running = 0;
+    }
+}
@@ -0,0 +1,98 @@
+/*
+ * scene.h
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Scene of several independent bubbles, solved together on the worker pool
+//
+// Each bubble is a complete Shape with its own drag and pokes, placed on a
+//   grid in the scene. The steps of a frame are run as one job, a bubble
+//   per item, while the caller draws the results of the previous job.
+//   Bubbles at rest are skipped until they are poked.
+//
+
+#ifndef __SCENE_H
+#define __SCENE_H
+
+#include "algebra.h"
+#include "shape.h"
+
+// Most bubbles in a scene
+#define SCENE_MAX_BUBBLES 64
+
+// Most pokes queued on one bubble between jobs
+#define SCENE_MAX_POKES 10
+
+// One bubble of the scene
+typedef struct {
+    Shape   *shape;
+    float3  center;             // position in the scene
+    float   radius;             // scale of the unit bubble
+    int     numPokes;           // pick rays in bubble coordinates, waiting
+    float3  pokeEye[SCENE_MAX_POKES];   //   for the next job
+    float3  pokeDir[SCENE_MAX_POKES];
+} SceneBubble;
+
+typedef struct {
+    int         numBubbles;
+    SceneBubble *bubbles;
+    int         numVerts;       // vertices in all the bubbles
+    int         steps;          // steps run by the current job
+    int         running;        // a job is in progress
+    double      vertexSteps;    // vertices stepped, summed over the steps
+} Scene;
+
+Scene*
+Scene_create(
+    int       count,
+    const int *depths);
+
+void
+Scene_destroy(
+    Scene *s);
+
+int
+Scene_pick(
+    Scene        *s,
+    const float3 e,
+    const float3 n);
+
+void
+Scene_interpolate(
+    Scene *s,
+    float t);
+
+void
+Scene_start(
+    Scene *s,
+    int   steps);
+
+void
+Scene_finish(
+    Scene *s);
+
+int
+Scene_isResting(
+    const Scene *s);
+
+#endif // __SCENE_H
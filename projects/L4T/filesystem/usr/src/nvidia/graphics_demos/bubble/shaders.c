@@ -27,6 +27,7 @@
 //
 
 #include "nvgldemo.h"
+#include <GLES3/gl3.h>
 #include "shaders.h"
 
 // Depending on compile options, we either build in the shader sources or
@@ -42,6 +43,8 @@ static const char shad_cubeVert[]   = { BUBBLE_PREFIX VERTFILE(envcube_vert) };
 static const char shad_cubeFrag[]   = { BUBBLE_PREFIX FRAGFILE(envcube_frag) };
 static const char shad_mouseVert[]  = { BUBBLE_PREFIX VERTFILE(mouse_vert) };
 static const char shad_mouseFrag[]  = { BUBBLE_PREFIX FRAGFILE(mouse_frag) };
+static const char shad_physicsVert[] = { BUBBLE_PREFIX VERTFILE(physics_vert) };
+static const char shad_physicsFrag[] = { BUBBLE_PREFIX FRAGFILE(physics_frag) };
 #else
 static const char shad_bubbleVert[] = {
 #   include VERTFILE(bubble_vert)
@@ -67,6 +70,12 @@ static const char shad_mouseVert[]  = {
 static const char shad_mouseFrag[]  = {
 #   include FRAGFILE(mouse_frag)
 };
+static const char shad_physicsVert[] = {
+#   include VERTFILE(physics_vert)
+};
+static const char shad_physicsFrag[] = {
+#   include FRAGFILE(physics_frag)
+};
 #endif
 
 static const char bubblePrgBin[] = { PROGFILE(bubble_prog) };
@@ -102,6 +111,64 @@ GLint uloc_mouseWindow;
 GLint uloc_mouseCenter;
 GLint aloc_mouseVertex;
 
+// Transform feedback spring solver
+GLint prog_physics = 0;
+GLint uloc_physicsStage;
+GLint uloc_physicsDrag;
+GLint uloc_physicsPositions;
+GLint uloc_physicsVelocities;
+
+// Load the solver shader, if the context supports it. The outputs to
+//   capture must be named before the program is linked, so it is linked
+//   here rather than by the loader. On failure GPU physics is unavailable.
+static void
+loadPhysicsShader(void)
+{
+    static const char *outputs[] = {
+        "outPosition", "outVelocity", "outAverage", "outNormal"
+    };
+    GLint status;
+
+    if (!NvGlDemoHasGlesVersion(3, 0)) {
+        NvGlDemoLog("OpenGL ES 3.0 unavailable, GPU physics disabled\n");
+        return;
+    }
+
+    prog_physics = LOADSHADER(shad_physicsVert, shad_physicsFrag,
+                              GL_FALSE, GL_FALSE);
+    if (!prog_physics) {
+        NvGlDemoLog("Error occured loading GPU physics shader\n");
+        return;
+    }
+    glTransformFeedbackVaryings(prog_physics, 4, outputs,
+                                GL_SEPARATE_ATTRIBS);
+    glLinkProgram(prog_physics);
+    glGetProgramiv(prog_physics, GL_LINK_STATUS, &status);
+    if (!status) {
+        NvGlDemoLog("Error occured linking GPU physics shader\n");
+        glDeleteProgram(prog_physics);
+        prog_physics = 0;
+        return;
+    }
+
+    uloc_physicsStage      = glGetUniformLocation(prog_physics, "stage");
+    uloc_physicsDrag       = glGetUniformLocation(prog_physics, "drag");
+    uloc_physicsPositions  = glGetUniformLocation(prog_physics, "positions");
+    uloc_physicsVelocities = glGetUniformLocation(prog_physics,
+                                                  "velocities");
+    if ((uloc_physicsStage < 0) || (uloc_physicsDrag < 0)
+        || (uloc_physicsPositions < 0) || (uloc_physicsVelocities < 0)) {
+        NvGlDemoLog("Error occured retrieving GPU physics shader"
+                    " locations\n");
+        glDeleteProgram(prog_physics);
+        prog_physics = 0;
+        return;
+    }
+    glUseProgram(prog_physics);
+    glUniform1i(uloc_physicsPositions, 0);
+    glUniform1i(uloc_physicsVelocities, 1);
+}
+
 int
 LoadShaders(void)
 {
@@ -185,12 +252,16 @@ LoadShaders(void)
         return 0;
     }
 
+    // The GPU solver is optional
+    loadPhysicsShader();
+
     return 1;
 }
 
 void
 FreeShaders(void)
 {
+    if (prog_physics) glDeleteProgram(prog_physics);
     if (prog_mouse)  glDeleteProgram(prog_mouse);
     if (prog_cube)   glDeleteProgram(prog_cube);
     if (prog_mesh)   glDeleteProgram(prog_mesh);
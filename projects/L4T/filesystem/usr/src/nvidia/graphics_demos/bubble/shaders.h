@@ -64,6 +64,13 @@ extern GLint uloc_mouseWindow;
 extern GLint uloc_mouseCenter;
 extern GLint aloc_mouseVertex;
 
+// Transform feedback spring solver, 0 if unavailable
+extern GLint prog_physics;
+extern GLint uloc_physicsStage;
+extern GLint uloc_physicsDrag;
+extern GLint uloc_physicsPositions;
+extern GLint uloc_physicsVelocities;
+
 // Function to load all the shaders
 extern int
 LoadShaders(void);
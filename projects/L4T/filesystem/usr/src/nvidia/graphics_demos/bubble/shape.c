@@ -27,12 +27,232 @@
 //
 
 #include "nvgldemo.h"
+#include <GLES3/gl3.h>
 #include "shape.h"
 #include "shaders.h"
+#include "simd.h"
+#include "workers.h"
 
-// Used to hold 1.0f/n values
-#define ONE_OVER_SIZE 257
-static float OneOver[ONE_OVER_SIZE];
+// Edge force arrays and the face list are rounded up to whole vectors
+#define FORCE_STRIDE(b)  SIMD_ROUND((b)->numEdges)
+#define FACE_STRIDE(b)   SIMD_ROUND((b)->numFaces)
+
+// Minimum items per solver thread, below which a pass isn't split
+#define GRAIN_VECTORS  1024
+#define GRAIN_EDGES    512
+#define GRAIN_FACES    512
+#define GRAIN_VERTICES 512
+
+// Vectors per block of the drag pass, which measures the motion of each
+//   block separately
+#define MOTION_BLOCK   1024
+#define MOTION_BLOCKS(numVerts) \
+    ((SIMD_ROUND(3 * (numVerts)) / SIMD_WIDTH + MOTION_BLOCK - 1) / \
+     MOTION_BLOCK)
+
+// GL type of the strip indices
+#define INDEX_TYPE(b) (((b)->indexSize == 4) ? GL_UNSIGNED_INT \
+                                             : GL_UNSIGNED_SHORT)
+
+// Read or write strip index i
+static int
+getIndex(
+    const Shape *b,
+    const void  *indices,
+    int         i)
+{
+    return (b->indexSize == 4) ? (int)((const GLuint*)indices)[i]
+                               : (int)((const GLushort*)indices)[i];
+}
+
+static void
+setIndex(
+    const Shape *b,
+    void        *indices,
+    int         i,
+    int         vertId)
+{
+    if (b->indexSize == 4) {
+        ((GLuint*)indices)[i] = (GLuint)vertId;
+    } else {
+        ((GLushort*)indices)[i] = (GLushort)vertId;
+    }
+}
+
+// Allocate a zeroed vertex field array, padded to whole vectors. There
+//   is at least one float of padding, so the float3 of any vertex can be
+//   read as a vector.
+static float*
+allocField(
+    int numVerts)
+{
+    int size = SIMD_ROUND(3 * numVerts + 1) * sizeof(float);
+    float *f = (float*)MALLOC(size);
+    if (f) {
+        MEMSET(f, 0, size);
+    }
+    return f;
+}
+
+// Point a vertex attribute at a vertex field, or at the matching vec4
+//   buffer if the GPU solver owns the state
+static void
+setArray(
+    GLuint       loc,
+    unsigned int buffer,
+    const float  *data)
+{
+    if (buffer) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glVertexAttribPointer(loc, 3, GL_FLOAT, GL_FALSE,
+                              4 * sizeof(float), NULL);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    } else {
+        glVertexAttribPointer(loc, 3, GL_FLOAT, GL_FALSE, 0, data);
+    }
+}
+
+// Pack a normal into signed normalized 10:10:10:2. The shader normalizes
+//   the normal anyway, so it is scaled to unit length to keep the most
+//   precision.
+static GLuint
+packNormal(
+    const float *n)
+{
+    float  l = n[0]*n[0] + n[1]*n[1] + n[2]*n[2];
+    float  s = (l > 0.0f) ? 511.0f / SQRT(l) : 0.0f;
+    GLuint packed = 0;
+    int    i;
+
+    for (i = 0; i < 3; i++) {
+        float f = n[i] * s;
+        int   c = (int)((f < 0.0f) ? f - 0.5f : f + 0.5f);
+        packed |= ((GLuint)c & 0x3FF) << (10 * i);
+    }
+    return packed;
+}
+
+// Vertex stream job: where to write the drawn state
+typedef struct {
+    Shape *b;
+    void  *dst;
+} StreamJob;
+
+// Copy the drawn points and normals into a vertex stream. Items are
+//   vertices.
+static void
+streamVertices(
+    void *data,
+    int  start,
+    int  end)
+{
+    StreamJob *job = (StreamJob*)data;
+    Shape     *b   = job->b;
+    float     *dst = (float*)((char*)job->dst + start * b->streamStride);
+    int       i;
+
+    for (i = start; i < end; i++) {
+        dst[0] = b->drawP[3*i+0];
+        dst[1] = b->drawP[3*i+1];
+        dst[2] = b->drawP[3*i+2];
+        if (b->streamPacked) {
+            *(GLuint*)(dst + 3) = packNormal(b->drawN + 3*i);
+            dst += 4;
+        } else {
+            dst[3] = b->drawN[3*i+0];
+            dst[4] = b->drawN[3*i+1];
+            dst[5] = b->drawN[3*i+2];
+            dst += 6;
+        }
+    }
+}
+
+// Fill the next segment of the vertex stream buffer and leave it bound.
+//   Returns the offset of the segment. Without mapping the whole buffer
+//   is respecified instead, which lets the driver orphan the old storage.
+static GLintptr
+streamFill(
+    Shape *b)
+{
+    GLsizeiptr size = (GLsizeiptr)b->numVerts * b->streamStride;
+    GLintptr   offset = 0;
+    StreamJob  job;
+
+    job.b = b;
+    glBindBuffer(GL_ARRAY_BUFFER, b->streamBuffer);
+    if (!b->streamStage) {
+        GLsync fence = (GLsync)b->streamFence[b->streamSegment];
+        if (fence) {
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                    1000000000) == GL_TIMEOUT_EXPIRED);
+            glDeleteSync(fence);
+            b->streamFence[b->streamSegment] = NULL;
+        }
+        offset  = b->streamSegment * size;
+        job.dst = glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+                                   GL_MAP_WRITE_BIT |
+                                   GL_MAP_INVALIDATE_RANGE_BIT |
+                                   GL_MAP_UNSYNCHRONIZED_BIT);
+        if (job.dst) {
+            Workers_run(streamVertices, &job, b->numVerts, GRAIN_VERTICES);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+    } else {
+        job.dst = b->streamStage;
+        Workers_run(streamVertices, &job, b->numVerts, GRAIN_VERTICES);
+        glBufferData(GL_ARRAY_BUFFER, size, b->streamStage, GL_STREAM_DRAW);
+    }
+    return offset;
+}
+
+// Mark the segment just drawn as busy and move on to the next one
+static void
+streamAdvance(
+    Shape *b)
+{
+    if (!b->streamStage) {
+        b->streamFence[b->streamSegment] =
+            (void*)glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        b->streamSegment = (b->streamSegment + 1) % STREAM_SEGMENTS;
+    }
+}
+
+// Point the vertex and normal attributes at the drawn state: the stream
+//   buffer, the GPU solver's buffers, or else client memory. A normal
+//   location below zero means no normals. Returns true if a stream
+//   segment was filled, which must be released with streamAdvance once
+//   the draws using it are issued.
+static int
+setDrawArrays(
+    Shape *b,
+    GLint vertexLoc,
+    GLint normalLoc)
+{
+    const char *base;
+
+    if (!b->streamBuffer || b->gpuP) {
+        setArray(vertexLoc, b->gpuP, b->drawP);
+        if (normalLoc >= 0) {
+            setArray(normalLoc, b->gpuN, b->drawN);
+        }
+        return 0;
+    }
+
+    base = (const char*)streamFill(b);
+    glVertexAttribPointer(vertexLoc, 3, GL_FLOAT, GL_FALSE,
+                          b->streamStride, base);
+    if (normalLoc < 0) {
+        // no normals wanted
+    } else if (b->streamPacked) {
+        glVertexAttribPointer(normalLoc, 4, GL_INT_2_10_10_10_REV, GL_TRUE,
+                              b->streamStride, base + 3*sizeof(float));
+    } else {
+        glVertexAttribPointer(normalLoc, 3, GL_FLOAT, GL_FALSE,
+                              b->streamStride, base + 3*sizeof(float));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return 1;
+}
 
 // Render the bubble as polygons
 void
@@ -41,6 +261,7 @@ Bubble_draw(
     unsigned int cube_texture)
 {
     Tristrip *tstrip = b->tristrips;
+    int      streamed;
     int      i;
 
     glActiveTexture(GL_TEXTURE0);
@@ -48,59 +269,66 @@ Bubble_draw(
 
     glEnableVertexAttribArray(aloc_bubbleVertex);
     glEnableVertexAttribArray(aloc_bubbleNormal);
-    glVertexAttribPointer(aloc_bubbleVertex,
-                          3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          &(b->vertices[0].p[0]));
-    glVertexAttribPointer(aloc_bubbleNormal,
-                          3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          &(b->vertices[0].n[0]));
+    streamed = setDrawArrays(b, aloc_bubbleVertex, aloc_bubbleNormal);
 
-    for (i = 0; i<b->numTristrips; i++, tstrip++) {
-        glDrawElements(GL_TRIANGLE_STRIP,
-                       tstrip->numVerts,
-                       GL_UNSIGNED_SHORT,
-                       tstrip->indices);
+    // the whole bubble in one draw if the strips are stitched together
+    if (b->elementBuffer) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, b->elementBuffer);
+        if (b->restart) glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        glDrawElements(GL_TRIANGLE_STRIP, b->numElements, INDEX_TYPE(b),
+                       NULL);
+        if (b->restart) glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    } else {
+        for (i = 0; i<b->numTristrips; i++, tstrip++) {
+            glDrawElements(GL_TRIANGLE_STRIP,
+                           tstrip->numVerts,
+                           INDEX_TYPE(b),
+                           tstrip->indices);
+        }
+    }
+    if (streamed) {
+        streamAdvance(b);
     }
 
     glDisableVertexAttribArray(aloc_bubbleVertex);
     glDisableVertexAttribArray(aloc_bubbleNormal);
 }
 
+// Render the bubble with one of the prebuilt mesh element buffers, or
+//   from the client copy of its indices if the buffer wasn't created
+static void
+drawMesh(
+    Shape      *b,
+    GLenum     mode,
+    GLuint     buffer,
+    const void *indices,
+    int        count)
+{
+    int streamed;
+
+    if (!buffer && !indices) return;
+    glEnableVertexAttribArray(aloc_meshVertex);
+    streamed = setDrawArrays(b, aloc_meshVertex, -1);
+    if (buffer) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+        glDrawElements(mode, count, INDEX_TYPE(b), NULL);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    } else {
+        glDrawElements(mode, count, INDEX_TYPE(b), indices);
+    }
+    if (streamed) {
+        streamAdvance(b);
+    }
+    glDisableVertexAttribArray(aloc_meshVertex);
+}
+
 // Render the bubble as a mesh
 void
 Bubble_drawEdges(
     Shape *b)
 {
-    Tristrip *tstrip = b->tristrips;
-    unsigned short *edgeIndices;
-    int i, j;
-
-    glEnableVertexAttribArray(aloc_meshVertex);
-    glVertexAttribPointer(aloc_meshVertex,
-                          3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          &(b->vertices[0].p[0]));
-
-    // TODO: Allocating and freeing every time == bad
-    edgeIndices = (unsigned short*)
-        MALLOC((((b->tristrips)->numVerts+1)>>1) * sizeof(unsigned short));
-    for (i = 0; i<b->numTristrips; i++, tstrip++) {
-        // draw the zig-zags
-        glDrawElements(GL_LINE_STRIP,
-                       tstrip->numVerts,
-                       GL_UNSIGNED_SHORT,
-                       tstrip->indices);
-        // draw one "side" of the tristrip (don't need to draw the other
-        // side because our neighboring tristrip will do it)
-        for ( j=0 ; j<tstrip->numVerts ; j+=2 ) {
-            edgeIndices[j>>1] = tstrip->indices[j];
-        }
-        glDrawElements(GL_LINE_STRIP,
-                       (tstrip->numVerts+1)>>1,
-                       GL_UNSIGNED_SHORT,
-                       edgeIndices);
-    }
-    FREE(edgeIndices);
-    glDisableVertexAttribArray(aloc_meshVertex);
+    drawMesh(b, GL_LINES, b->lineBuffer, b->lineIndices, b->numLineElements);
 }
 
 // Render the bubbles as points
@@ -108,31 +336,94 @@ void
 Bubble_drawVertices(
     Shape *b)
 {
-    Tristrip *tstrip = b->tristrips;
-    unsigned short *edgeIndices;
-    int i, j;
+    drawMesh(b, GL_POINTS, b->pointBuffer, b->pointIndices,
+             b->numPointElements);
+}
 
-    glEnableVertexAttribArray(aloc_meshVertex);
-    glVertexAttribPointer(aloc_meshVertex,
-                          3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          &(b->vertices[0].p[0]));
-
-    // TODO: Allocating and freeing every time == bad
-    edgeIndices = (unsigned short*)
-        MALLOC((((b->tristrips)->numVerts+1)>>1)*sizeof(unsigned short));
-    for (i = 0; i < b->numTristrips; i++, tstrip++) {
-        // draw one "side" of the tristrip (don't need to draw the other
-        // side because our neighboring tristrip will do it)
-        for (j = 0; j < tstrip->numVerts; j += 2) {
-            edgeIndices[j>>1] = tstrip->indices[j];
+// Load one corner of SIMD_WIDTH consecutive faces, as x, y and z vectors
+static inline void
+loadCorners(
+    const float *p,
+    const int   *face,
+    vec4        *x,
+    vec4        *y,
+    vec4        *z)
+{
+    vec4 r0 = vec4_load(p + 3*face[0]);
+    vec4 r1 = vec4_load(p + 3*face[3]);
+    vec4 r2 = vec4_load(p + 3*face[6]);
+    vec4 r3 = vec4_load(p + 3*face[9]);
+    vec4_transpose(r0, r1, r2, r3);
+    *x = r0;
+    *y = r1;
+    *z = r2;
+}
+
+// Find the (unnormalized) normal of each face. Items are groups of
+//   SIMD_WIDTH faces; the face list is padded by repeating the last face.
+//   The normals are stored as one vector per face, so that the vertex
+//   pass can add them up with a single load each.
+static void
+faceNormals(
+    void *data,
+    int  start,
+    int  end)
+{
+    Shape *b = (Shape*)data;
+    vec4  zero = vec4_set1(0.0f);
+    int   i;
+
+    for (i = start * SIMD_WIDTH; i < end * SIMD_WIDTH; i += SIMD_WIDTH) {
+        const int *face = b->faces + 3*i;
+        float     *out  = b->faceNormal + SIMD_WIDTH*i;
+        vec4 x0, y0, z0, x1, y1, z1, x2, y2, z2;
+        vec4 ax, ay, az, bx, by, bz, nx, ny, nz, nw;
+
+        loadCorners(b->p, face + 0, &x0, &y0, &z0);
+        loadCorners(b->p, face + 1, &x1, &y1, &z1);
+        loadCorners(b->p, face + 2, &x2, &y2, &z2);
+        ax = vec4_sub(x2, x1);
+        ay = vec4_sub(y2, y1);
+        az = vec4_sub(z2, z1);
+        bx = vec4_sub(x1, x0);
+        by = vec4_sub(y1, y0);
+        bz = vec4_sub(z1, z0);
+        nx = vec4_sub(vec4_mul(ay, bz), vec4_mul(az, by));
+        ny = vec4_sub(vec4_mul(az, bx), vec4_mul(ax, bz));
+        nz = vec4_sub(vec4_mul(ax, by), vec4_mul(ay, bx));
+        nw = zero;
+        vec4_transpose(nx, ny, nz, nw);
+        vec4_store(out + 0*SIMD_WIDTH, nx);
+        vec4_store(out + 1*SIMD_WIDTH, ny);
+        vec4_store(out + 2*SIMD_WIDTH, nz);
+        vec4_store(out + 3*SIMD_WIDTH, nw);
+    }
+}
+
+// Sum the normals of the faces around each vertex. Each vertex only
+//   writes its own normal. Items are vertices.
+static void
+vertexNormals(
+    void *data,
+    int  start,
+    int  end)
+{
+    Shape *b = (Shape*)data;
+    float sum[SIMD_WIDTH];
+    int   i, j;
+
+    for (i = start; i < end; i++) {
+        vec4 n = vec4_set1(0.0f);
+        for (j = b->vertFaceStart[i]; j < b->vertFaceStart[i+1]; j++) {
+            n = vec4_add(n, vec4_load(b->faceNormal +
+                                      SIMD_WIDTH*b->vertFaces[j]));
         }
-        glDrawElements(GL_POINTS,
-                       (tstrip->numVerts+1)>>1,
-                       GL_UNSIGNED_SHORT,
-                       edgeIndices);
+        // a whole vector would spill into the next vertex
+        vec4_store(sum, n);
+        b->n[3*i+0] = sum[0];
+        b->n[3*i+1] = sum[1];
+        b->n[3*i+2] = sum[2];
     }
-    glDisableVertexAttribArray(aloc_meshVertex);
-    FREE(edgeIndices);
 }
 
 // Calculate surface normal at each bubble vertex
@@ -140,48 +431,9 @@ void
 Bubble_calcNormals(
     Shape *b)
 {
-    Vertex **verts;
-    Tristrip *tstrip;
-    int i, j;
-    Vertex *v0, *v1, *v2;
-    float ax, ay, az;
-    float bx, by, bz;
-    float nx, ny, nz;
-
-    for (i=0, tstrip = b->tristrips; i<b->numTristrips; i++, tstrip++) {
-        float sign = 1.0f;
-        verts = tstrip->vertices;
-        v1 = verts[0];
-        v2 = verts[1];
-        ax = v2->p[0] - v1->p[0];
-        ay = v2->p[1] - v1->p[1];
-        az = v2->p[2] - v1->p[2];
-        for (j = 0; j < tstrip->numVerts-2; j++, verts++, sign *= -1.0f) {
-            v0 = v1;
-            v1 = v2;
-            v2 = verts[2];
-            // Copy over the previous vector.  We invert the direction
-            // every other vertex to ping-pong the normal.
-            bx = sign * ax;
-            by = sign * ay;
-            bz = sign * az;
-            ax = v2->p[0] - v1->p[0];
-            ay = v2->p[1] - v1->p[1];
-            az = v2->p[2] - v1->p[2];
-            nx = ay*bz - az*by;
-            ny = az*bx - ax*bz;
-            nz = ax*by - ay*bx;
-            v0->n[0] += nx;
-            v0->n[1] += ny;
-            v0->n[2] += nz;
-            v1->n[0] += nx;
-            v1->n[1] += ny;
-            v1->n[2] += nz;
-            v2->n[0] += nx;
-            v2->n[1] += ny;
-            v2->n[2] += nz;
-        }
-    }
+    Workers_run(faceNormals, b, FACE_STRIDE(b) / SIMD_WIDTH,
+                GRAIN_FACES / SIMD_WIDTH);
+    Workers_run(vertexNormals, b, b->numVerts, GRAIN_VERTICES);
 }
 
 // Add a new vertex at a given latitude/longitude
@@ -191,26 +443,21 @@ MakeNewVertex(
     float latAngle,
     float longAngle)
 {
-    Vertex *vert;
+    float  *p, *h;
     float  cosLat;
 
-    vert = shape->vertices + shape->numVerts++;
+    // velocity and average velocity start out zeroed
+    p = shape->p + 3*shape->numVerts;
+    h = shape->h + 3*shape->numVerts;
+    shape->numVerts++;
     cosLat = (float)COS(latAngle),
-    vert->p[0] = cosLat * (float)COS(longAngle),
-    vert->p[1] = cosLat * (float)SIN(longAngle),
-    vert->p[2] = (float)SIN(latAngle);
+    p[0] = cosLat * (float)COS(longAngle),
+    p[1] = cosLat * (float)SIN(longAngle),
+    p[2] = (float)SIN(latAngle);
     // set home position
-    vert->h[0] = vert->p[0];
-    vert->h[1] = vert->p[1];
-    vert->h[2] = vert->p[2];
-    // zero initial velocity
-    vert->v[0] =
-    vert->v[1] =
-    vert->v[2] = 0.0f;
-    // zero average velocity
-    vert->a[0] =
-    vert->a[1] =
-    vert->a[2] = 0.0f;
+    h[0] = p[0];
+    h[1] = p[1];
+    h[2] = p[2];
 }
 
 // Add a new edge between two vertices
@@ -220,8 +467,8 @@ MakeNewEdge(
     int   vertId0,
     int   vertId1)
 {
-    Vertex *v0 = shape->vertices + vertId0,
-           *v1 = shape->vertices + vertId1;
+    float  *p0 = shape->p + 3*vertId0,
+           *p1 = shape->p + 3*vertId1;
     Edge   *edge;
     float  dx, dy, dz;
 
@@ -229,12 +476,152 @@ MakeNewEdge(
     edge->v0id = vertId0;
     edge->v1id = vertId1;
 
-    dx = v1->p[0] - v0->p[0];
-    dy = v1->p[1] - v0->p[1];
-    dz = v1->p[2] - v0->p[2];
+    dx = p1[0] - p0[0];
+    dy = p1[1] - p0[1];
+    dz = p1[2] - p0[2];
     edge->l = (float)SQRT(dx*dx + dy*dy + dz*dz);
 }
 
+// Add a new face. The corners are ordered so that the normal is
+//   (p2 - p1) x (p1 - p0).
+static void
+MakeNewFace(
+    Shape *shape,
+    int   vertId0,
+    int   vertId1,
+    int   vertId2)
+{
+    int *face = shape->faces + 3*shape->numFaces++;
+    face[0] = vertId0;
+    face[1] = vertId1;
+    face[2] = vertId2;
+}
+
+// Build the list of faces around each vertex, in face order, and pad the
+//   face list to whole vectors
+static int
+LinkFaces(
+    Shape *shape)
+{
+    int *next;
+    int i, j;
+
+    shape->vertFaceStart = (int*)MALLOC((shape->numVerts + 1) * sizeof(int));
+    shape->vertFaces = (int*)MALLOC(3 * shape->numFaces * sizeof(int));
+    next = (int*)MALLOC(shape->numVerts * sizeof(int));
+    if (!shape->vertFaceStart || !shape->vertFaces || !next) {
+        FREE(next);
+        return 0;
+    }
+
+    // the number of faces at each vertex is its connectedness
+    shape->vertFaceStart[0] = 0;
+    for (i = 0; i < shape->numVerts; i++) {
+        shape->vertFaceStart[i+1] =
+            shape->vertFaceStart[i] + shape->connectedness[i];
+        next[i] = shape->vertFaceStart[i];
+    }
+    for (i = 0; i < shape->numFaces; i++) {
+        for (j = 0; j < 3; j++) {
+            shape->vertFaces[next[shape->faces[3*i+j]]++] = i;
+        }
+    }
+    FREE(next);
+
+    for (i = shape->numFaces; i < FACE_STRIDE(shape); i++) {
+        MEMCPY(shape->faces + 3*i, shape->faces + 3*(shape->numFaces - 1),
+               3 * sizeof(int));
+    }
+    return 1;
+}
+
+// Sort the edges into color classes which don't share any vertex, so the
+//   edges of a class can be applied in parallel. Colors are assigned
+//   greedily in edge order and the order within a class is kept, so the
+//   result only depends on the topology.
+static int
+ColorEdges(
+    Shape *shape)
+{
+    unsigned int *used;
+    unsigned char *color;
+    Edge *sorted;
+    int count[MAX_EDGE_COLORS];
+    int i, c;
+
+    used   = (unsigned int*)MALLOC(shape->numVerts * sizeof(unsigned int));
+    color  = (unsigned char*)MALLOC(shape->numEdges);
+    sorted = (Edge*)MALLOC(shape->numEdges * sizeof(Edge));
+    if (!used || !color || !sorted) {
+        FREE(used);
+        FREE(color);
+        FREE(sorted);
+        return 0;
+    }
+    MEMSET(used, 0, shape->numVerts * sizeof(unsigned int));
+    MEMSET(count, 0, sizeof(count));
+
+    // pick the lowest color free at both ends
+    shape->numColors = 0;
+    for (i = 0; i < shape->numEdges; i++) {
+        Edge *edge = shape->edges + i;
+        unsigned int busy = used[edge->v0id] | used[edge->v1id];
+        for (c = 0; (c < MAX_EDGE_COLORS) && (busy & (1U << c)); c++);
+        if (c == MAX_EDGE_COLORS) {
+            NvGlDemoLog("Increase MAX_EDGE_COLORS");
+            FREE(used);
+            FREE(color);
+            FREE(sorted);
+            return 0;
+        }
+        used[edge->v0id] |= 1U << c;
+        used[edge->v1id] |= 1U << c;
+        color[i] = (unsigned char)c;
+        count[c]++;
+        if (c >= shape->numColors) {
+            shape->numColors = c + 1;
+        }
+    }
+
+    // stable counting sort by color
+    shape->colorStart[0] = 0;
+    for (c = 0; c < shape->numColors; c++) {
+        shape->colorStart[c + 1] = shape->colorStart[c] + count[c];
+        count[c] = shape->colorStart[c];
+    }
+    for (i = 0; i < shape->numEdges; i++) {
+        sorted[count[color[i]]++] = shape->edges[i];
+    }
+    MEMCPY(shape->edges, sorted, shape->numEdges * sizeof(Edge));
+
+    FREE(used);
+    FREE(color);
+    FREE(sorted);
+    return 1;
+}
+
+// Poke falloff, 10^-d^2 for a squared distance d^2 from the poked vertex.
+//   It is cut off where it has dropped to 1%, and tabulated over that
+//   range as powers of two.
+#define PICK_RADIUS2    2.0f
+#define PICK_TABLE_SIZE 256
+#define PICK_STRENGTH   0.15f
+#define PICK_LOG2_10    3.321928f
+static float pickFalloff[PICK_TABLE_SIZE + 1];
+
+// Fill the falloff table. Bubbles are only created on the main thread,
+//   so it is filled before any worker can poke one.
+static void
+initPickFalloff(void)
+{
+    int i;
+    if (pickFalloff[0] != 0.0f) return;
+    for (i = 0; i <= PICK_TABLE_SIZE; i++) {
+        float d2 = PICK_RADIUS2 * (float)i / (float)PICK_TABLE_SIZE;
+        pickFalloff[i] = POW(2.0f, -PICK_LOG2_10 * d2);
+    }
+}
+
 // Create a new bubble with a given subdivision level
 Shape*
 Bubble_create(
@@ -244,19 +631,18 @@ Bubble_create(
 #   define EXPECTED_EDGES      (12*depth*depth)
 #   define NUM_TRISTRIPS       ( 4*depth)
 #   define NUM_VERTS_PER_STRIP ( 2*depth + 2)
+#   define EXPECTED_FACES      ( 8*depth*depth)
+#   define VERT_TAB(i, j)      vertTab[(i)*(depth+1) + (j)]
     Shape    *shape;
     int      i, j, quadrant, vertId;
-    int      vertTab[MAX_DEPTH+1][MAX_DEPTH+1];
+    int      *vertTab;
     float    oo_depth = 1.0f/(float)depth;
     int      numCuts, startCol, startRow;
+    int      *strip;
     Tristrip *tstrip;
     // check that we're not overly ambitious
-    if (depth > MAX_DEPTH) {
-        NvGlDemoLog("Increase MAX_DEPTH");
-        return NULL;
-    }
-    if (4*(depth + 1) > ONE_OVER_SIZE-1) {
-        NvGlDemoLog("Increase ONE_OVER_SIZE");
+    if ((depth < 1) || (depth > MAX_DEPTH)) {
+        NvGlDemoLog("Bubble depth must be 1 to %d\n", MAX_DEPTH);
         return NULL;
     }
 
@@ -265,36 +651,67 @@ Bubble_create(
         NvGlDemoLog("out of memory.");
         return NULL;
     }
+    MEMSET(shape, 0, sizeof(Shape));
+    initPickFalloff();
+    shape->depth = depth;
+    shape->indexSize = BUBBLE_NEEDS_UINT_INDICES(depth) ? 4 : 2;
     shape->final_drag = 0.99f;
     shape->initial_drag = 0.7f;
     shape->drag = shape->initial_drag;
 
-    // initialize OneOver table
-    OneOver[0] = 0.0f;
-    for (i = 1; i < ONE_OVER_SIZE; i++) {
-        OneOver[i] = 1.0f/(float)i;
-    }
-
     // allocate all the space we'll use up front
     shape->numVerts = 0;
     shape->numEdges = 0;
-    shape->numTristrips = NUM_TRISTRIPS;
-    shape->vertices  = (Vertex*)   MALLOC(EXPECTED_VERTS * sizeof(Vertex));
-    MEMSET(shape->vertices, 0, EXPECTED_VERTS * sizeof(Vertex));
+    shape->numFaces = 0;
+    shape->p = allocField(EXPECTED_VERTS);
+    shape->n = allocField(EXPECTED_VERTS);
+    shape->v = allocField(EXPECTED_VERTS);
+    shape->h = allocField(EXPECTED_VERTS);
+    shape->a = allocField(EXPECTED_VERTS);
+    shape->w = allocField(EXPECTED_VERTS);
+    shape->prevP = allocField(EXPECTED_VERTS);
+    shape->prevN = allocField(EXPECTED_VERTS);
+    shape->drawP = allocField(EXPECTED_VERTS);
+    shape->drawN = allocField(EXPECTED_VERTS);
+    shape->blockMotion = (float*)
+        MALLOC(2 * MOTION_BLOCKS(EXPECTED_VERTS) * sizeof(float));
+    shape->connectedness = (int*) MALLOC(EXPECTED_VERTS * sizeof(int));
     shape->edges     = (Edge*)     MALLOC(EXPECTED_EDGES * sizeof(Edge));
-    MEMSET(shape->edges, 0, EXPECTED_EDGES * sizeof(Edge));
+    shape->edgeForce = (float*)
+        MALLOC(3 * SIMD_ROUND(EXPECTED_EDGES) * sizeof(float));
+    shape->faces = (int*) MALLOC(3 * SIMD_ROUND(EXPECTED_FACES) * sizeof(int));
+    shape->faceNormal = (float*)
+        MALLOC(SIMD_WIDTH * SIMD_ROUND(EXPECTED_FACES) * sizeof(float));
     shape->tristrips = (Tristrip*) MALLOC(NUM_TRISTRIPS  * sizeof(Tristrip));
+    vertTab = (int*) MALLOC((depth+1) * (depth+1) * sizeof(int));
+    strip   = (int*) MALLOC(NUM_VERTS_PER_STRIP * sizeof(int));
+    if (!shape->p || !shape->n || !shape->v || !shape->h || !shape->a ||
+        !shape->w || !shape->prevP || !shape->prevN || !shape->drawP ||
+        !shape->drawN || !shape->blockMotion || !shape->connectedness ||
+        !shape->edges ||
+        !shape->edgeForce || !shape->faces || !shape->faceNormal ||
+        !shape->tristrips || !vertTab || !strip) {
+        NvGlDemoLog("out of memory.");
+        FREE(vertTab);
+        FREE(strip);
+        Bubble_destroy(shape);
+        return NULL;
+    }
+    MEMSET(shape->connectedness, 0, EXPECTED_VERTS * sizeof(int));
+    MEMSET(shape->edges, 0, EXPECTED_EDGES * sizeof(Edge));
     MEMSET(shape->tristrips, 0, NUM_TRISTRIPS  * sizeof(Tristrip));
+    shape->numTristrips = NUM_TRISTRIPS;
     for (i = 0; i < NUM_TRISTRIPS; i++) {
         shape->tristrips[i].numVerts = NUM_VERTS_PER_STRIP;
-        shape->tristrips[i].vertices = (Vertex**)
-            MALLOC(NUM_VERTS_PER_STRIP * sizeof(Vertex*));
-        MEMSET(shape->tristrips[i].vertices, 0,
-               NUM_VERTS_PER_STRIP * sizeof(Vertex*));
-        shape->tristrips[i].indices  = (unsigned short*)
-            MALLOC(NUM_VERTS_PER_STRIP * sizeof(unsigned short));
-        MEMSET(shape->tristrips[i].indices, 0,
-               NUM_VERTS_PER_STRIP * sizeof(unsigned short));
+        shape->tristrips[i].indices  =
+            MALLOC(NUM_VERTS_PER_STRIP * shape->indexSize);
+        if (!shape->tristrips[i].indices) {
+            NvGlDemoLog("out of memory.");
+            FREE(vertTab);
+            FREE(strip);
+            Bubble_destroy(shape);
+            return NULL;
+        }
     }
 
     // generate all the vertices
@@ -303,7 +720,8 @@ Bubble_create(
         int numCuts = (i <= depth) ? 4*i : 4*(2*depth - i);
         float latAngle = (float)(0.5f * PI * (1.0f - (float)i*oo_depth));
         for (j=0; j < numCuts; j++) {
-            float longAngle = (float)(2.0f * PI * (float)j * OneOver[numCuts]);
+            float longAngle =
+                (float)(2.0f * PI * (float)j * (1.0f/(float)numCuts));
             MakeNewVertex(shape, latAngle, longAngle);
         }
     }
@@ -317,8 +735,8 @@ Bubble_create(
     for (quadrant = 0; quadrant < 4; quadrant++) {
         // generate vertTab, a table of vertex indices used to build
         // edges and tristrips
-        vertTab[0][0] = 0;
-        vertTab[depth][depth] = shape->numVerts-1;
+        VERT_TAB(0, 0) = 0;
+        VERT_TAB(depth, depth) = shape->numVerts-1;
         for (i=1, vertId=1; i<2*depth; i++) {
             if (i <= depth) {
                 numCuts  = 4*i;
@@ -334,10 +752,10 @@ Bubble_create(
                 // back around to the 1st quadrant
                 if ((quadrant == 3) &&
                     ((startCol-j == 0) || (startRow+j == depth))) {
-                    vertTab[startCol-j][startRow+j] =
+                    VERT_TAB(startCol-j, startRow+j) =
                         vertId + j + quadrant*(numCuts>>2) - numCuts;
                 } else {
-                    vertTab[startCol-j][startRow+j] =
+                    VERT_TAB(startCol-j, startRow+j) =
                         vertId + j + quadrant*(numCuts>>2);
                 }
             }
@@ -347,13 +765,13 @@ Bubble_create(
         // "forward slash" edges
         for (i=1; i <= depth; i++) {
             for (j=0; j < depth; j++) {
-                MakeNewEdge(shape, vertTab[i][j], vertTab[i][j+1]);
+                MakeNewEdge(shape, VERT_TAB(i, j), VERT_TAB(i, j+1));
             }
         }
         // "backward slash" edges
         for (j = 0; j < depth; j++) {
             for (i = 0; i < depth; i++) {
-                MakeNewEdge(shape, vertTab[i][j], vertTab[i+1][j]);
+                MakeNewEdge(shape, VERT_TAB(i, j), VERT_TAB(i+1, j));
             }
         }
         // "horizontal" edges
@@ -369,33 +787,52 @@ Bubble_create(
                 startRow = i-depth;
             }
             for ( j=0 ; j<rowEdges ; j++ ) {
-                MakeNewEdge(shape, vertTab[startCol-j]  [startRow+j],
-                    vertTab[startCol-j-1][startRow+j+1]);
+                MakeNewEdge(shape, VERT_TAB(startCol-j, startRow+j),
+                    VERT_TAB(startCol-j-1, startRow+j+1));
             }
         }
         // generate tristrips
         tstrip = shape->tristrips + quadrant * depth;
         for (j = 0; j < depth; j++, tstrip++) {
             for (i = 0; i <= depth; i++) {
-                tstrip->indices[2*i+0] = (unsigned short)vertTab[i][j+1];
-                tstrip->indices[2*i+1] = (unsigned short)vertTab[i][j];
-                tstrip->vertices[2*i+0] = shape->vertices + vertTab[i][j];
-                tstrip->vertices[2*i+1] = shape->vertices + vertTab[i][j+1];
+                setIndex(shape, tstrip->indices, 2*i+0, VERT_TAB(i, j+1));
+                setIndex(shape, tstrip->indices, 2*i+1, VERT_TAB(i, j));
+                strip[2*i+0] = VERT_TAB(i, j);
+                strip[2*i+1] = VERT_TAB(i, j+1);
             }
+            // the winding alternates along the strip
             for (i = 0; i < tstrip->numVerts - 2; i++) {
-            // bump the connectivity count
-                tstrip->vertices[i+0]->connectedness++;
-                tstrip->vertices[i+1]->connectedness++;
-                tstrip->vertices[i+2]->connectedness++;
+                if (i & 1) {
+                    MakeNewFace(shape, strip[i], strip[i+2], strip[i+1]);
+                } else {
+                    MakeNewFace(shape, strip[i], strip[i+1], strip[i+2]);
+                }
+                // bump the connectivity count
+                shape->connectedness[strip[i+0]]++;
+                shape->connectedness[strip[i+1]]++;
+                shape->connectedness[strip[i+2]]++;
             }
         }
     }
+    FREE(vertTab);
+    FREE(strip);
     if (shape->numEdges != EXPECTED_EDGES) {
         NvGlDemoLog("Whoops, wrong number of edges"
                     " (%d observed, %d expected)\n",
                     shape->numEdges,
                     EXPECTED_EDGES);
     }
+    if (!LinkFaces(shape) || !ColorEdges(shape)) {
+        Bubble_destroy(shape);
+        return NULL;
+    }
+
+    // spread the connectivity weights over the vertex components
+    for (i = 0; i < shape->numVerts; i++) {
+        shape->w[3*i+0] =
+        shape->w[3*i+1] =
+        shape->w[3*i+2] = 1.0f / (float)shape->connectedness[i];
+    }
     return shape;
 }
 
@@ -405,18 +842,42 @@ Bubble_destroy(
     Shape *b)
 {
     int i;
-    // check to see if we need to free memory
-    if (b->vertices) {
-        FREE(b->vertices);
-        b->vertices = NULL;
+    // release the GL objects, if they were created
+    if (b->elementBuffer) glDeleteBuffers(1, &b->elementBuffer);
+    if (b->lineBuffer)    glDeleteBuffers(1, &b->lineBuffer);
+    if (b->pointBuffer)   glDeleteBuffers(1, &b->pointBuffer);
+    if (b->streamBuffer)  glDeleteBuffers(1, &b->streamBuffer);
+    for (i = 0; i < STREAM_SEGMENTS; i++) {
+        if (b->streamFence[i]) glDeleteSync((GLsync)b->streamFence[i]);
     }
+    FREE(b->streamStage);
+    FREE(b->lineIndices);
+    FREE(b->pointIndices);
+    Bubble_freePickGrid(b);
+    // check to see if we need to free memory
+    FREE(b->p);
+    FREE(b->n);
+    FREE(b->v);
+    FREE(b->h);
+    FREE(b->a);
+    FREE(b->w);
+    FREE(b->prevP);
+    FREE(b->prevN);
+    FREE(b->drawP);
+    FREE(b->drawN);
+    FREE(b->blockMotion);
+    FREE(b->connectedness);
     if (b->edges) {
         FREE(b->edges);
         b->edges = NULL;
     }
+    FREE(b->edgeForce);
+    FREE(b->faces);
+    FREE(b->faceNormal);
+    FREE(b->vertFaceStart);
+    FREE(b->vertFaces);
     if (b->tristrips) {
         for (i = 0; i < b->numTristrips; i++) {
-            FREE(b->tristrips[i].vertices);
             FREE(b->tristrips[i].indices);
         }
         FREE(b->tristrips);
@@ -425,82 +886,436 @@ Bubble_destroy(
     FREE(b);
 }
 
-// Apply spring forces to update the velocity of each vertex
-void
-Bubble_calcVelocity(
+// Create the wireframe and point element buffers. The wireframe is the
+//   zig-zag of each strip plus one side of it, as separate lines; the
+//   neighboring strip draws the other side. The points are the vertices
+//   on that side. The indices are kept to draw from client memory if
+//   the rest of the buffers can't be created.
+static int
+createMeshBuffers(
     Shape *b)
 {
-    Vertex *vert;
-    Edge *edge;
-    int i;
-    float k1 = 0.005f; // spring home
-    float k2 = 0.6f;   // edge spring
-
-    for (i=0, vert=b->vertices; i<b->numVerts; i++, vert++) {
-        float half_oo_nc = 0.5f * OneOver[vert->connectedness];
-        vert->v[0] += (vert->h[0] - vert->p[0]) * k1 + vert->n[0] * half_oo_nc;
-        vert->v[1] += (vert->h[1] - vert->p[1]) * k1 + vert->n[1] * half_oo_nc;
-        vert->v[2] += (vert->h[2] - vert->p[2]) * k1 + vert->n[2] * half_oo_nc;
-        vert->a[0] =
-        vert->a[1] =
-        vert->a[2] =
-        vert->n[0] =
-        vert->n[1] =
-        vert->n[2] = 0.0f;
-    }
-
-    for (i=0, edge = b->edges; i < b->numEdges; i++, edge++) {
-        Vertex *vert0 = b->vertices + edge->v0id;
-        Vertex *vert1 = b->vertices + edge->v1id;
-        float fx,  fy,  fz;
-        float fLen, scale;
+    void *lines, *points;
+    int  numLines = 0, numPoints = 0;
+    int  i, j;
+
+    for (i = 0; i < b->numTristrips; i++) {
+        int side = (b->tristrips[i].numVerts + 1) >> 1;
+        numLines  += 2 * (b->tristrips[i].numVerts - 1) + 2 * (side - 1);
+        numPoints += side;
+    }
+    lines  = MALLOC(numLines * b->indexSize);
+    points = MALLOC(numPoints * b->indexSize);
+    if (!lines || !points) {
+        FREE(lines);
+        FREE(points);
+        return 0;
+    }
+
+    numLines  = 0;
+    numPoints = 0;
+    for (i = 0; i < b->numTristrips; i++) {
+        const Tristrip *tstrip = b->tristrips + i;
+        for (j = 0; j + 1 < tstrip->numVerts; j++) {
+            setIndex(b, lines, numLines++, getIndex(b, tstrip->indices, j));
+            setIndex(b, lines, numLines++,
+                     getIndex(b, tstrip->indices, j+1));
+        }
+        for (j = 0; j < tstrip->numVerts; j += 2) {
+            if (j > 0) {
+                setIndex(b, lines, numLines++,
+                         getIndex(b, tstrip->indices, j-2));
+                setIndex(b, lines, numLines++,
+                         getIndex(b, tstrip->indices, j));
+            }
+            setIndex(b, points, numPoints++,
+                     getIndex(b, tstrip->indices, j));
+        }
+    }
+
+    b->lineIndices      = lines;
+    b->pointIndices     = points;
+    b->numLineElements  = numLines;
+    b->numPointElements = numPoints;
+    glGenBuffers(1, &b->lineBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, b->lineBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, numLines * b->indexSize, lines,
+                 GL_STATIC_DRAW);
+    glGenBuffers(1, &b->pointBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, b->pointBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, numPoints * b->indexSize, points,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    return 1;
+}
+
+// Create the buffers the bubble is drawn from: the strips stitched into
+//   one element buffer, the wireframe and point element buffers, and a
+//   vertex buffer the drawn state is streamed into each frame. OpenGL ES 3
+//   splits the strips with primitive restart, takes packed normals and
+//   maps the stream a segment at a time. Before that the strips are joined
+//   with degenerate triangles (each strip has an even length, so the
+//   winding is kept) and the stream is copied.
+int
+Bubble_createBuffers(
+    Shape *b,
+    int   gles3)
+{
+    void *indices;
+    int  count = 0;
+    int  i, j;
+
+    if (!createMeshBuffers(b)) return 0;
+
+    b->restart = gles3;
+    for (i = 0; i < b->numTristrips; i++) {
+        count += b->tristrips[i].numVerts;
+    }
+    count += (b->numTristrips - 1) * (gles3 ? 1 : 2);
+    indices = MALLOC(count * b->indexSize);
+    if (!indices) return 0;
+
+    count = 0;
+    for (i = 0; i < b->numTristrips; i++) {
+        const Tristrip *tstrip = b->tristrips + i;
+        if (i > 0) {
+            if (gles3) {
+                setIndex(b, indices, count++,
+                         (b->indexSize == 4) ? (int)0xFFFFFFFF : 0xFFFF);
+            } else {
+                setIndex(b, indices, count, getIndex(b, indices, count-1));
+                count++;
+                setIndex(b, indices, count++,
+                         getIndex(b, tstrip->indices, 0));
+            }
+        }
+        for (j = 0; j < tstrip->numVerts; j++) {
+            setIndex(b, indices, count++, getIndex(b, tstrip->indices, j));
+        }
+    }
+    b->numElements = count;
+    glGenBuffers(1, &b->elementBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, b->elementBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * b->indexSize, indices,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    FREE(indices);
+
+    b->streamPacked  = gles3;
+    b->streamStride  = (gles3 ? 4 : 6) * sizeof(float);
+    b->streamSegment = 0;
+    if (!gles3) {
+        b->streamStage = MALLOC(b->numVerts * b->streamStride);
+        if (!b->streamStage) return 0;
+    }
+    glGenBuffers(1, &b->streamBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, b->streamBuffer);
+    if (gles3) {
+        glBufferData(GL_ARRAY_BUFFER,
+                     STREAM_SEGMENTS * b->numVerts * b->streamStride,
+                     NULL, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return 1;
+}
+
+// Solver constants
+#define K_HOME   0.005f // spring home
+#define K_EDGE   0.6f   // edge spring
+
+// Edge pass job: a range of edges starting at first
+typedef struct {
+    Shape *b;
+    int   first;
+} EdgeJob;
+
+// Pull each vertex home and push it out along its normal. This runs
+//   over the components of all vertices at once, as each component is
+//   treated the same. Items are vectors.
+static void
+pullHome(
+    void *data,
+    int  start,
+    int  end)
+{
+    Shape *b   = (Shape*)data;
+    vec4  vk1  = vec4_set1(K_HOME);
+    vec4  half = vec4_set1(0.5f);
+    vec4  zero = vec4_set1(0.0f);
+    int   i;
+
+    for (i = start * SIMD_WIDTH; i < end * SIMD_WIDTH; i += SIMD_WIDTH) {
+        vec4 p = vec4_load(b->p + i);
+        vec4 h = vec4_load(b->h + i);
+        vec4 n = vec4_load(b->n + i);
+        vec4 w = vec4_load(b->w + i);
+        vec4 v = vec4_load(b->v + i);
+        v = vec4_add(v, vec4_add(vec4_mul(vec4_sub(h, p), vk1),
+                                 vec4_mul(n, vec4_mul(w, half))));
+        vec4_store(b->v + i, v);
+        vec4_store(b->a + i, zero);
+    }
+}
+
+// Find the spring force of each edge. The edge vectors are computed a
+//   vertex at a time and transposed into x, y and z vectors. Items are
+//   groups of SIMD_WIDTH edges, the last group is padded by repeating the
+//   last edge.
+static void
+edgeForces(
+    void *data,
+    int  start,
+    int  end)
+{
+    Shape *b  = (Shape*)data;
+    float *fx = b->edgeForce;
+    float *fy = fx + FORCE_STRIDE(b);
+    float *fz = fy + FORCE_STRIDE(b);
+    vec4  vk2 = vec4_set1(K_EDGE);
+    vec4  one = vec4_set1(1.0f);
+    int   i, j;
+
+    for (i = start * SIMD_WIDTH; i < end * SIMD_WIDTH; i += SIMD_WIDTH) {
+        const Edge *e[SIMD_WIDTH];
+        vec4 x, y, z, w, s;
+
+        for (j = 0; j < SIMD_WIDTH; j++) {
+            e[j] = b->edges + ((i + j < b->numEdges) ? i + j
+                                                     : b->numEdges - 1);
+        }
+        x = vec4_sub(vec4_load(b->p + 3*e[0]->v1id),
+                     vec4_load(b->p + 3*e[0]->v0id));
+        y = vec4_sub(vec4_load(b->p + 3*e[1]->v1id),
+                     vec4_load(b->p + 3*e[1]->v0id));
+        z = vec4_sub(vec4_load(b->p + 3*e[2]->v1id),
+                     vec4_load(b->p + 3*e[2]->v0id));
+        w = vec4_sub(vec4_load(b->p + 3*e[3]->v1id),
+                     vec4_load(b->p + 3*e[3]->v0id));
+        vec4_transpose(x, y, z, w);
+
+        // k2 * (fLen - l) / fLen
+        s = vec4_rsqrt(vec4_add(vec4_add(vec4_mul(x, x), vec4_mul(y, y)),
+                                vec4_mul(z, z)));
+        s = vec4_mul(vk2, vec4_sub(one,
+                                   vec4_mul(vec4_setr(e[0]->l, e[1]->l,
+                                                      e[2]->l, e[3]->l),
+                                            s)));
+        vec4_store(fx + i, vec4_mul(x, s));
+        vec4_store(fy + i, vec4_mul(y, s));
+        vec4_store(fz + i, vec4_mul(z, s));
+    }
+}
+
+// Apply the edge forces to the velocities of their end points. The edges
+//   of a job never share a vertex, so they can be applied in any order.
+static void
+applyForces(
+    void *data,
+    int  start,
+    int  end)
+{
+    EdgeJob *job = (EdgeJob*)data;
+    Shape   *b   = job->b;
+    float   *fx  = b->edgeForce;
+    float   *fy  = fx + FORCE_STRIDE(b);
+    float   *fz  = fy + FORCE_STRIDE(b);
+    int     i;
+
+    for (i = job->first + start; i < job->first + end; i++) {
+        Edge  *edge   = b->edges + i;
+        float *vert0v = b->v + 3*edge->v0id;
+        float *vert1v = b->v + 3*edge->v1id;
+        float *vert0a = b->a + 3*edge->v0id;
+        float *vert1a = b->a + 3*edge->v1id;
+        float x = fx[i], y = fy[i], z = fz[i];
         float v0scale, v1scale;
-        fx = vert1->p[0] - vert0->p[0];
-        fy = vert1->p[1] - vert0->p[1];
-        fz = vert1->p[2] - vert0->p[2];
-        fLen = (float)SQRT(fx*fx + fy*fy + fz*fz);
-        scale = k2 * (fLen - edge->l) / fLen;
         // Check for vertices connected to 4 edges.  Since all but
         // 6 verts are connected to 6 edges, scale up the weight
         // of this edge to make if effectively the same as if the
         // vertex was connected to 6 edges.
-        v1scale = (vert1->connectedness == 4) ? 1.5f * scale : scale;
-        v0scale = (vert0->connectedness == 4) ? 1.5f * scale : scale;
-        vert0->a[0] += (vert1->v[0] -= v1scale * fx);
-        vert0->a[1] += (vert1->v[1] -= v1scale * fy);
-        vert0->a[2] += (vert1->v[2] -= v1scale * fz);
-        vert1->a[0] += (vert0->v[0] += v0scale * fx);
-        vert1->a[1] += (vert0->v[1] += v0scale * fy);
-        vert1->a[2] += (vert0->v[2] += v0scale * fz);
+        v1scale = (b->connectedness[edge->v1id] == 4) ? 1.5f : 1.0f;
+        v0scale = (b->connectedness[edge->v0id] == 4) ? 1.5f : 1.0f;
+        vert0a[0] += (vert1v[0] -= v1scale * x);
+        vert0a[1] += (vert1v[1] -= v1scale * y);
+        vert0a[2] += (vert1v[2] -= v1scale * z);
+        vert1a[0] += (vert0v[0] += v0scale * x);
+        vert1a[1] += (vert0v[1] += v0scale * y);
+        vert1a[2] += (vert0v[2] += v0scale * z);
     }
 }
 
-// Apply drag coefficient to slow each vertex
+// Apply spring forces to update the velocity of each vertex
+void
+Bubble_calcVelocity(
+    Shape *b)
+{
+    EdgeJob job;
+    int     c;
+
+    Workers_run(pullHome, b, SIMD_ROUND(3 * b->numVerts) / SIMD_WIDTH,
+                GRAIN_VECTORS);
+
+    // The positions don't change during this step, so the spring force
+    //   of every edge can be found up front
+    Workers_run(edgeForces, b, (b->numEdges + SIMD_WIDTH - 1) / SIMD_WIDTH,
+                GRAIN_EDGES / SIMD_WIDTH);
+
+    // Each update sees the velocities already changed by the previous
+    //   edges. Going through the edges one color at a time, with a
+    //   barrier in between, keeps that order the same no matter how many
+    //   threads share the work.
+    job.b = b;
+    for (c = 0; c < b->numColors; c++) {
+        job.first = b->colorStart[c];
+        Workers_run(applyForces, &job,
+                    b->colorStart[c + 1] - b->colorStart[c], GRAIN_EDGES);
+    }
+}
+
+// Update positions and apply the drag coefficient, and measure how far
+//   each block of vectors moved. Items are blocks of MOTION_BLOCK vectors.
+static void
+applyDrag(
+    void *data,
+    int  start,
+    int  end)
+{
+    Shape *b     = (Shape*)data;
+    vec4  keep   = vec4_set1(0.9f);
+    vec4  tenth  = vec4_set1(0.1f);
+    vec4  drag   = vec4_set1(b->drag);
+    int   last   = SIMD_ROUND(3 * b->numVerts);
+    float sum[SIMD_WIDTH], most[SIMD_WIDTH];
+    int   i, j, k;
+
+    for (k = start; k < end; k++) {
+        vec4 energy = vec4_set1(0.0f);
+        vec4 move   = vec4_set1(0.0f);
+        int  first  = k * MOTION_BLOCK * SIMD_WIDTH;
+        int  stop   = first + MOTION_BLOCK * SIMD_WIDTH;
+        if (stop > last) stop = last;
+
+        for (i = first; i < stop; i += SIMD_WIDTH) {
+            vec4 w = vec4_load(b->w + i);
+            vec4 v = vec4_add(vec4_mul(vec4_load(b->v + i), keep),
+                              vec4_mul(vec4_load(b->a + i),
+                                       vec4_mul(w, tenth)));
+            vec4 v2 = vec4_mul(v, v);
+            vec4_store(b->p + i, vec4_add(vec4_load(b->p + i), v));
+            vec4_store(b->v + i, vec4_mul(v, drag));
+            energy = vec4_add(energy, v2);
+            move   = vec4_max(move, v2);
+        }
+
+        vec4_store(sum, energy);
+        vec4_store(most, move);
+        for (j = 1; j < SIMD_WIDTH; j++) {
+            sum[0] += sum[j];
+            if (most[j] > most[0]) most[0] = most[j];
+        }
+        b->blockMotion[2*k]     = sum[0];
+        b->blockMotion[2*k + 1] = most[0];
+    }
+}
+
+// Apply drag coefficient to slow each vertex, and check whether the
+//   bubble has come to rest
 void
 Bubble_filterVelocity(
     Shape *b)
 {
-    Vertex *vert;
-    int i;
+    int   blocks = MOTION_BLOCKS(b->numVerts);
+    float energy = 0.0f, move = 0.0f;
+    int   k;
 
     b->drag += 0.01f;
     if (b->drag > b->final_drag)
     b->drag = b->final_drag;
-    for (i=0, vert = b->vertices; i < b->numVerts; i++, vert++) {
-        float tenth_oo_c = 0.1f * OneOver[vert->connectedness];
-        float v0, v1, v2;
-        v0 = (vert->v[0] * 0.9f) + (vert->a[0] * tenth_oo_c);
-        v1 = (vert->v[1] * 0.9f) + (vert->a[1] * tenth_oo_c);
-        v2 = (vert->v[2] * 0.9f) + (vert->a[2] * tenth_oo_c);
-        vert->p[0] += v0;
-        vert->p[1] += v1;
-        vert->p[2] += v2;
-        vert->v[0] = v0 * b->drag;
-        vert->v[1] = v1 * b->drag;
-        vert->v[2] = v2 * b->drag;
+
+    Workers_run(applyDrag, b, blocks, 1);
+
+    // The blocks are added up in order, so the result doesn't depend on
+    //   the number of threads
+    for (k = 0; k < blocks; k++) {
+        energy += b->blockMotion[2*k];
+        if (b->blockMotion[2*k + 1] > move) move = b->blockMotion[2*k + 1];
+    }
+    b->energy  = 0.5f * energy;
+    b->maxMove = SQRT(move);
+    if ((b->maxMove < BUBBLE_REST_MOVE) &&
+        (b->energy < BUBBLE_REST_ENERGY * (float)b->numVerts)) {
+        b->restSteps++;
+    } else {
+        b->restSteps = 0;
+    }
+}
+
+// Whether the bubble has settled, so its steps can be skipped until it is
+//   next poked
+int
+Bubble_isResting(
+    const Shape *b)
+{
+    return b->restSteps >= BUBBLE_REST_STEPS;
+}
+
+// Advance the bubble by one physics step, keeping the positions and
+//   normals it started from. The normals must be recalculated afterwards.
+void
+Bubble_step(
+    Shape *b)
+{
+    int size = SIMD_ROUND(3 * b->numVerts) * sizeof(float);
+    MEMCPY(b->prevP, b->p, size);
+    MEMCPY(b->prevN, b->n, size);
+    b->grid.valid = 0;
+    Bubble_calcVelocity(b);
+    Bubble_filterVelocity(b);
+}
+
+// Blend the previous and current steps into the drawn positions and
+//   normals. Items are vectors.
+static void
+blendSteps(
+    void *data,
+    int  start,
+    int  end)
+{
+    Shape *b = (Shape*)data;
+    vec4  t  = vec4_set1(b->blend);
+    int   i;
+
+    for (i = start * SIMD_WIDTH; i < end * SIMD_WIDTH; i += SIMD_WIDTH) {
+        vec4 p0 = vec4_load(b->prevP + i);
+        vec4 n0 = vec4_load(b->prevN + i);
+        vec4_store(b->drawP + i,
+                   vec4_add(p0, vec4_mul(vec4_sub(vec4_load(b->p + i), p0),
+                                         t)));
+        vec4_store(b->drawN + i,
+                   vec4_add(n0, vec4_mul(vec4_sub(vec4_load(b->n + i), n0),
+                                         t)));
     }
 }
 
+// Set the drawn state to a fraction of the way from the previous physics
+//   step to the current one
+void
+Bubble_interpolate(
+    Shape *b,
+    float t)
+{
+    int size = SIMD_ROUND(3 * b->numVerts) * sizeof(float);
+
+    if (t >= 1.0f) {
+        MEMCPY(b->drawP, b->p, size);
+        MEMCPY(b->drawN, b->n, size);
+        return;
+    }
+    b->blend = t;
+    Workers_run(blendSteps, b, SIMD_ROUND(3 * b->numVerts) / SIMD_WIDTH,
+                GRAIN_VECTORS);
+}
+
 // Compute distance from selection point and vertex
 static float
 Bubble_pickDistance(
@@ -523,42 +1338,310 @@ Bubble_pickDistance(
 }
 
 
-// Identify vertex closest to screen selection point
+// Smallest and largest pick grid resolution
+#define PICK_GRID_MIN 4
+#define PICK_GRID_MAX 64
+
+// Look up the falloff for a squared distance below PICK_RADIUS2
+static float
+lookupFalloff(
+    float d2)
+{
+    float x = d2 * ((float)PICK_TABLE_SIZE / PICK_RADIUS2);
+    int   i = (int)x;
+    return pickFalloff[i] + (pickFalloff[i+1] - pickFalloff[i]) * (x - i);
+}
+
+// Grid cell along one axis of a coordinate, not clamped to the grid
+static int
+gridCoord(
+    const PickGrid *g,
+    float          x,
+    int            axis)
+{
+    float c = (x - g->origin[axis]) * g->scale;
+    return (c < 0.0f) ? (int)c - 1 : (int)c;
+}
+
+static int
+clampCoord(
+    const PickGrid *g,
+    int            c)
+{
+    return (c < 0) ? 0 : ((c >= g->res) ? g->res - 1 : c);
+}
+
+// Free the pick grid
 void
-Bubble_pick(
-    Shape       *b,
+Bubble_freePickGrid(
+    Shape *b)
+{
+    FREE(b->grid.cellStart);
+    FREE(b->grid.cellVerts);
+    FREE(b->grid.usedCells);
+    FREE(b->grid.usedBound);
+    MEMSET(&b->grid, 0, sizeof(PickGrid));
+}
+
+// Sort the vertices into the pick grid, unless it is up to date. The
+//   grid is a cube around the bubble, with a resolution that keeps a few
+//   dozen vertices at most in each cell of the surface.
+static int
+buildPickGrid(
+    Shape *b)
+{
+    PickGrid *g = &b->grid;
+    float    lo[3], hi[3], size;
+    int      cells, i, k;
+
+    if (g->valid) return 1;
+    if (!g->cellStart) {
+        g->res = (int)SQRT((float)b->numVerts) / 4;
+        if (g->res < PICK_GRID_MIN) g->res = PICK_GRID_MIN;
+        if (g->res > PICK_GRID_MAX) g->res = PICK_GRID_MAX;
+        cells = g->res * g->res * g->res;
+        g->cellStart = (int*)MALLOC((cells + 1) * sizeof(int));
+        g->cellVerts = (int*)MALLOC(b->numVerts * sizeof(int));
+        g->usedCells = (int*)MALLOC(b->numVerts * sizeof(int));
+        g->usedBound = (float*)MALLOC(b->numVerts * sizeof(float));
+        if (!g->cellStart || !g->cellVerts || !g->usedCells ||
+            !g->usedBound) {
+            Bubble_freePickGrid(b);
+            return 0;
+        }
+    }
+    cells = g->res * g->res * g->res;
+
+    for (k = 0; k < 3; k++) {
+        lo[k] = hi[k] = b->p[k];
+    }
+    for (i = 1; i < b->numVerts; i++) {
+        for (k = 0; k < 3; k++) {
+            float x = b->p[3*i+k];
+            if (x < lo[k]) lo[k] = x;
+            if (x > hi[k]) hi[k] = x;
+        }
+    }
+    size = hi[0] - lo[0];
+    if (hi[1] - lo[1] > size) size = hi[1] - lo[1];
+    if (hi[2] - lo[2] > size) size = hi[2] - lo[2];
+    if (!(size > 0.0f)) size = 1.0f;
+    g->scale = (float)g->res / (size * 1.001f);
+    MEMCPY(g->origin, lo, sizeof(lo));
+
+    // count the vertices in each cell, then place them from the end of
+    //   each cell's range
+    MEMSET(g->cellStart, 0, (cells + 1) * sizeof(int));
+    for (i = 0; i < b->numVerts; i++) {
+        const float *p = b->p + 3*i;
+        int c = (clampCoord(g, gridCoord(g, p[2], 2)) * g->res
+               + clampCoord(g, gridCoord(g, p[1], 1))) * g->res
+               + clampCoord(g, gridCoord(g, p[0], 0));
+        g->cellStart[c]++;
+    }
+    for (i = 1; i < cells; i++) {
+        g->cellStart[i] += g->cellStart[i-1];
+    }
+    for (i = b->numVerts - 1; i >= 0; i--) {
+        const float *p = b->p + 3*i;
+        int c = (clampCoord(g, gridCoord(g, p[2], 2)) * g->res
+               + clampCoord(g, gridCoord(g, p[1], 1))) * g->res
+               + clampCoord(g, gridCoord(g, p[0], 0));
+        g->cellVerts[--g->cellStart[c]] = i;
+    }
+    g->cellStart[cells] = b->numVerts;
+
+    g->numUsed = 0;
+    for (i = 0; i < cells; i++) {
+        if (g->cellStart[i+1] > g->cellStart[i]) {
+            g->usedCells[g->numUsed++] = i;
+        }
+    }
+    g->valid = 1;
+    return 1;
+}
+
+// Check one vertex against the closest so far
+static void
+pickTest(
+    const Shape  *b,
+    const float3 e,
+    const float3 n,
+    int          i,
+    int          *closest,
+    float        *distance)
+{
+    float3 t, vn;
+    float  d;
+    vec_prescribe(t, b->p + 3*i);
+    vec_prescribe(vn, b->n + 3*i);
+    d = Bubble_pickDistance(e, n, t);
+    if ((d < *distance) && (vec_dot(vn, n) < 0.0f)) {
+        *distance = d;
+        *closest  = i;
+    }
+}
+
+// Search the grid for the vertex closest to a pick ray. The distance from
+//   the ray to a cell's center, less half the cell's diagonal, bounds the
+//   distance to any vertex in it. The cells are searched in widening bands
+//   around the ray until a vertex is found inside the band searched, as no
+//   vertex outside it can be closer.
+static int
+pickNearRay(
+    Shape        *b,
     const float3 e,
     const float3 n)
 {
-    float closest_distance = 1.0e+10;
-    Vertex *vert, *closest = NULL;
+    PickGrid *g = &b->grid;
+    float    h = 1.0f / g->scale;
+    float    distance = 1.0e+10;
+    float    nearest = 1.0e+10, farthest = 0.0f;
+    float    done, band;
+    int      closest = -1;
+    int      i, k;
+
+    for (k = 0; k < g->numUsed; k++) {
+        int    c = g->usedCells[k];
+        float3 center;
+        float  d;
+        center[0] = g->origin[0] + ((float)(c % g->res) + 0.5f) * h;
+        center[1] = g->origin[1] + ((float)(c / g->res % g->res) + 0.5f) * h;
+        center[2] = g->origin[2] + ((float)(c / (g->res * g->res)) + 0.5f) * h;
+        d = SQRT(Bubble_pickDistance(e, n, center)) - 0.8661f * h;
+        if (d < 0.0f) d = 0.0f;
+        g->usedBound[k] = d;
+        if (d < nearest)  nearest  = d;
+        if (d > farthest) farthest = d;
+    }
+
+    done = -1.0f;
+    band = nearest + h;
+    for (;;) {
+        for (k = 0; k < g->numUsed; k++) {
+            int c;
+            if ((g->usedBound[k] <= done) || (g->usedBound[k] > band)) {
+                continue;
+            }
+            c = g->usedCells[k];
+            for (i = g->cellStart[c]; i < g->cellStart[c+1]; i++) {
+                pickTest(b, e, n, g->cellVerts[i], &closest, &distance);
+            }
+        }
+        if (((closest >= 0) && (SQRT(distance) <= band)) ||
+            (band >= farthest)) {
+            return closest;
+        }
+        done = band;
+        band = (closest >= 0) ? SQRT(distance) : 2.0f * band;
+    }
+}
+
+// Identify vertex closest to screen selection point, using the grid if
+//   there is one
+static int
+pickClosest(
+    Shape        *b,
+    const float3 e,
+    const float3 n)
+{
+    float distance = 1.0e+10;
+    int   closest = -1;
+    int   i;
+
+    if (b->grid.valid) {
+        return pickNearRay(b, e, n);
+    }
+    for (i = 0; i < b->numVerts; i++) {
+        pickTest(b, e, n, i, &closest, &distance);
+    }
+    return closest;
+}
+
+// Push one vertex in, by the falloff with its distance from p0
+static void
+pokeVertex(
+    Shape       *b,
+    int         i,
+    const float *p0)
+{
+    float *p1 = b->p + 3*i;
+    float *v1 = b->v + 3*i;
+    float dx = p1[0] - p0[0];
+    float dy = p1[1] - p0[1];
+    float dz = p1[2] - p0[2];
+    float d2 = dx*dx + dy*dy + dz*dz;
+    float s;
+    if (d2 >= PICK_RADIUS2) return;
+    s = lookupFalloff(d2) * PICK_STRENGTH;
+    v1[0] -= p1[0] * s;
+    v1[1] -= p1[1] * s;
+    v1[2] -= p1[2] * s;
+}
+
+// Poke the bubble in around vertex id, visiting only the grid cells
+//   within the falloff radius
+static void
+poke(
+    Shape *b,
+    int   id)
+{
+    PickGrid *g = &b->grid;
+    float3   p0;
+    float    r = SQRT(PICK_RADIUS2);
+    int      lo[3], hi[3];
+    int      i, k, x, y, z;
+
+    vec_prescribe(p0, b->p + 3*id);
+    if (!g->valid) {
+        for (i = 0; i < b->numVerts; i++) {
+            pokeVertex(b, i, p0);
+        }
+        return;
+    }
+    for (k = 0; k < 3; k++) {
+        lo[k] = clampCoord(g, gridCoord(g, p0[k] - r, k));
+        hi[k] = clampCoord(g, gridCoord(g, p0[k] + r, k));
+    }
+    for (z = lo[2]; z <= hi[2]; z++) {
+        for (y = lo[1]; y <= hi[1]; y++) {
+            for (x = lo[0]; x <= hi[0]; x++) {
+                int c = (z * g->res + y) * g->res + x;
+                for (i = g->cellStart[c]; i < g->cellStart[c+1]; i++) {
+                    pokeVertex(b, g->cellVerts[i], p0);
+                }
+            }
+        }
+    }
+}
+
+// Poke the bubble where each of a batch of rays hits it, e.g. one per
+//   touch point. The rays share one grid build.
+void
+Bubble_pickMany(
+    Shape        *b,
+    int          count,
+    const float3 *e,
+    const float3 *n)
+{
     int i;
-    float *p0;
-    float3 t;
-
-    for (i = 0, vert = b->vertices; i < b->numVerts; i++, vert++) {
-        float3 vn;
-        float distance;
-        vec_prescribe(t, vert->p);
-        vec_prescribe(vn, vert->n);
-        distance = Bubble_pickDistance(e, n, t);
-        if ((distance < closest_distance) && (vec_dot(vn, n) < 0.0f)) {
-            closest_distance = distance;
-            closest = vert;
-        }
-    }
-    if (!closest) return;
-    p0 = closest->p;
-    for (i=0, vert = b->vertices; i < b->numVerts; i++, vert++) {
-        float *p1 = vert->p;
-        float s;
-        t[0] = p1[0] - p0[0];
-        t[1] = p1[1] - p0[1];
-        t[2] = p1[2] - p0[2];
-        s = (float)POW(10.0f, t[0]*t[0] + t[1]*t[1] + t[2]*t[2]);
-        s = 1.0f/s;
-        vert->v[0] -= vert->p[0] * s * 0.15f;
-        vert->v[1] -= vert->p[1] * s * 0.15f;
-        vert->v[2] -= vert->p[2] * s * 0.15f;
+
+    b->restSteps = 0;
+    buildPickGrid(b);
+    for (i = 0; i < count; i++) {
+        int closest = pickClosest(b, e[i], n[i]);
+        if (closest >= 0) {
+            poke(b, closest);
+        }
     }
 }
+
+// Poke the bubble where a ray from the screen selection point hits it
+void
+Bubble_pick(
+    Shape        *b,
+    const float3 e,
+    const float3 n)
+{
+    Bubble_pickMany(b, 1, (const float3*)e, (const float3*)n);
+}
@@ -31,41 +31,114 @@
 
 #include "algebra.h"
 
-#define MAX_DEPTH 64
-
-// Bubble vertex description
+// Deepest subdivision accepted. A bubble of depth d has 4*d*d+2 vertices,
+//   so 32-bit indices are needed beyond a depth of 127.
+#define MAX_DEPTH 1024
+#define BUBBLE_NEEDS_UINT_INDICES(depth) (4*(depth)*(depth) + 2 > 65536)
+
+// Most edge colors needed to separate edges sharing a vertex (at most
+//   2*6-1 for a vertex degree of 6)
+#define MAX_EDGE_COLORS 16
+
+// Segments of the vertex stream buffer, so the CPU fills one while the
+//   GPU may still be drawing from the others
+#define STREAM_SEGMENTS 3
+
+// A bubble is at rest after BUBBLE_REST_STEPS steps in a row in which no
+//   vertex coordinate moved by BUBBLE_REST_MOVE, and the mean kinetic
+//   energy per vertex, taking a step's move as the velocity of a unit
+//   mass, was below BUBBLE_REST_ENERGY
+#define BUBBLE_REST_STEPS  30
+#define BUBBLE_REST_MOVE   5.0e-5f
+#define BUBBLE_REST_ENERGY 1.0e-10f
+
+// Uniform grid over the vertices, used to find the vertices near a pick
+//   ray or a poke. It is rebuilt on the first pick after the bubble moves.
 typedef struct {
-    float p[3];  // point
-    float n[3];  // normal
-    float v[3];  // velocity
-    float h[3];  // home
-    float a[3];  // neighborhood velocity for averaging
-    int connectedness; // indicates how many triangles this vertex is
-                       // connected to, as well as how many edges
-} Vertex;
+    int      valid;           // built from the current positions
+    int      res;             // cells along each axis
+    float    origin[3];       // corner of cell 0
+    float    scale;           // cells per unit length
+    int      *cellStart;      // vertices in cell c are cellVerts
+    int      *cellVerts;      //   [cellStart[c]..cellStart[c+1]-1]
+    int      numUsed;         // cells holding any vertices
+    int      *usedCells;
+    float    *usedBound;      // distance from a ray to each used cell
+} PickGrid;
 
 // Bubble edge description
 typedef struct {
-    short v0id;
-    short v1id;
+    int   v0id;
+    int   v1id;
     float l; // length
 } Edge;
 
 // Triangle strip forming part of the bubble
 typedef struct {
     int            numVerts;  // numTris == numVerts-2
-    Vertex         **vertices;
-    unsigned short *indices;
+    void           *indices;  // indexSize bytes each
 } Tristrip;
 
 // Complete bubble description
+//
+// The vertex state is kept as a structure of arrays: each field is a
+//   separate array of numVerts float3s, so the solver passes stream
+//   through just the fields they use, SIMD_WIDTH floats at a time. The
+//   arrays are padded with zeros to a whole number of vectors.
 typedef struct {
+    int      depth;
+    int      indexSize;       // bytes per strip index, 2 or 4
     int      numTristrips;
     Tristrip *tristrips;
     int      numEdges;
     Edge     *edges;
+    float    *edgeForce;      // spring force along each edge, as separate
+                              //   x, y and z arrays
+    int      numColors;       // edges are sorted into color classes,
+    int      colorStart[MAX_EDGE_COLORS+1]; // none sharing a vertex
+    int      numFaces;
+    int      *faces;          // vertex ids of each triangle
+    float    *faceNormal;     // normal of each face, padded to a vector
+    int      *vertFaceStart;  // faces around vertex i are vertFaces
+    int      *vertFaces;      //   [vertFaceStart[i]..vertFaceStart[i+1]-1]
     int      numVerts;
-    Vertex   *vertices;
+    float    *p;              // point
+    float    *n;              // normal
+    float    *v;              // velocity
+    float    *h;              // home
+    float    *a;              // neighborhood velocity for averaging
+    float    *w;              // 1/connectedness, for each component
+    float    *prevP;          // point and normal before the last step
+    float    *prevN;
+    float    *drawP;          // point and normal as drawn, between the
+    float    *drawN;          //   last two steps
+    float    blend;           // fraction of the last step being drawn
+    unsigned int gpuP;        // buffers holding the point and normal as
+    unsigned int gpuN;        //   vec4s, when solved on the GPU, else 0
+    unsigned int elementBuffer;   // all strips stitched together, else 0
+    int          numElements;
+    int          restart;         // strips split by primitive restart,
+                                  //   else joined by degenerate triangles
+    unsigned int lineBuffer;      // wireframe lines and points, else 0
+    int          numLineElements;
+    unsigned int pointBuffer;
+    int          numPointElements;
+    void         *lineIndices;    // client copies of the wireframe lines
+    void         *pointIndices;   //   and points, drawn without buffers
+    unsigned int streamBuffer;    // drawn points and normals, streamed
+    int          streamStride;    //   each frame; 16 bytes per vertex
+    int          streamPacked;    //   with 10:10:10:2 normals, else 24
+    int          streamSegment;   // segment to fill next, when mapped
+    void         *streamFence[STREAM_SEGMENTS]; // GPU done with segment
+    void         *streamStage;    // vertex data, when not mapped
+    int      *connectedness;  // indicates how many triangles each vertex
+                              // is connected to, as well as how many edges
+    PickGrid grid;
+    float    *blockMotion;    // sum and largest of the squared moves in
+                              //   each block of the last step
+    float    energy;          // kinetic energy of the last step
+    float    maxMove;         // largest move of a coordinate in it
+    int      restSteps;       // steps in a row below the rest thresholds
     float    final_drag;
     float    initial_drag;
     float    drag;
@@ -81,6 +154,11 @@ void
 Bubble_destroy(
     Shape *b);
 
+int
+Bubble_createBuffers(
+    Shape *b,
+    int   gles3);
+
 void
 Bubble_draw(
     Shape        *b,
@@ -96,6 +174,17 @@ Bubble_pick(
     const float3 e,
     const float3 n);
 
+void
+Bubble_pickMany(
+    Shape        *b,
+    int          count,
+    const float3 *e,
+    const float3 *n);
+
+void
+Bubble_freePickGrid(
+    Shape *b);
+
 void
 Bubble_calcVelocity(
     Shape *b);
@@ -104,6 +193,19 @@ void
 Bubble_filterVelocity(
     Shape *b);
 
+void
+Bubble_step(
+    Shape *b);
+
+int
+Bubble_isResting(
+    const Shape *b);
+
+void
+Bubble_interpolate(
+    Shape *b,
+    float t);
+
 void
 Bubble_drawVertices(
     Shape *b);
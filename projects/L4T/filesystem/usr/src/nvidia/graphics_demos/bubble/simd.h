@@ -0,0 +1,231 @@
+/*
+ * simd.h
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Minimal 4-wide float vector operations for the bubble solver
+//
+// Maps to SSE on x86 and NEON on ARM, with a plain C fallback. All loads
+//   and stores are unaligned.
+//
+
+#ifndef __SIMD_H
+#define __SIMD_H
+
+#define SIMD_WIDTH 4
+
+// Round a float count up to a whole number of vectors
+#define SIMD_ROUND(n) (((n) + SIMD_WIDTH - 1) & ~(SIMD_WIDTH - 1))
+
+#if defined(__SSE__) || defined(_M_X64)
+
+#include <xmmintrin.h>
+
+typedef __m128 vec4;
+
+#define vec4_load(p)        _mm_loadu_ps(p)
+#define vec4_store(p, a)    _mm_storeu_ps(p, a)
+#define vec4_set1(s)        _mm_set1_ps(s)
+#define vec4_add(a, b)      _mm_add_ps(a, b)
+#define vec4_sub(a, b)      _mm_sub_ps(a, b)
+#define vec4_mul(a, b)      _mm_mul_ps(a, b)
+#define vec4_max(a, b)      _mm_max_ps(a, b)
+#define vec4_setr(a, b, c, d) _mm_setr_ps(a, b, c, d)
+
+// Transpose the 4x4 matrix held in four row vectors
+#define vec4_transpose(r0, r1, r2, r3) _MM_TRANSPOSE4_PS(r0, r1, r2, r3)
+
+// 1/sqrt(a) from the estimate and one Newton-Raphson step
+static inline vec4
+vec4_rsqrt(
+    vec4 a)
+{
+    vec4 r = _mm_rsqrt_ps(a);
+    vec4 t = _mm_mul_ps(_mm_mul_ps(a, r), r);
+    return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), r),
+                      _mm_sub_ps(_mm_set1_ps(3.0f), t));
+}
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+typedef float32x4_t vec4;
+
+#define vec4_load(p)        vld1q_f32(p)
+#define vec4_store(p, a)    vst1q_f32(p, a)
+#define vec4_set1(s)        vdupq_n_f32(s)
+#define vec4_add(a, b)      vaddq_f32(a, b)
+#define vec4_sub(a, b)      vsubq_f32(a, b)
+#define vec4_mul(a, b)      vmulq_f32(a, b)
+#define vec4_max(a, b)      vmaxq_f32(a, b)
+
+static inline vec4
+vec4_setr(
+    float a,
+    float b,
+    float c,
+    float d)
+{
+    const float f[SIMD_WIDTH] = {a, b, c, d};
+    return vld1q_f32(f);
+}
+
+// Transpose the 4x4 matrix held in four row vectors
+#define vec4_transpose(r0, r1, r2, r3)                                   \
+    do {                                                                 \
+        float32x4x2_t t01 = vtrnq_f32(r0, r1);                           \
+        float32x4x2_t t23 = vtrnq_f32(r2, r3);                           \
+        r0 = vcombine_f32(vget_low_f32(t01.val[0]),                      \
+                          vget_low_f32(t23.val[0]));                     \
+        r1 = vcombine_f32(vget_low_f32(t01.val[1]),                      \
+                          vget_low_f32(t23.val[1]));                     \
+        r2 = vcombine_f32(vget_high_f32(t01.val[0]),                     \
+                          vget_high_f32(t23.val[0]));                    \
+        r3 = vcombine_f32(vget_high_f32(t01.val[1]),                     \
+                          vget_high_f32(t23.val[1]));                    \
+    } while (0)
+
+// 1/sqrt(a) from the estimate and two Newton-Raphson steps (the NEON
+//   estimate only has 8 bits)
+static inline vec4
+vec4_rsqrt(
+    vec4 a)
+{
+    vec4 r = vrsqrteq_f32(a);
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+    return r;
+}
+
+#else
+
+#include "nvgldemo.h"
+
+typedef struct {
+    float f[SIMD_WIDTH];
+} vec4;
+
+static inline vec4
+vec4_load(
+    const float *p)
+{
+    vec4 r;
+    MEMCPY(r.f, p, sizeof(r.f));
+    return r;
+}
+
+static inline void
+vec4_store(
+    float *p,
+    vec4  a)
+{
+    MEMCPY(p, a.f, sizeof(a.f));
+}
+
+static inline vec4
+vec4_set1(
+    float s)
+{
+    vec4 r;
+    r.f[0] = r.f[1] = r.f[2] = r.f[3] = s;
+    return r;
+}
+
+static inline vec4
+vec4_setr(
+    float a,
+    float b,
+    float c,
+    float d)
+{
+    vec4 r;
+    r.f[0] = a;
+    r.f[1] = b;
+    r.f[2] = c;
+    r.f[3] = d;
+    return r;
+}
+
+// Transpose the 4x4 matrix held in four row vectors
+#define vec4_transpose(r0, r1, r2, r3)                                   \
+    do {                                                                 \
+        vec4 t0 = r0, t1 = r1, t2 = r2, t3 = r3;                         \
+        r0 = vec4_setr(t0.f[0], t1.f[0], t2.f[0], t3.f[0]);              \
+        r1 = vec4_setr(t0.f[1], t1.f[1], t2.f[1], t3.f[1]);              \
+        r2 = vec4_setr(t0.f[2], t1.f[2], t2.f[2], t3.f[2]);              \
+        r3 = vec4_setr(t0.f[3], t1.f[3], t2.f[3], t3.f[3]);              \
+    } while (0)
+
+static inline vec4
+vec4_add(
+    vec4 a,
+    vec4 b)
+{
+    int i;
+    for (i = 0; i < SIMD_WIDTH; i++) a.f[i] += b.f[i];
+    return a;
+}
+
+static inline vec4
+vec4_sub(
+    vec4 a,
+    vec4 b)
+{
+    int i;
+    for (i = 0; i < SIMD_WIDTH; i++) a.f[i] -= b.f[i];
+    return a;
+}
+
+static inline vec4
+vec4_mul(
+    vec4 a,
+    vec4 b)
+{
+    int i;
+    for (i = 0; i < SIMD_WIDTH; i++) a.f[i] *= b.f[i];
+    return a;
+}
+
+static inline vec4
+vec4_max(
+    vec4 a,
+    vec4 b)
+{
+    int i;
+    for (i = 0; i < SIMD_WIDTH; i++) if (b.f[i] > a.f[i]) a.f[i] = b.f[i];
+    return a;
+}
+
+static inline vec4
+vec4_rsqrt(
+    vec4 a)
+{
+    int i;
+    for (i = 0; i < SIMD_WIDTH; i++) a.f[i] = 1.0f / SQRT(a.f[i]);
+    return a;
+}
+
+#endif
+
+#endif // __SIMD_H
@@ -0,0 +1,209 @@
+/*
+ * workers.c
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Worker thread pool for the bubble solver
+//
+
+#include "nvgldemo.h"
+#include "workers.h"
+
+// Pool state. Thread 0 is the caller of Workers_run.
+static int  numThreads = 1;
+static void *threads[WORKERS_MAX];
+static void *start[WORKERS_MAX];
+static void *done = NULL;
+static int  quit = 0;
+
+// Current job
+static WorkerFunc jobFunc;
+static void       *jobData;
+static int        jobCount;
+static int        jobSlices;
+static int        jobRunning;   // started by Workers_start, not waited for
+
+// Run one slice of the current job
+static void
+runSlice(
+    int slice)
+{
+    int first = (int)((long long)jobCount * slice / jobSlices);
+    int last  = (int)((long long)jobCount * (slice + 1) / jobSlices);
+    if (first < last) {
+        jobFunc(jobData, first, last);
+    }
+}
+
+static void*
+workerMain(
+    void *arg)
+{
+    int slice = (int)(long)arg;
+
+    for (;;) {
+        NvGlDemoSemaphoreWait(start[slice]);
+        if (quit) break;
+        runSlice(slice);
+        NvGlDemoSemaphorePost(done);
+    }
+    return NULL;
+}
+
+// Start count-1 worker threads
+int
+Workers_initialize(
+    int count)
+{
+    int i;
+
+    Workers_deinitialize();
+    if (count < 1) count = 1;
+    if (count > WORKERS_MAX) count = WORKERS_MAX;
+
+    done = NvGlDemoSemaphoreCreate(0, 0);
+    if (!done) return 0;
+
+    quit = 0;
+    for (i = 1; i < count; i++) {
+        start[i] = NvGlDemoSemaphoreCreate(0, 0);
+        if (!start[i]) break;
+        threads[i] = NvGlDemoThreadCreate(workerMain, (void*)(long)i);
+        if (!threads[i]) {
+            NvGlDemoSemaphoreDestroy(start[i]);
+            break;
+        }
+        numThreads = i + 1;
+    }
+
+    if (numThreads < count) {
+        NvGlDemoLog("Only %d of %d solver threads could be started\n",
+                    numThreads, count);
+    }
+    return 1;
+}
+
+// Stop all worker threads
+void
+Workers_deinitialize(void)
+{
+    int i;
+
+    quit = 1;
+    for (i = 1; i < numThreads; i++) {
+        NvGlDemoSemaphorePost(start[i]);
+        NvGlDemoThreadJoin(threads[i], NULL);
+        NvGlDemoSemaphoreDestroy(start[i]);
+    }
+    numThreads = 1;
+    if (done) {
+        NvGlDemoSemaphoreDestroy(done);
+        done = NULL;
+    }
+}
+
+int
+Workers_count(void)
+{
+    return numThreads;
+}
+
+// Number of slices a job is split into
+static int
+countSlices(
+    int count,
+    int grain)
+{
+    int slices = (grain > 0) ? count / grain : count;
+    if (slices > numThreads) slices = numThreads;
+    return (slices < 1) ? 1 : slices;
+}
+
+// Run a job over all threads and wait for it to finish
+void
+Workers_run(
+    WorkerFunc func,
+    void       *data,
+    int        count,
+    int        grain)
+{
+    int slices = countSlices(count, grain);
+    int i;
+
+    if ((slices <= 1) || jobRunning) {
+        if (count > 0) {
+            func(data, 0, count);
+        }
+        return;
+    }
+
+    // The semaphores order these writes before the workers read them
+    jobFunc   = func;
+    jobData   = data;
+    jobCount  = count;
+    jobSlices = slices;
+    for (i = 1; i < slices; i++) {
+        NvGlDemoSemaphorePost(start[i]);
+    }
+    runSlice(0);
+    for (i = 1; i < slices; i++) {
+        NvGlDemoSemaphoreWait(done);
+    }
+}
+
+// Start a job on the worker threads, leaving the first slice for
+//   Workers_wait. Jobs can't be nested.
+void
+Workers_start(
+    WorkerFunc func,
+    void       *data,
+    int        count,
+    int        grain)
+{
+    int i;
+
+    jobFunc    = func;
+    jobData    = data;
+    jobCount   = count;
+    jobSlices  = countSlices(count, grain);
+    jobRunning = 1;
+    for (i = 1; i < jobSlices; i++) {
+        NvGlDemoSemaphorePost(start[i]);
+    }
+}
+
+// Finish the started job, if any
+void
+Workers_wait(void)
+{
+    int i;
+
+    if (!jobRunning) {
+        return;
+    }
+    runSlice(0);
+    for (i = 1; i < jobSlices; i++) {
+        NvGlDemoSemaphoreWait(done);
+    }
+    jobRunning = 0;
+}
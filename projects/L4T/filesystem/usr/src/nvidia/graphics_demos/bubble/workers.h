@@ -0,0 +1,61 @@
+/*
+ * workers.h
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Worker thread pool for the bubble solver
+//
+// Workers_run splits a range of items into contiguous slices, one per
+//   thread, and returns when all slices are done, so consecutive calls
+//   are separated by a barrier. The calling thread works on the first
+//   slice. Slices only depend on the item count, the grain and the
+//   number of threads, never on timing.
+//
+// Workers_start hands a job to the pool without waiting, so the caller
+//   can do other work meanwhile, and Workers_wait runs the first slice and
+//   waits for the rest. Until then the pool is busy, and Workers_run calls
+//   from any thread, including those made by the job itself, run on the
+//   calling thread.
+//
+
+#ifndef __WORKERS_H
+#define __WORKERS_H
+
+#define WORKERS_MAX 16
+
+// Process items [start, end) of a job
+typedef void (*WorkerFunc)(void *data, int start, int end);
+
+// Start/stop the pool. The count includes the calling thread.
+int  Workers_initialize(int count);
+void Workers_deinitialize(void);
+int  Workers_count(void);
+
+// Run func over [0, count), giving each thread at least grain items
+void Workers_run(WorkerFunc func, void *data, int count, int grain);
+
+// Run func over [0, count) in the background, as Workers_run would
+void Workers_start(WorkerFunc func, void *data, int count, int grain);
+void Workers_wait(void);
+
+#endif // __WORKERS_H
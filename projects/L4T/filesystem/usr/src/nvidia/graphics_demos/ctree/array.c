@@ -79,19 +79,50 @@ void
 Array_destroy(
     Array *o)
 {
-    if (o->buffer) { FREE(o->buffer); }
+    if (o->buffSize) { FREE(o->buffer); }
 }
 
 
-// Set the size to zero, but keep the buffer as is.
+// Set the size to zero, but keep the buffer as is. A wrapped buffer is
+//   dropped, as it can't grow.
 void
 Array_clear(
     Array *o)
 {
+    if (!o->buffSize) { o->buffer = NULL; }
     o->elemCount = 0;
 }
 
 
+// Set the size to zero and free the buffer. The array can still be used,
+//   the buffer is allocated again by the next push.
+void
+Array_release(
+    Array *o)
+{
+    if (o->buffSize) { FREE(o->buffer); }
+    o->buffer = NULL;
+    o->buffSize = 0;
+    o->elemCount = 0;
+}
+
+
+// Make the array a read-only view of elements owned by someone else
+//   (a buffer size of zero marks the buffer as not ours). The view stays
+//   in place until the array is cleared or released, and must not be
+//   pushed to.
+void
+Array_wrap(
+    Array      *o,
+    const void *data,
+    int        count)
+{
+    Array_release(o);
+    o->buffer = (void*)data;
+    o->elemCount = count;
+}
+
+
 // Access to the element specified by the index.
 void*
 Array_get(
@@ -44,6 +44,8 @@ void Array_delete(Array *o);
 void Array_init(Array *o, int elemsize);
 void Array_destroy(Array *o);
 void Array_clear(Array *o);
+void Array_release(Array *o);
+void Array_wrap(Array *o, const void *data, int count);
 
 // Access functions
 //   (We can random read the array, but add or delete only the last item.)
@@ -0,0 +1,221 @@
+/*
+ * assetpack.c
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Texture loading from the memory mapped asset pack
+//
+
+#include "nvgldemo.h"
+#include <GLES2/gl2ext.h>
+#include "assetpack.h"
+
+// Size in bytes of a single mip level
+static unsigned int
+levelSize(
+    const AssetPackEntry *e,
+    unsigned int         level)
+{
+    unsigned int w = e->width  >> level;
+    unsigned int h = e->height >> level;
+    return (w ? w : 1) * (h ? h : 1) * e->bpp;
+}
+
+// Map the pack and validate the header and index
+GLboolean
+AssetPack_open(
+    AssetPack  *o,
+    const char *file)
+{
+    unsigned int i, l;
+
+    MEMSET(o, 0, sizeof(AssetPack));
+
+    o->data = (const unsigned char*)NvGlDemoMapFile(file, &o->size);
+    if (!o->data) {
+        NvGlDemoLog("Unable to map asset pack %s\n", file);
+        return GL_FALSE;
+    }
+
+    o->header = (const AssetPackHeader*)o->data;
+    if ((o->size < sizeof(AssetPackHeader)) ||
+        (o->header->magic != ASSETPACK_MAGIC) ||
+        (o->header->version != ASSETPACK_VERSION)) {
+        NvGlDemoLog("Asset pack %s has an unknown format\n", file);
+        goto fail;
+    }
+
+    if (o->header->count >
+        (o->size - sizeof(AssetPackHeader)) / sizeof(AssetPackEntry)) {
+        NvGlDemoLog("Asset pack %s index is truncated\n", file);
+        goto fail;
+    }
+    o->entries = (const AssetPackEntry*)(o->header + 1);
+
+    // Make sure no entry points outside of the file
+    for (i = 0; i < o->header->count; i++) {
+        const AssetPackEntry *e = &o->entries[i];
+        if ((e->levels == 0) || (e->levels > ASSETPACK_MAX_LEVELS) ||
+            ((e->bpp != 3) && (e->bpp != 4))) {
+            NvGlDemoLog("Asset pack %s entry %d is invalid\n", file, i);
+            goto fail;
+        }
+        for (l = 0; l < e->levels; l++) {
+            if ((e->offset[l] > o->size) ||
+                (levelSize(e, l) > o->size - e->offset[l])) {
+                NvGlDemoLog("Asset pack %s entry %d is truncated\n", file, i);
+                goto fail;
+            }
+        }
+    }
+
+    return GL_TRUE;
+
+    fail:
+    AssetPack_close(o);
+    return GL_FALSE;
+}
+
+// Release the mapping
+void
+AssetPack_close(
+    AssetPack *o)
+{
+    NvGlDemoUnmapFile((void*)o->data, o->size);
+    MEMSET(o, 0, sizeof(AssetPack));
+}
+
+// Look up an entry by name
+static const AssetPackEntry*
+findEntry(
+    AssetPack  *o,
+    const char *name)
+{
+    unsigned int i;
+
+    if (!o->data) return NULL;
+
+    for (i = 0; i < o->header->count; i++) {
+        if (!STRNCMP(o->entries[i].name, name, ASSETPACK_NAME_LEN)) {
+            return &o->entries[i];
+        }
+    }
+
+    NvGlDemoLog("Texture %s not found in asset pack\n", name);
+    return NULL;
+}
+
+// Return the level 0 texels of a pack entry
+const unsigned char*
+AssetPack_getImage(
+    AssetPack    *o,
+    const char   *name,
+    int          *width,
+    int          *height,
+    int          *bpp)
+{
+    const AssetPackEntry *e = findEntry(o, name);
+
+    if (!e) return NULL;
+
+    *width  = e->width;
+    *height = e->height;
+    *bpp    = e->bpp;
+    return o->data + e->offset[0];
+}
+
+// Create a texture from a pack entry
+GLuint
+AssetPack_loadTexture(
+    AssetPack  *o,
+    const char *name)
+{
+    const AssetPackEntry *e = findEntry(o, name);
+    unsigned int l, levels;
+    GLenum format, sformat;
+    GLboolean pot, immutable;
+    const char* glExtensions;
+    GLuint id;
+
+    if (!e) return 0;
+
+    format  = (e->bpp == 4) ? GL_RGBA  : GL_RGB;
+    sformat = (e->bpp == 4) ? GL_RGBA8 : GL_RGB8;
+    pot     = ((e->width  & (e->width  - 1)) == 0) &&
+              ((e->height & (e->height - 1)) == 0);
+    levels  = 1 + (unsigned int)floor(log2(fmax(e->width, e->height)));
+
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    if (demoOptions.isProtected) {
+        glExtensions = (const char *) glGetString(GL_EXTENSIONS);
+        if (!STRSTR(glExtensions, "GL_EXT_protected_textures")) {
+            NvGlDemoLog("Protected Textures not supported\n");
+            glDeleteTextures(1, &id);
+            return 0;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_PROTECTED_EXT, GL_TRUE);
+    }
+
+    // Upload straight from the mapping. Small mip levels of RGB textures
+    //   have rows which are not 4 byte aligned. Without OpenGL ES 3 there
+    //   is no immutable storage, and non power of two textures can only
+    //   have the base level.
+    immutable = NvGlDemoHasGlesVersion(3, 0);
+    if (!immutable && !pot) {
+        levels = 1;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (immutable) {
+        glTexStorage2D(GL_TEXTURE_2D, levels, sformat, e->width, e->height);
+    }
+    for (l = 0; l < e->levels && l < levels; l++) {
+        GLsizei w = e->width  >> l;
+        GLsizei h = e->height >> l;
+        if (immutable) {
+            glTexSubImage2D(GL_TEXTURE_2D, l, 0, 0, w ? w : 1, h ? h : 1,
+                            format, GL_UNSIGNED_BYTE, o->data + e->offset[l]);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, l, format, w ? w : 1, h ? h : 1, 0,
+                         format, GL_UNSIGNED_BYTE, o->data + e->offset[l]);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Same sampling state as NvGlDemoLoadTgaFromBuffer
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (pot) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                        GL_LINEAR_MIPMAP_LINEAR);
+        // Only build the chain on the GPU if the pack did not supply it
+        if (e->levels < levels) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+    } else {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    }
+
+    return id;
+}
@@ -0,0 +1,99 @@
+/*
+ * assetpack.h
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Packed texture file, mapped read-only at startup
+//
+// The pack holds every ctree texture as raw RGB/RGBA texels (already
+//   swizzled from the TGA BGR order), optionally followed by the
+//   precomputed mip chain. Each texture starts on its own page so that
+//   only the textures actually uploaded (e.g. the -smalltex set) are
+//   faulted in, and the pages are shared between all running instances.
+//
+// Layout (little endian):
+//   AssetPackHeader
+//   AssetPackEntry[count]
+//   texel data, each texture aligned to ASSETPACK_ALIGNMENT and each
+//   mip level within it aligned to ASSETPACK_LEVEL_ALIGNMENT
+//
+
+#ifndef __ASSETPACK_H
+#define __ASSETPACK_H
+
+#include <stdint.h>
+
+#define ASSETPACK_MAGIC           0x4b505443 // "CTPK"
+#define ASSETPACK_VERSION         1
+#define ASSETPACK_NAME_LEN        32
+#define ASSETPACK_MAX_LEVELS      16
+#define ASSETPACK_ALIGNMENT       4096
+#define ASSETPACK_LEVEL_ALIGNMENT 16
+
+// Default pack file name
+#define ASSETPACK_FILE "ctree.pak"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;     // Number of entries following the header
+    uint32_t reserved;
+} AssetPackHeader;
+
+typedef struct {
+    char     name[ASSETPACK_NAME_LEN];   // Texture name (TGA basename)
+    uint32_t width;
+    uint32_t height;
+    uint32_t bpp;                        // Bytes per texel (3 or 4)
+    uint32_t levels;                     // Number of stored mip levels
+    uint32_t offset[ASSETPACK_MAX_LEVELS]; // File offset of each level
+} AssetPackEntry;
+
+// The reader side is not needed by the host packing tool
+#ifndef ASSETPACK_FORMAT_ONLY
+
+#include <GLES2/gl2.h>
+
+typedef struct {
+    const unsigned char   *data;
+    unsigned int          size;
+    const AssetPackHeader *header;
+    const AssetPackEntry  *entries;
+} AssetPack;
+
+// Initialization and clean-up
+GLboolean AssetPack_open(AssetPack *o, const char *file);
+void      AssetPack_close(AssetPack *o);
+
+// Create a 2D texture from the named entry, returns 0 on failure.
+//   The texture is left bound to the current texture unit.
+GLuint    AssetPack_loadTexture(AssetPack *o, const char *name);
+
+// Return the level 0 texels of the named entry, or NULL on failure.
+//   The data is only valid until the pack is closed.
+const unsigned char* AssetPack_getImage(AssetPack *o, const char *name,
+                                        int *width, int *height, int *bpp);
+
+#endif // ASSETPACK_FORMAT_ONLY
+
+#endif // __ASSETPACK_H
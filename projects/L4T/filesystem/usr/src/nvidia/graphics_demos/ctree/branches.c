@@ -32,6 +32,7 @@
 #include "array.h"
 #include "vbo.h"
 #include "shaders.h"
+#include "meshcache.h"
 
 // Precomputed cos/sin values for facets of branch cylinder
 static float2 trig[BRANCHES_FACETS + 1];
@@ -47,9 +48,40 @@ static unsigned long VBOvertices;
 static unsigned long VBOnormals;
 static unsigned long VBOtexcoords;
 
+// Number of strip indices and segment records. These remain valid after
+//   the CPU copies are released.
+static int indexCount;
+static int segmentCount;
+
+// In GPU resident mode the strips are kept in an element buffer,
+//   separated by the primitive restart index
+static GLuint elementBuffer = 0;
+static int    elementCount  = 0;
+
 // Branch texture
 static GLuint texture;
 
+// Compact per segment record used when the cylinders are expanded on the
+//   GPU. The segment transform is a uniform scale, rotation and
+//   translation, so its third row is recovered in the shader as the
+//   cross product of the first two.
+typedef struct {
+    float4 xaxis;       // Row 0 of the transform, taper in w
+    float4 yaxis;       // Row 1 of the transform, texcoord Y in w
+    float4 origin;      // Row 3 of the transform, parent index in w
+} Segment;
+
+// GPU expansion state
+static Array     segments;
+static GLuint    segmentTexture;
+static GLboolean gpuExpand = GL_FALSE;
+static int       gpuFacets = BRANCHES_FACETS;
+
+// Branch arrays in mesh cache stream order
+static Array *const streamArrays[] = {
+    &vertices, &normals, &texcoords, &indices, &segments
+};
+
 // Initialize branch data structures
 void
 Branches_initialize(
@@ -61,8 +93,10 @@ Branches_initialize(
     Array_init(&normals, sizeof(float3));
     Array_init(&texcoords, sizeof(float2));
     Array_init(&indices, sizeof(unsigned int));
+    Array_init(&segments, sizeof(Segment));
 
     texture = t;
+    segmentTexture = 0;
 
     if (useVBO) {
         VBOvertices = 0;
@@ -84,6 +118,17 @@ Branches_deinitialize(void)
     Array_destroy(&normals);
     Array_destroy(&texcoords);
     Array_destroy(&indices);
+    Array_destroy(&segments);
+
+    if (segmentTexture) {
+        glDeleteTextures(1, &segmentTexture);
+        segmentTexture = 0;
+    }
+    if (elementBuffer) {
+        glDeleteBuffers(1, &elementBuffer);
+        elementBuffer = 0;
+    }
+    elementCount = 0;
 }
 
 // Reset branch data
@@ -94,6 +139,19 @@ Branches_clear(void)
     Array_clear(&normals);
     Array_clear(&texcoords);
     Array_clear(&indices);
+    Array_clear(&segments);
+    indexCount = segmentCount = elementCount = 0;
+}
+
+// Free the CPU copies of the branch data once they are on the GPU
+void
+Branches_release(void)
+{
+    Array_release(&vertices);
+    Array_release(&normals);
+    Array_release(&texcoords);
+    Array_release(&indices);
+    Array_release(&segments);
 }
 
 // Add branch vertex
@@ -120,6 +178,30 @@ Branches_addIndex(
    unsigned int i)
 {
    Array_push(&indices, &i);
+   indexCount++;
+}
+
+// Draw all branches from the segment records. Each segment is drawn as
+//   two instances: its body and the joint down to its parent (or the
+//   stump for the trunk).
+static void
+drawSegments(void)
+{
+    if (!segmentCount) return;
+
+    glUseProgram(prog_branches);
+    glUniform1i(uloc_branchesFacets, gpuFacets);
+    glUniform1f(uloc_branchesRadius, treeParams[TREE_PARAM_BRANCH_SIZE]);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, segmentTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, (gpuFacets + 1) * 2,
+                          segmentCount * 2);
 }
 
 // Draw all branches
@@ -129,6 +211,11 @@ Branches_draw(
 {
     int i, size, stride;
 
+    if (gpuExpand) {
+        drawSegments();
+        return;
+    }
+
     glUseProgram(prog_solids);
 
     glVertexAttrib3f(aloc_solidsColor, 1.0,1.0,1.0);
@@ -154,7 +241,7 @@ Branches_draw(
 
     }
 
-    size = indices.elemCount;
+    size = indexCount;
     stride = (BRANCHES_FACETS + 1) * 2;
     ASSERT(size % stride == 0);
 
@@ -162,9 +249,19 @@ Branches_draw(
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
 
-    for (i=0; i<size; i+=stride) {
-        glDrawElements(GL_TRIANGLE_STRIP, stride, GL_UNSIGNED_INT,
-                       Array_get(&indices, i));
+    if (useVBO && elementCount) {
+        // All strips at once from the element buffer
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+        glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        glDrawElements(GL_TRIANGLE_STRIP, elementCount, GL_UNSIGNED_INT,
+                       (void*)0);
+        glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    } else {
+        for (i=0; i<size; i+=stride) {
+            glDrawElements(GL_TRIANGLE_STRIP, stride, GL_UNSIGNED_INT,
+                           Array_get(&indices, i));
+        }
     }
 
     if (useVBO) {
@@ -181,7 +278,10 @@ int
 Branches_polyCount(void)
 {
     int stride = (BRANCHES_FACETS+1)*2;
-    int cylCount = indices.elemCount/stride;
+    int cylCount = indexCount/stride;
+    if (gpuExpand) {
+        return segmentCount * 2 * gpuFacets * 2;
+    }
     return cylCount * BRANCHES_FACETS * 2;
 }
 
@@ -190,10 +290,43 @@ int
 Branches_branchCount(void)
 {
     int stride = (BRANCHES_FACETS+1)*2;
-    int cylCount = indices.elemCount/stride;
+    int cylCount = indexCount/stride;
+    if (gpuExpand) {
+        return segmentCount;
+    }
     return (cylCount+1) / 2;
 }
 
+// Write the branch strips from the CPU index list to an element buffer
+static int
+fillRestartElements(
+    GLuint buffer)
+{
+    int stride = (BRANCHES_FACETS + 1) * 2;
+    int strips = indices.elemCount / stride;
+    int count  = strips * (stride + 1);
+    GLuint *data, *d;
+    int i;
+
+    d = data = (GLuint*)MALLOC(count * sizeof(GLuint));
+    if (!data) return 0;
+
+    for (i = 0; i < indices.elemCount; i++) {
+        *d++ = *(unsigned int*)Array_get(&indices, i);
+        if ((i % stride) == stride - 1) {
+            *d++ = 0xffffffff;
+        }
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLuint), data,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    FREE(data);
+    return count;
+}
+
 // Construct VBOs
 void
 Branches_buildVBO(void)
@@ -207,13 +340,19 @@ Branches_buildVBO(void)
     VBOnormals   = VBO_alloc(v * 3 * sizeof(float));
     VBOtexcoords = VBO_alloc(v * 2 * sizeof(float));
 
-    glBufferSubData(GL_ARRAY_BUFFER, VBOvertices, v * 3 * sizeof(float),
-                    vertices.buffer);
-    glBufferSubData(GL_ARRAY_BUFFER, VBOnormals, v * 3 * sizeof(float),
-                    normals.buffer);
-    glBufferSubData(GL_ARRAY_BUFFER, VBOtexcoords, v * 2 * sizeof(float),
-                    texcoords.buffer);
+    VBO_write(VBOvertices,  v * 3 * sizeof(float), vertices.buffer);
+    VBO_write(VBOnormals,   v * 3 * sizeof(float), normals.buffer);
+    VBO_write(VBOtexcoords, v * 2 * sizeof(float), texcoords.buffer);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // The client side index list goes away with the CPU copies, so move
+    //   the strips into an element buffer
+    if (gpuResident) {
+        if (!elementBuffer) {
+            glGenBuffers(1, &elementBuffer);
+        }
+        elementCount = fillRestartElements(elementBuffer);
+    }
 }
 
 // Query total size of VBOs
@@ -301,3 +440,224 @@ Branches_buildCylinder(
         }
     }
 }
+
+// Record a branch segment for GPU expansion, returns its index
+int
+Branches_addSegment(
+    float4x4  mat,
+    float     taper,
+    float     texcoordY,
+    int       parent)
+{
+    int index = segments.elemCount;
+    Segment seg;
+
+    set_4(seg.xaxis,  mat[0][0], mat[0][1], mat[0][2], taper);
+    set_4(seg.yaxis,  mat[1][0], mat[1][1], mat[1][2], texcoordY);
+    set_4(seg.origin, mat[3][0], mat[3][1], mat[3][2], (float)parent);
+    Array_push(&segments, &seg);
+
+    return index;
+}
+
+// Upload the segment records to the segment texture
+void
+Branches_buildSegments(void)
+{
+    int count = segmentCount = segments.elemCount;
+    int rows  = (count + BRANCHES_SEGMENTS_PER_ROW - 1)
+              / BRANCHES_SEGMENTS_PER_ROW;
+    int full  = count / BRANCHES_SEGMENTS_PER_ROW;
+    int width = BRANCHES_SEGMENTS_PER_ROW * 3;
+
+    if (!gpuExpand || !count) return;
+
+    if (!segmentTexture) {
+        glGenTextures(1, &segmentTexture);
+    }
+    glBindTexture(GL_TEXTURE_2D, segmentTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, rows, 0,
+                 GL_RGBA, GL_FLOAT, NULL);
+    if (full) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, full,
+                        GL_RGBA, GL_FLOAT, segments.buffer);
+    }
+    if (count > full * BRANCHES_SEGMENTS_PER_ROW) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, full,
+                        (count - full * BRANCHES_SEGMENTS_PER_ROW) * 3, 1,
+                        GL_RGBA, GL_FLOAT,
+                        Array_get(&segments,
+                                  full * BRANCHES_SEGMENTS_PER_ROW));
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Query whether the GPU expansion shader is available
+GLboolean
+Branches_gpuSupported(void)
+{
+    return prog_branches ? GL_TRUE : GL_FALSE;
+}
+
+// Query/select GPU cylinder expansion. The tree must be rebuilt after
+//   changing it.
+GLboolean
+Branches_isGPU(void)
+{
+    return gpuExpand;
+}
+
+void
+Branches_setGPU(
+    GLboolean enable)
+{
+    gpuExpand = enable && Branches_gpuSupported();
+}
+
+// Query/set the number of facets used by GPU expansion. This only
+//   affects drawing, so no rebuild is needed.
+int
+Branches_getFacets(void)
+{
+    return gpuFacets;
+}
+
+void
+Branches_setFacets(
+    int facets)
+{
+    if (facets < BRANCHES_MIN_FACETS) { facets = BRANCHES_MIN_FACETS; }
+    if (facets > BRANCHES_MAX_FACETS) { facets = BRANCHES_MAX_FACETS; }
+    gpuFacets = facets;
+}
+
+// Grow a bounding box to include all branch vertices
+void
+Branches_extendBounds(
+    float3 lo,
+    float3 hi)
+{
+    int i, j;
+
+    for (i = 0; i < vertices.elemCount; i++) {
+        float *v = (float*)Array_get(&vertices, i);
+        for (j = 0; j < 3; j++) {
+            lo[j] = min(lo[j], v[j]);
+            hi[j] = max(hi[j], v[j]);
+        }
+    }
+}
+
+// Query the branch texture
+GLuint
+Branches_getTexture(void)
+{
+    return texture;
+}
+
+// Point the given attributes at the branch VBO data. VBO_NAME must be
+//   bound to GL_ARRAY_BUFFER.
+void
+Branches_bindVBO(
+    GLint vertex,
+    GLint normal,
+    GLint texcoord)
+{
+    glVertexAttribPointer(vertex,
+                          3, GL_FLOAT, GL_FALSE, 0, (void*)VBOvertices);
+    glVertexAttribPointer(normal,
+                          3, GL_FLOAT, GL_FALSE, 0, (void*)VBOnormals);
+    glVertexAttribPointer(texcoord,
+                          2, GL_FLOAT, GL_FALSE, 0, (void*)VBOtexcoords);
+}
+
+// Fill an element buffer with all branch strips, separated by the fixed
+//   primitive restart index, so they can be drawn with a single call.
+//   Returns the number of indices.
+int
+Branches_buildRestartElements(
+    GLuint buffer)
+{
+    // Once the CPU copies are released, duplicate the resident list
+    if (elementCount && !indices.elemCount) {
+        glBindBuffer(GL_COPY_READ_BUFFER, elementBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, elementCount * sizeof(GLuint),
+                     NULL, GL_STATIC_DRAW);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            0, 0, elementCount * sizeof(GLuint));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return elementCount;
+    }
+
+    return fillRestartElements(buffer);
+}
+
+// Add the bytes of system and video memory held by the branch data
+//   (the shared VBO is accounted for by the tree)
+void
+Branches_memoryUsage(
+    unsigned int *cpu,
+    unsigned int *gpu)
+{
+    *cpu += vertices.buffSize + normals.buffSize + texcoords.buffSize +
+            indices.buffSize + segments.buffSize;
+    *gpu += elementCount * sizeof(GLuint);
+    if (segmentTexture && segmentCount) {
+        *gpu += ((segmentCount + BRANCHES_SEGMENTS_PER_ROW - 1)
+                 / BRANCHES_SEGMENTS_PER_ROW)
+              * BRANCHES_SEGMENTS_PER_ROW * 3 * sizeof(float4);
+    }
+}
+
+// Fill in the mesh cache streams of the branches
+void
+Branches_getStreams(
+    MeshStream *streams)
+{
+    int i;
+
+    for (i = 0; i < MESH_NUM_STREAMS - MESH_BRANCH_VERTICES; i++) {
+        MeshStream *s = &streams[MESH_BRANCH_VERTICES + i];
+        s->data     = streamArrays[i]->buffer;
+        s->count    = streamArrays[i]->elemCount;
+        s->elemSize = streamArrays[i]->elemSize;
+    }
+}
+
+// Use mesh cache streams as the branch data, after checking that they
+//   fit together. The client side draw path indexes the vertex streams,
+//   so every index is checked as well. The streams must stay mapped until
+//   the branches are cleared.
+GLboolean
+Branches_setStreams(
+    const MeshStream *streams)
+{
+    const MeshStream *s = &streams[MESH_BRANCH_VERTICES];
+    const unsigned int *index = (const unsigned int*)
+                                streams[MESH_BRANCH_INDICES].data;
+    int stride = (BRANCHES_FACETS + 1) * 2;
+    int i;
+
+    Branches_clear();
+    for (i = 0; i < MESH_NUM_STREAMS - MESH_BRANCH_VERTICES; i++) {
+        if (s[i].elemSize != streamArrays[i]->elemSize) return GL_FALSE;
+    }
+    if ((streams[MESH_BRANCH_NORMALS].count != s->count) ||
+        (streams[MESH_BRANCH_TEXCOORDS].count != s->count) ||
+        (streams[MESH_BRANCH_INDICES].count % stride)) {
+        return GL_FALSE;
+    }
+    for (i = 0; i < streams[MESH_BRANCH_INDICES].count; i++) {
+        if (index[i] >= (unsigned int)s->count) return GL_FALSE;
+    }
+
+    for (i = 0; i < MESH_NUM_STREAMS - MESH_BRANCH_VERTICES; i++) {
+        Array_wrap(streamArrays[i], s[i].data, s[i].count);
+    }
+    indexCount = indices.elemCount;
+    return GL_TRUE;
+}
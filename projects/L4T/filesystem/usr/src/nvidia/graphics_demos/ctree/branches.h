@@ -31,14 +31,24 @@
 
 #include <GLES2/gl2.h>
 #include "vector.h"
+#include "meshcache.h"
 
 // Number of faces for cylinders representing each branch
 #define BRANCHES_FACETS 5
 
+// Range of the facet count when the cylinders are expanded on the GPU
+#define BRANCHES_MIN_FACETS 3
+#define BRANCHES_MAX_FACETS 32
+
+// Segment records per row of the GPU segment texture
+//NOTE: any changes must also be made to branches_vert.glslv
+#define BRANCHES_SEGMENTS_PER_ROW 256
+
 // Initialization and clean-up
 void Branches_initialize(GLuint t);
 void Branches_deinitialize(void);
 void Branches_clear(void);
+void Branches_release(void);
 
 // Creation
 int  Branches_add(float n[3], float tc[2], float v[3]);
@@ -46,15 +56,34 @@ void Branches_addIndex(unsigned int);
 void Branches_generateStump(int *lower);
 void Branches_buildCylinder(
         int *idx, float4x4 mat, float taper, float texcoordY, GLboolean low);
+int  Branches_addSegment(
+        float4x4 mat, float taper, float texcoordY, int parent);
+
+// GPU cylinder expansion
+GLboolean Branches_gpuSupported(void);
+GLboolean Branches_isGPU(void);
+void Branches_setGPU(GLboolean enable);
+int  Branches_getFacets(void);
+void Branches_setFacets(int facets);
 
 // Query
 int  Branches_polyCount(void);
 int  Branches_branchCount(void);
 int  Branches_sizeVBO(void);
 int  Branches_numVertices(void);
+void Branches_extendBounds(float3 lo, float3 hi);
+GLuint Branches_getTexture(void);
+void Branches_memoryUsage(unsigned int *cpu, unsigned int *gpu);
+
+// Mesh cache
+void Branches_getStreams(MeshStream *streams);
+GLboolean Branches_setStreams(const MeshStream *streams);
 
 // Rendering
 void Branches_draw(int useVBO);
 void Branches_buildVBO(void);
+void Branches_buildSegments(void);
+void Branches_bindVBO(GLint vertex, GLint normal, GLint texcoord);
+int  Branches_buildRestartElements(GLuint buffer);
 
 #endif // __BRANCHES_H
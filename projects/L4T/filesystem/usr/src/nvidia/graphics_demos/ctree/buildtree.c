@@ -43,8 +43,13 @@ static float treebuildThreshhold;
 //
 // The BranchNoise object tracks the random numbers generated for each branch.
 //
+// The noise of a branch only depends on the character seed and its
+//   position in the tree, so the same seed and parameters always produce
+//   the same tree, no matter in which order the branches were created.
+//
 typedef struct BranchNoise {
     float noise;
+    unsigned int key;
     struct BranchNoise* left;
     struct BranchNoise* right;
 } BranchNoise;
@@ -52,15 +57,33 @@ typedef struct BranchNoise {
 // Root BrancNoise object
 static BranchNoise *bn = NULL;
 
+// Seed of the current tree character
+static unsigned int seed = 1;
+
+// Integer hash used to derive the branch keys and noise values
+static unsigned int
+hash(
+    unsigned int x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
 // Initialization and clean-up.
 static BranchNoise*
-BranchNoise_new(void)
+BranchNoise_new(
+    unsigned int key)
 {
     BranchNoise *o = (BranchNoise *)MALLOC(sizeof(BranchNoise));
     o->left = NULL;
     o->right = NULL;
+    o->key = key;
 
-    o->noise = ((float) GetRandom()) * 0.3f - 0.1f;
+    o->noise = (float)(hash(key) / 4294967296.0) * 0.3f - 0.1f;
 
     return o;
 }
@@ -85,7 +108,7 @@ BranchNoise_left(
     BranchNoise *o)
 {
     ASSERT(o);
-    if (!o->left) { o->left = BranchNoise_new(); }
+    if (!o->left) { o->left = BranchNoise_new(hash(o->key * 2 + 1)); }
     ASSERT(o->left);
     return o->left;
 }
@@ -95,7 +118,7 @@ BranchNoise_right(
     BranchNoise *o)
 {
     ASSERT(o);
-    if (!o->right) { o->right = BranchNoise_new(); }
+    if (!o->right) { o->right = BranchNoise_new(hash(o->key * 2 + 2)); }
     ASSERT(o->right);
     return o->right;
 }
@@ -113,7 +136,8 @@ build(
     float4x4    mat,
     float       texcoordY,
     float       decay,
-    int         level);
+    int         level,
+    int         parent);
 
 // This one is called once per branch.
 static void
@@ -126,7 +150,8 @@ buildBranch(
     float       texcoordY,
     float4x4    translateMat,
     BranchNoise *noise,
-    int         upper[])
+    int         upper[],
+    int         parent)
 {
     float4x4 mat, scaleMat, rotMat;
     float dec;
@@ -153,12 +178,15 @@ buildBranch(
     {
         int lower[BRANCHES_FACETS + 1];
 
-        build(lower, noise, mat, texcoordY, dec, level + 1);
+        build(lower, noise, mat, texcoordY, dec, level + 1, parent);
 
-        for (i = 0; i < BRANCHES_FACETS + 1; ++i)
-        {
-            Branches_addIndex(lower[i]);
-            Branches_addIndex(upper[i]);
+        // The joint to the parent is expanded on the GPU with the segment
+        if (!Branches_isGPU()) {
+            for (i = 0; i < BRANCHES_FACETS + 1; ++i)
+            {
+                Branches_addIndex(lower[i]);
+                Branches_addIndex(upper[i]);
+            }
         }
     }
 }
@@ -170,9 +198,11 @@ build(
     float4x4    mat,
     float       texcoordY,
     float       decay,
-    int         level)
+    int         level,
+    int         parent)
 {
     int upper[BRANCHES_FACETS + 1];
+    int segment = -1;
     float btwist, leftBranchNoise, rightBranchNoise;
     float branchAngle, branchAngleBias;
     float leftRadius, leftAngle, rightRadius, rightAngle;
@@ -208,23 +238,30 @@ build(
 
     branchRadius = treeParams[TREE_PARAM_BRANCH_SIZE];
 
-    Branches_buildCylinder(lower, mat, taper, texcoordY, GL_TRUE);
-    texcoordY += 1.0f - 2 * branchRadius;
-    Branches_buildCylinder(upper, mat, taper, texcoordY, GL_FALSE);
-    texcoordY += 2 * branchRadius;
+    if (Branches_isGPU()) {
+        // Only record the segment, the cylinder is expanded by the shader
+        segment = Branches_addSegment(mat, taper, texcoordY, parent);
+        texcoordY += 1.0f;
+    } else {
+        Branches_buildCylinder(lower, mat, taper, texcoordY, GL_TRUE);
+        texcoordY += 1.0f - 2 * branchRadius;
+        Branches_buildCylinder(upper, mat, taper, texcoordY, GL_FALSE);
+        texcoordY += 2 * branchRadius;
+
+        for (i = 0; i < BRANCHES_FACETS + 1; ++i)
+        {
+            Branches_addIndex(upper[i]);
+            Branches_addIndex(lower[i]);
+        }
+    }
 
     makeTranslate(translateMat, 0.0f, 0.0f, 1.0f);
     multi_f4x4(translateMat, mat);
 
-    for (i = 0; i < BRANCHES_FACETS + 1; ++i)
-    {
-        Branches_addIndex(upper[i]);
-        Branches_addIndex(lower[i]);
-    }
-    buildBranch(leftRadius, leftAngle, btwist,
-                decay, level, texcoordY, translateMat, leftNoise, upper);
-    buildBranch(rightRadius, rightAngle, btwist,
-                decay, level, texcoordY, translateMat, rightNoise, upper);
+    buildBranch(leftRadius, leftAngle, btwist, decay, level, texcoordY,
+                translateMat, leftNoise, upper, segment);
+    buildBranch(rightRadius, rightAngle, btwist, decay, level, texcoordY,
+                translateMat, rightNoise, upper, segment);
 }
 
 void
@@ -241,17 +278,35 @@ BuildTree_generate(void)
     treebuildThreshhold = (max - min) * u + min;
 
     // Create the noise object if it's not there yet.
-    if (!bn) { bn = BranchNoise_new(); }
+    if (!bn) { bn = BranchNoise_new(hash(seed)); }
 
     // Build the tree branches.
-    build(lower, bn, ident_matrix_f, 0.0f, 1.0f, 0);
+    build(lower, bn, ident_matrix_f, 0.0f, 1.0f, 0, -1);
 
-    // Build the tree stump.
-    Branches_generateStump(lower);
+    // Build the tree stump. With GPU expansion it is drawn as the joint of
+    //   the trunk segment, which has no parent.
+    if (!Branches_isGPU()) {
+        Branches_generateStump(lower);
+    }
 }
 
 void
 BuildTree_newCharacter()
+{
+    BuildTree_setSeed((unsigned int)(GetRandom() * 4294967295.0));
+}
+
+// Select the tree character
+void
+BuildTree_setSeed(
+    unsigned int s)
 {
     if (bn) { BranchNoise_delete(bn); bn = NULL; }
+    seed = s;
+}
+
+unsigned int
+BuildTree_getSeed(void)
+{
+    return seed;
 }
@@ -35,5 +35,7 @@
 // (Re)generate a tree.
 void BuildTree_generate(void);
 void BuildTree_newCharacter(void);
+void BuildTree_setSeed(unsigned int seed);
+unsigned int BuildTree_getSeed(void);
 
 #endif // __BUILDTREE_H
@@ -0,0 +1,352 @@
+/*
+ * forest.c
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// GPU driven forest rendering
+//
+
+#include "nvgldemo.h"
+#include <GLES3/gl31.h>
+#include "forest.h"
+#include "tree.h"
+#include "leaves.h"
+#include "branches.h"
+#include "vbo.h"
+#include "shaders.h"
+
+// Indirect command layout
+//NOTE: any changes must also be made to forestcull_comp.glslc
+#define COMMAND_SIZE   5        // uints per command
+#define PRIM_COUNT     1        // instance count within a command
+enum {
+    CMD_LEAVES0,                // Near trees: front leaves
+    CMD_BACKLEAVES,             //             back leaves
+    CMD_BRANCHES0,              //             branches
+    CMD_LEAVES1,                // Far trees:  two sided leaves
+    CMD_BRANCHES1,              //             branches
+    NUM_COMMANDS
+};
+
+// Vertex array setups, one per draw
+enum {
+    VAO_LEAVES0,
+    VAO_BACKLEAVES,
+    VAO_BRANCHES0,
+    VAO_LEAVES1,
+    VAO_BRANCHES1,
+    NUM_VAOS
+};
+
+// Compute shader work group size
+#define GROUP_SIZE 64
+
+// Buffers
+static GLuint instanceBuffer = 0;   // All trees
+static GLuint visibleBuffer  = 0;   // Near list followed by far list
+static GLuint commandBuffer  = 0;   // Indirect draw commands
+static GLuint elementBuffer  = 0;   // Branch strips with restart indices
+static GLuint vaos[NUM_VAOS];
+
+// Tree counts
+static int count    = 0;
+static int capacity = 0;
+
+// Template for the commands, with zero instance counts
+static GLuint commands[NUM_COMMANDS][COMMAND_SIZE];
+
+// Geometry build the vertex arrays were set up for
+static int generation = -1;
+
+// Query whether the OpenGL ES 3.1 shaders are available
+GLboolean
+Forest_supported(void)
+{
+    return prog_forestcull ? GL_TRUE : GL_FALSE;
+}
+
+// Initialize the buffers
+void
+Forest_initialize(void)
+{
+    if (!Forest_supported()) return;
+
+    glGenBuffers(1, &instanceBuffer);
+    glGenBuffers(1, &visibleBuffer);
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(1, &elementBuffer);
+    glGenVertexArrays(NUM_VAOS, vaos);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(commands), NULL,
+                 GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+// Release the buffers
+void
+Forest_deinitialize(void)
+{
+    if (!instanceBuffer) return;
+
+    glDeleteVertexArrays(NUM_VAOS, vaos);
+    glDeleteBuffers(1, &elementBuffer);
+    glDeleteBuffers(1, &commandBuffer);
+    glDeleteBuffers(1, &visibleBuffer);
+    glDeleteBuffers(1, &instanceBuffer);
+    instanceBuffer = visibleBuffer = commandBuffer = elementBuffer = 0;
+    count = capacity = 0;
+    generation = -1;
+}
+
+// Upload the tree placements. The visible lists are grown to match, which
+//   requires the vertex arrays to be set up again.
+void
+Forest_setInstances(
+    float4 *instances,
+    int    n)
+{
+    if (!instanceBuffer) return;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, n * sizeof(float4), instances,
+                 GL_STATIC_DRAW);
+
+    if (n > capacity) {
+        capacity = n;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibleBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * capacity * sizeof(float4),
+                     NULL, GL_DYNAMIC_COPY);
+        generation = -1;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    count = n;
+}
+
+// Check whether the forest can be drawn with the current tree geometry.
+//   It needs the geometry in the VBO and the CPU built branches.
+GLboolean
+Forest_isReady(void)
+{
+    return instanceBuffer && Tree_isVBO() && !Branches_isGPU();
+}
+
+// Set up one vertex array. The instance attribute steps through the near
+//   or far visible list.
+static void
+setupArray(
+    int       vao,
+    GLboolean leaves,
+    GLboolean back,
+    int       list)
+{
+    glBindVertexArray(vaos[vao]);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO_NAME);
+    glEnableVertexAttribArray(FOREST_ATTRIB_VERTEX);
+    glEnableVertexAttribArray(FOREST_ATTRIB_NORMAL);
+    glEnableVertexAttribArray(FOREST_ATTRIB_TEXCOORD);
+    if (leaves) {
+        glEnableVertexAttribArray(FOREST_ATTRIB_COLOR);
+        Leaves_bindVBO(FOREST_ATTRIB_VERTEX, FOREST_ATTRIB_NORMAL,
+                       FOREST_ATTRIB_COLOR, FOREST_ATTRIB_TEXCOORD, back);
+    } else {
+        glDisableVertexAttribArray(FOREST_ATTRIB_COLOR);
+        Branches_bindVBO(FOREST_ATTRIB_VERTEX, FOREST_ATTRIB_NORMAL,
+                         FOREST_ATTRIB_TEXCOORD);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+    glEnableVertexAttribArray(FOREST_ATTRIB_INSTANCE);
+    glVertexAttribPointer(FOREST_ATTRIB_INSTANCE, 4, GL_FLOAT, GL_FALSE, 0,
+                          (void*)(list * capacity * sizeof(float4)));
+    glVertexAttribDivisor(FOREST_ATTRIB_INSTANCE, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Set up the vertex arrays and command template for the current geometry
+static void
+setupGeometry(void)
+{
+    int leafVerts = Leaves_leafCount() * 6;
+    int branchIndices = Branches_buildRestartElements(elementBuffer);
+
+    setupArray(VAO_LEAVES0,    GL_TRUE,  GL_FALSE, 0);
+    setupArray(VAO_BACKLEAVES, GL_TRUE,  GL_TRUE,  0);
+    setupArray(VAO_BRANCHES0,  GL_FALSE, GL_FALSE, 0);
+    setupArray(VAO_LEAVES1,    GL_TRUE,  GL_FALSE, 1);
+    setupArray(VAO_BRANCHES1,  GL_FALSE, GL_FALSE, 1);
+
+    // DrawArraysIndirectCommand is count, primCount, first, reserved.
+    //   DrawElementsIndirectCommand adds baseVertex before reserved.
+    MEMSET(commands, 0, sizeof(commands));
+    commands[CMD_LEAVES0][0]    = leafVerts;
+    commands[CMD_BACKLEAVES][0] = leafVerts;
+    commands[CMD_LEAVES1][0]    = leafVerts;
+    commands[CMD_BRANCHES0][0]  = branchIndices;
+    commands[CMD_BRANCHES1][0]  = branchIndices;
+
+    generation = Tree_generation();
+}
+
+// Cull the trees and fill in the instance counts of the commands
+static void
+cull(
+    const float *mvp)
+{
+    float planes[6][4];
+    float center[3], radius;
+    int p;
+
+    // Extract the normalized frustum planes from the matrix rows
+    for (p = 0; p < 6; p++) {
+        float s = (p & 1) ? -1.0f : 1.0f;
+        int   r = p / 2;
+        float l;
+        planes[p][0] = mvp[3]  + s * mvp[r];
+        planes[p][1] = mvp[7]  + s * mvp[4 + r];
+        planes[p][2] = mvp[11] + s * mvp[8 + r];
+        planes[p][3] = mvp[15] + s * mvp[12 + r];
+        l = SQRT(dot_3(planes[p], planes[p]));
+        planes[p][0] /= l;
+        planes[p][1] /= l;
+        planes[p][2] /= l;
+        planes[p][3] /= l;
+    }
+    Tree_getBounds(center, &radius);
+
+    // Reset the instance counts
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(commands), commands);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glUseProgram(prog_forestcull);
+    glUniform1ui(uloc_forestcullCount, count);
+    glUniform1ui(uloc_forestcullCapacity, capacity);
+    glUniform4fv(uloc_forestcullPlanes, 6, &planes[0][0]);
+    glUniform4f(uloc_forestcullDepthRow, mvp[3], mvp[7], mvp[11], mvp[15]);
+    glUniform4f(uloc_forestcullBounds,
+                center[0], center[1], center[2], radius);
+    glUniform1f(uloc_forestcullLodDistance, FOREST_LOD_DISTANCE);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+    glDispatchCompute((count + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+    // The results are consumed as draw commands and instance attributes
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT |
+                    GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+// Draw all trees. The lighting and matrix uniforms of the forest shaders
+//   must already be set, the matrix is only passed for culling.
+void
+Forest_draw(
+    const float *mvp)
+{
+    if (!Forest_isReady() || !count) return;
+
+    Tree_update();
+    if (generation != Tree_generation()) {
+        setupGeometry();
+    }
+
+    cull(mvp);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+
+    // Leaves
+    glUseProgram(prog_forestleaves);
+    glEnable(GL_CULL_FACE);
+
+    glCullFace(GL_BACK);
+    glBindTexture(GL_TEXTURE_2D, Leaves_getTexture(GL_FALSE));
+    glBindVertexArray(vaos[VAO_LEAVES0]);
+    glDrawArraysIndirect(GL_TRIANGLES,
+        (void*)(CMD_LEAVES0 * COMMAND_SIZE * sizeof(GLuint)));
+
+    glCullFace(GL_FRONT);
+    glBindTexture(GL_TEXTURE_2D, Leaves_getTexture(GL_TRUE));
+    glBindVertexArray(vaos[VAO_BACKLEAVES]);
+    glDrawArraysIndirect(GL_TRIANGLES,
+        (void*)(CMD_BACKLEAVES * COMMAND_SIZE * sizeof(GLuint)));
+
+    glDisable(GL_CULL_FACE);
+    glBindTexture(GL_TEXTURE_2D, Leaves_getTexture(GL_FALSE));
+    glBindVertexArray(vaos[VAO_LEAVES1]);
+    glDrawArraysIndirect(GL_TRIANGLES,
+        (void*)(CMD_LEAVES1 * COMMAND_SIZE * sizeof(GLuint)));
+
+    // Branches
+    glUseProgram(prog_forestsolids);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    glVertexAttrib3f(FOREST_ATTRIB_COLOR, 1.0f, 1.0f, 1.0f);
+    glBindTexture(GL_TEXTURE_2D, Branches_getTexture());
+
+    glBindVertexArray(vaos[VAO_BRANCHES0]);
+    glDrawElementsIndirect(GL_TRIANGLE_STRIP, GL_UNSIGNED_INT,
+        (void*)(CMD_BRANCHES0 * COMMAND_SIZE * sizeof(GLuint)));
+    glBindVertexArray(vaos[VAO_BRANCHES1]);
+    glDrawElementsIndirect(GL_TRIANGLE_STRIP, GL_UNSIGNED_INT,
+        (void*)(CMD_BRANCHES1 * COMMAND_SIZE * sizeof(GLuint)));
+
+    glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    glBindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+// Read back the results of the last cull. This stalls until the GPU has
+//   finished it, so it is only meant for statistics.
+void
+Forest_getCounts(
+    int *near,
+    int *far,
+    int *culled)
+{
+    GLuint *cmds;
+
+    *near = *far = 0;
+    *culled = count;
+    if (!instanceBuffer || !count) return;
+
+    // The cull only made its writes visible to draws; reading them back
+    //   through a mapping needs its own barrier
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    cmds = (GLuint*)glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0,
+                                     sizeof(commands), GL_MAP_READ_BIT);
+    if (cmds) {
+        *near   = cmds[CMD_LEAVES0 * COMMAND_SIZE + PRIM_COUNT];
+        *far    = cmds[CMD_LEAVES1 * COMMAND_SIZE + PRIM_COUNT];
+        *culled = count - *near - *far;
+        glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
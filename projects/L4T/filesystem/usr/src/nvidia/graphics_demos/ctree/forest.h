@@ -0,0 +1,67 @@
+/*
+ * forest.h
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// GPU driven forest rendering (OpenGL ES 3.1)
+//
+// All tree placements live in a shader storage buffer. Every frame a
+//   compute shader frustum culls them, picks a detail level and appends
+//   the visible ones to per-level lists which feed instanced indirect
+//   draws, so the CPU cost does not depend on the number of trees.
+//
+
+#ifndef __FOREST_H
+#define __FOREST_H
+
+#include <GLES2/gl2.h>
+#include "vector.h"
+
+// Trees farther than this view depth draw their leaves in one two sided
+//   pass instead of separate front and back passes
+#define FOREST_LOD_DISTANCE 30.0f
+
+// Vertex attribute locations
+//NOTE: any changes must also be made to forest_vert.glslv
+#define FOREST_ATTRIB_VERTEX   0
+#define FOREST_ATTRIB_NORMAL   1
+#define FOREST_ATTRIB_COLOR    2
+#define FOREST_ATTRIB_TEXCOORD 3
+#define FOREST_ATTRIB_INSTANCE 4
+
+// Initialization and clean-up
+void Forest_initialize(void);
+void Forest_deinitialize(void);
+
+// Set the tree placements as (x, y, cos(angle), sin(angle))
+void Forest_setInstances(float4 *instances, int count);
+
+// Query
+GLboolean Forest_supported(void);
+GLboolean Forest_isReady(void);
+void Forest_getCounts(int *near, int *far, int *culled);
+
+// Rendering
+void Forest_draw(const float *mvp);
+
+#endif // __FOREST_H
@@ -23,116 +23,446 @@
  */
 
 //
-// Ground plane
+// Ground terrain
 //
+// The terrain is a square of chunks, each GROUND_SIZE wide, centered on
+//   the origin. Every chunk owns a (resolution+1)^2 block of vertices in a
+//   single VBO. Coarser levels of detail skip vertices of the same block,
+//   so one set of index lists is shared by all chunks. The indices of each
+//   level are split into the interior cells and a one cell wide border
+//   ring. The ring has a variant for each combination of edges bordering a
+//   coarser chunk, which skips every other vertex along those edges so no
+//   cracks open up between levels.
+//
+
+#include <stddef.h>
 
+#include "nvgldemo.h"
 #include "ground.h"
-#include "random.h"
-#include "vbo.h"
+#include "array.h"
 #include "vector.h"
 #include "shaders.h"
 
-// Mesh resolution
-#define RESOLUTION 10
-#define MAXSIZE (RESOLUTION + 1)
-#define MAXAREA (MAXSIZE * MAXSIZE)
+// Default terrain layout
+#define DEFAULT_CHUNKS     8    // Chunks along each side of the terrain
+#define DEFAULT_RESOLUTION 32   // Cells along each side of a full detail chunk
+
+// Chunks up to this eye space depth are drawn at full detail. The level
+//   of detail drops by one each time the depth doubles.
+#define LOD_DISTANCE (1.5f * GROUND_SIZE)
+
+// Maximum number of detail levels (log2(GROUND_MAX_RESOLUTION))
+#define MAX_LODS 9
+
+// Largest vertex buffer the terrain may use. Layouts above it get fewer
+//   chunks.
+#define MAX_VERTEX_BYTES (256 * 1024 * 1024)
+
+// Highest resolution whose blocks can be drawn with 16 bit indices
+#define MAX_SHORT_RESOLUTION 128
+
+// Height variation, matching the old random ground mesh
+#define HEIGHT_SCALE   (0.04f * GROUND_SIZE)
+#define FEATURE_SIZE   (GROUND_SIZE / 10.0f)
+
+// Chunk edges, also used as bits of the ring variant mask
+enum { EDGE_BOTTOM, EDGE_RIGHT, EDGE_TOP, EDGE_LEFT, NUM_EDGES };
+#define NUM_RINGS (1 << NUM_EDGES)
+
+typedef struct {
+    float3 vertex;
+    float3 normal;
+    float2 texcoord;
+} GroundVertex;
+
+typedef struct {
+    unsigned long offset;   // Byte offset in the element buffer
+    int           count;    // Number of indices
+} IndexRange;
+
+typedef struct {
+    float minZ, maxZ;       // Height bounds
+    int   lod;              // Level of detail selected for this frame
+} Chunk;
 
 // Ground texture
 static GLuint texture;
 
-// Ground vertex info
-static float3 vertices [MAXSIZE*MAXSIZE];
-static float3 normals  [MAXSIZE*MAXSIZE];
-static float2 texcoords[MAXSIZE*MAXSIZE];
-static float3 colors   [MAXSIZE*MAXSIZE];
-static GLubyte indicies[RESOLUTION*2*MAXSIZE];
+// Terrain layout
+static int chunks     = DEFAULT_CHUNKS;
+static int resolution = DEFAULT_RESOLUTION;
+static int lods;
+static Chunk *chunkInfo = NULL;
+
+// Buffers
+static GLuint vertexBuffer  = 0;
+static GLuint elementBuffer = 0;
+static GLenum indexType;
+static GLsizeiptr vertexBytes, elementBytes;
+static IndexRange interior[MAX_LODS];
+static IndexRange ring[MAX_LODS][NUM_RINGS];
+
+// Statistics of the last frame
+static int drawnChunks = 0;
+static int drawnPolys  = 0;
+
+// Pseudorandom value in [-0.5, 0.5) for a lattice point
+static float
+lattice(
+    int x,
+    int y,
+    int seed)
+{
+    unsigned int h = (unsigned int)x * 73856093u
+                   ^ (unsigned int)y * 19349663u
+                   ^ (unsigned int)seed * 83492791u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return (float)(h & 0xffff) / 65536.0f - 0.5f;
+}
+
+// Smoothly interpolated value noise
+static float
+noise(
+    float x,
+    float y,
+    int   seed)
+{
+    float fx = (float)floor(x), fy = (float)floor(y);
+    int   ix = (int)fx,         iy = (int)fy;
+    float u = x - fx,           v = y - fy;
+    float a, b;
+
+    u = u * u * (3.0f - 2.0f * u);
+    v = v * v * (3.0f - 2.0f * v);
+    a = lattice(ix, iy,     seed) * (1.0f - u)
+      + lattice(ix + 1, iy,     seed) * u;
+    b = lattice(ix, iy + 1, seed) * (1.0f - u)
+      + lattice(ix + 1, iy + 1, seed) * u;
+    return a * (1.0f - v) + b * v;
+}
 
-// Ground VBO indices
-static unsigned long VBOvertices, VBOnormals, VBOtexcoords, VBOcolors;
+// Terrain height at a world position. This only depends on the position,
+//   so vertices shared by neighbouring chunks match exactly.
+static float
+height(
+    float x,
+    float y)
+{
+    return HEIGHT_SCALE * (noise(x / FEATURE_SIZE, y / FEATURE_SIZE, 0) +
+                           0.25f * noise(x * 4.0f / FEATURE_SIZE,
+                                         y * 4.0f / FEATURE_SIZE, 1));
+}
 
-// Utility function to handling index wrapping
-static int
-wrap(
+// World coordinate of a grid line along either axis
+static float
+gridCoord(
+    int c,
     int i)
 {
-    while (i > RESOLUTION) i -= RESOLUTION;
-    while (i < 0)          i += RESOLUTION;
-    return i;
+    return (float)(c * resolution + i) * GROUND_SIZE / (float)resolution
+         - (float)chunks * GROUND_SIZE / 2.0f;
 }
 
-// Build the ground plane vertices
-static void
-build(void)
+// Index of a vertex within a chunk block given its cell position at a
+//   level of detail
+static unsigned int
+gridIndex(
+    int lod,
+    int x,
+    int y)
 {
-    int i, j, step;
-    GLubyte *indx;
+    return (unsigned int)((y << lod) * (resolution + 1) + (x << lod));
+}
 
-    for (j = 0; j < MAXSIZE; ++j)
-    {
-        float y = ((float)j) / ((float)RESOLUTION) * 2.0f - 1.0f;
-        float py = y * GROUND_SIZE / 2.0f;
-        float t = (((float)j) / ((float)RESOLUTION));
+// Position of a ring vertex given the distance along the edge (u) and
+//   into the chunk (v). Each edge is rotated, not mirrored, from the
+//   bottom one so all triangles keep their winding.
+static unsigned int
+edgeIndex(
+    int lod,
+    int edge,
+    int u,
+    int v)
+{
+    int n = resolution >> lod;
 
-        for (i = 0; i< MAXSIZE; ++i)
-        {
-            float pz = ((float)GetRandom() - 0.5f) * 0.04f * GROUND_SIZE;
+    switch (edge) {
+    case EDGE_BOTTOM: return gridIndex(lod, u,     v);
+    case EDGE_RIGHT:  return gridIndex(lod, n - v, u);
+    case EDGE_TOP:    return gridIndex(lod, n - u, n - v);
+    default:          return gridIndex(lod, v,     n - u);
+    }
+}
 
-            float x = ((float)i)/((float)RESOLUTION) * 2.0f - 1.0f;
-            float px = x * GROUND_SIZE / 2.0f;
-            float s = (((float)i) / ((float)RESOLUTION));
-            float r2;
+static void
+addTriangle(
+    Array        *indices,
+    unsigned int a,
+    unsigned int b,
+    unsigned int c)
+{
+    Array_push(indices, &a);
+    Array_push(indices, &b);
+    Array_push(indices, &c);
+}
 
-            set_3(vertices [j*MAXSIZE+i], px, py, pz);
-            set_2(texcoords[j*MAXSIZE+i], s, t);
+// Triangulate the interior cells of a level of detail
+static void
+buildInterior(
+    Array *indices,
+    int   lod)
+{
+    int n = resolution >> lod;
+    int x, y;
+
+    for (y = 1; y < n - 1; y++) {
+        for (x = 1; x < n - 1; x++) {
+            addTriangle(indices, gridIndex(lod, x,     y),
+                                 gridIndex(lod, x + 1, y),
+                                 gridIndex(lod, x + 1, y + 1));
+            addTriangle(indices, gridIndex(lod, x,     y),
+                                 gridIndex(lod, x + 1, y + 1),
+                                 gridIndex(lod, x,     y + 1));
+        }
+    }
+}
 
-            r2 = (x*x+y*y);
-            if (r2>1.0) r2 = 0.0;
-            else r2 = 1.0f-r2;
-            set_3(colors[j*MAXSIZE+i], r2, r2, r2);
+// Triangulate the border ring of a level of detail. Each edge zips the
+//   outer row (every cell, or every other cell when the neighbour is
+//   coarser) to the inner row of vertices one cell in.
+static void
+buildRing(
+    Array *indices,
+    int   lod,
+    int   mask)
+{
+    int n = resolution >> lod;
+    int edge;
+
+    for (edge = 0; edge < NUM_EDGES; edge++) {
+        int step = (mask & (1 << edge)) ? 2 : 1;
+        int o = 0, i = 1;
+
+        while ((o < n) || (i < n - 1)) {
+            if ((o < n) && ((i >= n - 1) || (o + step <= i + 1))) {
+                addTriangle(indices, edgeIndex(lod, edge, o, 0),
+                                     edgeIndex(lod, edge, o + step, 0),
+                                     edgeIndex(lod, edge, i, 1));
+                o += step;
+            } else {
+                addTriangle(indices, edgeIndex(lod, edge, o, 0),
+                                     edgeIndex(lod, edge, i + 1, 1),
+                                     edgeIndex(lod, edge, i, 1));
+                i++;
+            }
         }
     }
+}
 
-    // wrap edge
-    for (j=0; j<RESOLUTION; j++) {
-        vertices[RESOLUTION*MAXSIZE+j][2] = vertices[j][2];
-        vertices[j*MAXSIZE+RESOLUTION][2] = vertices[j*MAXSIZE][2];
+// Build the shared index lists and upload them
+static GLboolean
+buildIndices(void)
+{
+    Array indices;
+    int lod, mask, i;
+    int size;
+    void *data;
+
+    Array_init(&indices, sizeof(unsigned int));
+
+    // Every level must keep at least one interior vertex row
+    for (lods = 0; (lods < MAX_LODS) && ((resolution >> lods) >= 2); lods++) {
+        interior[lods].offset = indices.elemCount;
+        buildInterior(&indices, lods);
+        interior[lods].count = indices.elemCount - interior[lods].offset;
+
+        for (mask = 0; mask < NUM_RINGS; mask++) {
+            ring[lods][mask].offset = indices.elemCount;
+            buildRing(&indices, lods, mask);
+            ring[lods][mask].count =
+                indices.elemCount - ring[lods][mask].offset;
+        }
     }
 
-    vertices[RESOLUTION*MAXSIZE+RESOLUTION][2] = vertices[0][2];
+    // Use 16 bit indices whenever a chunk block is small enough
+    if (resolution <= MAX_SHORT_RESOLUTION) {
+        GLushort *shorts;
+        indexType = GL_UNSIGNED_SHORT;
+        size = sizeof(GLushort);
+        shorts = (GLushort*)MALLOC(indices.elemCount * size);
+        if (!shorts) {
+            Array_destroy(&indices);
+            return GL_FALSE;
+        }
+        for (i = 0; i < indices.elemCount; i++) {
+            shorts[i] = (GLushort)*(unsigned int*)Array_get(&indices, i);
+        }
+        data = shorts;
+    } else {
+        indexType = GL_UNSIGNED_INT;
+        size = sizeof(GLuint);
+        data = indices.buffer;
+    }
 
-    // Construct the normal vectors.
-    step = (int)(GROUND_SIZE / ((float)RESOLUTION));
-    for (j = 0; j < MAXSIZE; ++j) {
+    // Convert the offsets to bytes
+    for (lod = 0; lod < lods; lod++) {
+        interior[lod].offset *= size;
+        for (mask = 0; mask < NUM_RINGS; mask++) {
+            ring[lod][mask].offset *= size;
+        }
+    }
 
-        for (i = 0; i < MAXSIZE; ++i) {
+    glGenBuffers(1, &elementBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+    elementBytes = (GLsizeiptr)indices.elemCount * size;
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementBytes, data,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-            float3 v0 = {(float) step, 0.0f,
-                         vertices[j*MAXSIZE+wrap(i + 1)][2]
-                         - vertices[j*MAXSIZE+wrap(i - 1)][2]};
-            float3 v1 = {0.0f, (float) step,
-                         vertices[wrap(j + 1)*MAXSIZE+i][2]
-                         - vertices[wrap(j - 1)*MAXSIZE+i][2]};
-            float3 v;
-            cross_3(v, v0, v1);
-            normalize_f3(normals[j*MAXSIZE+i], v);
-        }
+    if (data != indices.buffer) {
+        FREE(data);
     }
+    Array_destroy(&indices);
 
-    // Wrap the normal vectors.
-    for (j = 0; j < MAXSIZE; j++) {
-        copy_3(normals[j*MAXSIZE+RESOLUTION], normals[j*MAXSIZE]);
-        copy_3(normals[RESOLUTION*MAXSIZE+j], normals[j]);
+    return (glGetError() == GL_NO_ERROR) ? GL_TRUE : GL_FALSE;
+}
+
+// Build the vertices of all chunks, writing each block straight into a
+//   mapping of its range of the vertex buffer. Without OpenGL ES 3 there
+//   is no glMapBufferRange, so each block is built in a staging copy and
+//   uploaded with glBufferSubData instead.
+static GLboolean
+buildVertices(void)
+{
+    int blockSize = (resolution + 1) * (resolution + 1);
+    float e = GROUND_SIZE / (float)resolution;
+    GroundVertex *block, *staging = NULL;
+    int cx, cy, i, j;
+
+    vertexBytes = (GLsizeiptr)chunks * chunks * blockSize
+                * sizeof(GroundVertex);
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, NULL, GL_STATIC_DRAW);
+
+    if (!NvGlDemoHasGlesVersion(3, 0)) {
+        staging = (GroundVertex*)MALLOC(blockSize * sizeof(GroundVertex));
+        if (!staging) {
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            return GL_FALSE;
+        }
     }
-    copy_3(normals[RESOLUTION*MAXSIZE+RESOLUTION], normals[0]);
 
-    // Make the indicies for the triangle strips.
-    indx = indicies;
-    for (j=0; j<RESOLUTION; ++j) {
-        for (i=0; i<MAXSIZE; ++i) {
-            *indx++ = (j+1)*MAXSIZE+i;
-            *indx++ = j*MAXSIZE+i;
+    for (cy = 0; cy < chunks; cy++) {
+        for (cx = 0; cx < chunks; cx++) {
+            Chunk *chunk = &chunkInfo[cy * chunks + cx];
+            GLintptr offset = (GLintptr)(cy * chunks + cx)
+                            * blockSize * sizeof(GroundVertex);
+            GroundVertex *v;
+
+            if (staging) {
+                block = staging;
+            } else {
+                block = (GroundVertex*)glMapBufferRange(GL_ARRAY_BUFFER,
+                    offset, blockSize * sizeof(GroundVertex),
+                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+                if (!block) {
+                    glBindBuffer(GL_ARRAY_BUFFER, 0);
+                    return GL_FALSE;
+                }
+            }
+            v = block;
+
+            chunk->minZ =  GROUND_SIZE;
+            chunk->maxZ = -GROUND_SIZE;
+
+            for (j = 0; j <= resolution; j++) {
+                float y = gridCoord(cy, j);
+                for (i = 0; i <= resolution; i++, v++) {
+                    float x = gridCoord(cx, i);
+                    float z = height(x, y);
+                    float3 n = {height(x - e, y) - height(x + e, y),
+                                height(x, y - e) - height(x, y + e),
+                                2.0f * e};
+
+                    set_3(v->vertex, x, y, z);
+                    normalize_f3(v->normal, n);
+
+                    // Same mapping as the old single tile, repeated
+                    set_2(v->texcoord, x / GROUND_SIZE + 0.5f,
+                                       y / GROUND_SIZE + 0.5f);
+
+                    if (z < chunk->minZ) chunk->minZ = z;
+                    if (z > chunk->maxZ) chunk->maxZ = z;
+                }
+            }
+
+            if (staging) {
+                glBufferSubData(GL_ARRAY_BUFFER, offset,
+                                blockSize * sizeof(GroundVertex), staging);
+            } else if (!glUnmapBuffer(GL_ARRAY_BUFFER)) {
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                return GL_FALSE;
+            }
         }
     }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    FREE(staging);
+
+    return (glGetError() == GL_NO_ERROR) ? GL_TRUE : GL_FALSE;
+}
+
+// Select the terrain layout. Must be called before Ground_initialize.
+void
+Ground_setSize(
+    int c,
+    int r)
+{
+    chunks = (c < 1) ? 1 : c;
+
+    // Detail levels halve the resolution, so round it to a power of two
+    for (resolution = GROUND_MIN_RESOLUTION;
+         (resolution < r) && (resolution < GROUND_MAX_RESOLUTION);
+         resolution *= 2);
+}
+
+// 32 bit indices need OpenGL ES 3 or GL_OES_element_index_uint
+static GLboolean
+hasUintIndices(void)
+{
+    const char *extensions = (const char*)glGetString(GL_EXTENSIONS);
+
+    if (NvGlDemoHasGlesVersion(3, 0)) {
+        return GL_TRUE;
+    }
+    return (extensions && STRSTR(extensions, "GL_OES_element_index_uint"))
+           ? GL_TRUE : GL_FALSE;
+}
+
+// Reduce the requested layout to what the context can draw and what fits
+//   in MAX_VERTEX_BYTES
+static void
+limitSize(void)
+{
+    size_t blockBytes;
+    int c = chunks, r = resolution;
+
+    if (!hasUintIndices() && (resolution > MAX_SHORT_RESOLUTION)) {
+        resolution = MAX_SHORT_RESOLUTION;
+    }
+    blockBytes = (size_t)(resolution + 1) * (resolution + 1)
+               * sizeof(GroundVertex);
+    while ((chunks > 1) &&
+           ((size_t)chunks * chunks * blockBytes > MAX_VERTEX_BYTES)) {
+        chunks--;
+    }
+    if ((chunks != c) || (resolution != r)) {
+        NvGlDemoLog("Terrain of %dx%d chunks of %d cells is too large,"
+                    " using %dx%d chunks of %d cells\n",
+                    c, c, r, chunks, chunks, resolution);
+    }
 }
 
 // Intialize the ground
@@ -140,25 +470,127 @@ void
 Ground_initialize(
     GLuint t)
 {
-    // Create the terrain mesh
-    build();
+    limitSize();
 
-    // Save the texture
+    // Save the texture. It is repeated once per chunk.
     texture = t;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // Create the terrain mesh
+    chunkInfo = (Chunk*)MALLOC(chunks * chunks * sizeof(Chunk));
+    if (!chunkInfo || !buildIndices() || !buildVertices()) {
+        NvGlDemoLog("Unable to create %dx%d terrain chunks of %d cells\n",
+                    chunks, chunks, resolution);
+        Ground_deinitialize();
+    }
 }
 
 // Release ground resources
 void
 Ground_deinitialize(void)
 {
-    // No action required
+    if (vertexBuffer)  glDeleteBuffers(1, &vertexBuffer);
+    if (elementBuffer) glDeleteBuffers(1, &elementBuffer);
+    vertexBuffer = elementBuffer = 0;
+    vertexBytes = elementBytes = 0;
+
+    if (chunkInfo) {
+        FREE(chunkInfo);
+        chunkInfo = NULL;
+    }
+}
+
+// Check an axis aligned box against the view frustum
+static GLboolean
+visible(
+    float        planes[6][4],
+    const float3 lo,
+    const float3 hi)
+{
+    int p;
+
+    for (p = 0; p < 6; p++) {
+        // Test the corner farthest along the plane normal
+        float d = planes[p][3]
+                + planes[p][0] * (planes[p][0] > 0.0f ? hi[0] : lo[0])
+                + planes[p][1] * (planes[p][1] > 0.0f ? hi[1] : lo[1])
+                + planes[p][2] * (planes[p][2] > 0.0f ? hi[2] : lo[2]);
+        if (d < 0.0f) return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
+// Pick a level of detail for every chunk, limited so that neighbouring
+//   chunks never differ by more than one level
+static void
+selectLods(
+    const float *mvp)
+{
+    int c, x, y, changed;
+
+    for (y = 0; y < chunks; y++) {
+        for (x = 0; x < chunks; x++) {
+            Chunk *chunk = &chunkInfo[y * chunks + x];
+            float cx = gridCoord(x, resolution / 2);
+            float cy = gridCoord(y, resolution / 2);
+            float cz = (chunk->minZ + chunk->maxZ) / 2.0f;
+            float w  = mvp[3] * cx + mvp[7] * cy + mvp[11] * cz + mvp[15];
+            float d  = LOD_DISTANCE;
+
+            chunk->lod = 0;
+            while ((chunk->lod < lods - 1) && (w > d)) {
+                chunk->lod++;
+                d *= 2.0f;
+            }
+        }
+    }
+
+    do {
+        changed = 0;
+        for (c = 0; c < chunks * chunks; c++) {
+            int lod = chunkInfo[c].lod;
+            x = c % chunks;
+            y = c / chunks;
+            if (x > 0)          lod = min(lod, chunkInfo[c - 1].lod + 1);
+            if (x < chunks - 1) lod = min(lod, chunkInfo[c + 1].lod + 1);
+            if (y > 0)          lod = min(lod, chunkInfo[c - chunks].lod + 1);
+            if (y < chunks - 1) lod = min(lod, chunkInfo[c + chunks].lod + 1);
+            if (lod != chunkInfo[c].lod) {
+                chunkInfo[c].lod = lod;
+                changed = 1;
+            }
+        }
+    } while (changed);
 }
 
-// Draw the ground
+// Draw the ground. The projection*modelview matrix must already be loaded
+//   into the solids shader, it is only passed for culling and detail
+//   selection.
 void
 Ground_draw(
-    int useVBO)
+    const float *mvp)
 {
+    int blockSize = (resolution + 1) * (resolution + 1);
+    float planes[6][4];
+    int x, y, p;
+
+    drawnChunks = drawnPolys = 0;
+    if (!vertexBuffer) return;
+
+    // Extract the frustum planes from the matrix rows
+    for (p = 0; p < 6; p++) {
+        float s = (p & 1) ? -1.0f : 1.0f;
+        int   r = p / 2;
+        planes[p][0] = mvp[3]  + s * mvp[r];
+        planes[p][1] = mvp[7]  + s * mvp[4 + r];
+        planes[p][2] = mvp[11] + s * mvp[8 + r];
+        planes[p][3] = mvp[15] + s * mvp[12 + r];
+    }
+
+    selectLods(mvp);
+
     glUseProgram(prog_solids);
 
     glEnable(GL_CULL_FACE);
@@ -166,84 +598,97 @@ Ground_draw(
 
     glBindTexture(GL_TEXTURE_2D, texture);
 
-    int j;
-
+    glVertexAttrib3f(aloc_solidsColor, 1.0f, 1.0f, 1.0f);
     glEnableVertexAttribArray(aloc_solidsVertex);
     glEnableVertexAttribArray(aloc_solidsNormal);
-    glEnableVertexAttribArray(aloc_solidsColor);
     glEnableVertexAttribArray(aloc_solidsTexcoord);
 
-    if (useVBO) {
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_NAME);
-        glVertexAttribPointer(aloc_solidsVertex,
-                              3, GL_FLOAT, GL_FALSE, 0, (void*)VBOvertices);
-        glVertexAttribPointer(aloc_solidsNormal,
-                              3, GL_FLOAT, GL_FALSE, 0, (void*)VBOnormals);
-        glVertexAttribPointer(aloc_solidsColor,
-                              3, GL_FLOAT, GL_FALSE, 0, (void*)VBOcolors);
-        glVertexAttribPointer(aloc_solidsTexcoord,
-                              2, GL_FLOAT, GL_FALSE, 0, (void*)VBOtexcoords);
-    }  else {
-        glVertexAttribPointer(aloc_solidsVertex,
-                              3, GL_FLOAT, GL_FALSE, 0, vertices);
-        glVertexAttribPointer(aloc_solidsNormal,
-                              3, GL_FLOAT, GL_FALSE, 0, normals);
-        glVertexAttribPointer(aloc_solidsColor,
-                              3, GL_FLOAT, GL_FALSE, 0, colors);
-        glVertexAttribPointer(aloc_solidsTexcoord,
-                              2, GL_FLOAT, GL_FALSE, 0, texcoords);
-    }
-
-    for (j=0; j<RESOLUTION; ++j) {
-        glDrawElements(GL_TRIANGLE_STRIP, 2*MAXSIZE, GL_UNSIGNED_BYTE,
-                       (const GLvoid*) &indicies[j*2*MAXSIZE]);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+
+    for (y = 0; y < chunks; y++) {
+        for (x = 0; x < chunks; x++) {
+            Chunk *chunk = &chunkInfo[y * chunks + x];
+            float3 lo = {gridCoord(x, 0), gridCoord(y, 0), chunk->minZ};
+            float3 hi = {gridCoord(x + 1, 0), gridCoord(y + 1, 0), chunk->maxZ};
+            unsigned long base;
+            IndexRange *r;
+            int mask = 0;
+
+            if (!visible(planes, lo, hi)) continue;
+
+            // Stitch the edges shared with coarser chunks
+            if ((y > 0) && (chunk[-chunks].lod > chunk->lod))
+                mask |= 1 << EDGE_BOTTOM;
+            if ((x < chunks - 1) && (chunk[1].lod > chunk->lod))
+                mask |= 1 << EDGE_RIGHT;
+            if ((y < chunks - 1) && (chunk[chunks].lod > chunk->lod))
+                mask |= 1 << EDGE_TOP;
+            if ((x > 0) && (chunk[-1].lod > chunk->lod))
+                mask |= 1 << EDGE_LEFT;
+
+            // Point the attributes at the vertex block of this chunk
+            base = (unsigned long)(y * chunks + x) * blockSize
+                 * sizeof(GroundVertex);
+            glVertexAttribPointer(aloc_solidsVertex,
+                                  3, GL_FLOAT, GL_FALSE, sizeof(GroundVertex),
+                                  (void*)(base +
+                                          offsetof(GroundVertex, vertex)));
+            glVertexAttribPointer(aloc_solidsNormal,
+                                  3, GL_FLOAT, GL_FALSE, sizeof(GroundVertex),
+                                  (void*)(base +
+                                          offsetof(GroundVertex, normal)));
+            glVertexAttribPointer(aloc_solidsTexcoord,
+                                  2, GL_FLOAT, GL_FALSE, sizeof(GroundVertex),
+                                  (void*)(base +
+                                          offsetof(GroundVertex, texcoord)));
+
+            r = &interior[chunk->lod];
+            if (r->count) {
+                glDrawElements(GL_TRIANGLES, r->count, indexType,
+                               (void*)r->offset);
+            }
+            r = &ring[chunk->lod][mask];
+            glDrawElements(GL_TRIANGLES, r->count, indexType,
+                           (void*)r->offset);
+
+            drawnChunks++;
+            drawnPolys += (interior[chunk->lod].count + r->count) / 3;
+        }
     }
 
-    if (useVBO) {
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     glDisableVertexAttribArray(aloc_solidsVertex);
     glDisableVertexAttribArray(aloc_solidsNormal);
-    glDisableVertexAttribArray(aloc_solidsColor);
     glDisableVertexAttribArray(aloc_solidsTexcoord);
 }
 
-// Query number of ground polygons
+// Query number of ground polygons drawn in the last frame
 int
 Ground_polyCount(void)
 {
-    return RESOLUTION * RESOLUTION * 2;
+    return drawnPolys;
 }
 
-// Query size of ground VBOs
+// Query number of ground chunks drawn in the last frame, and in total
 int
-Ground_sizeVBO(void)
+Ground_chunkCount(
+    int *total)
 {
-    return VBO_align(sizeof(float3) * MAXSIZE * MAXSIZE) +     // vertices
-           VBO_align(sizeof(float3) * MAXSIZE * MAXSIZE) +     // normals
-           VBO_align(sizeof(float2) * MAXSIZE * MAXSIZE) +     // texcoords
-           VBO_align(sizeof(float3) * MAXSIZE * MAXSIZE);      // colours
+    if (total) *total = chunks * chunks;
+    return drawnChunks;
 }
 
-// Construct ground VBOs
+// Add the bytes of system and video memory held by the terrain
 void
-Ground_buildVBO(void)
-{
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_NAME);
-
-    VBOvertices  = VBO_alloc(sizeof(float3) * MAXSIZE * MAXSIZE);
-    VBOnormals   = VBO_alloc(sizeof(float3) * MAXSIZE * MAXSIZE);
-    VBOtexcoords = VBO_alloc(sizeof(float2) * MAXSIZE * MAXSIZE);
-    VBOcolors    = VBO_alloc(sizeof(float3) * MAXSIZE * MAXSIZE);
-
-    glBufferSubData(GL_ARRAY_BUFFER, VBOvertices,
-                    sizeof(float3) * MAXSIZE * MAXSIZE, vertices);
-    glBufferSubData(GL_ARRAY_BUFFER, VBOnormals,
-                    sizeof(float3) * MAXSIZE * MAXSIZE, normals);
-    glBufferSubData(GL_ARRAY_BUFFER, VBOtexcoords,
-                    sizeof(float2) * MAXSIZE * MAXSIZE, texcoords);
-    glBufferSubData(GL_ARRAY_BUFFER, VBOcolors,
-                    sizeof(float3) * MAXSIZE * MAXSIZE, colors);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+Ground_memoryUsage(
+    unsigned int *cpu,
+    unsigned int *gpu)
+{
+    if (chunkInfo) {
+        *cpu += chunks * chunks * sizeof(Chunk);
+    }
+    *gpu += (unsigned int)(vertexBytes + elementBytes);
 }
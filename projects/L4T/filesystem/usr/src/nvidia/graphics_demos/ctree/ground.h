@@ -31,17 +31,24 @@
 
 #include <GLES2/gl2.h>
 
-// Size of ground mesh
+// Size of each ground chunk (and of one repeat of the ground texture)
 #define GROUND_SIZE 10.0f
 
+// Range of chunk resolutions (cells along each side, power of two)
+#define GROUND_MIN_RESOLUTION 4
+#define GROUND_MAX_RESOLUTION 512
+
 // Initialization and clean-up
+void Ground_setSize(int chunks, int resolution);
 void Ground_initialize(GLuint t);
 void Ground_deinitialize(void);
 
-// Rendering
+// Query
 int  Ground_polyCount(void);
-int  Ground_sizeVBO(void);
-void Ground_buildVBO(void);
-void Ground_draw(int useVBO);
+int  Ground_chunkCount(int *total);
+void Ground_memoryUsage(unsigned int *cpu, unsigned int *gpu);
+
+// Rendering
+void Ground_draw(const float *mvp);
 
 #endif // __GROUND_H
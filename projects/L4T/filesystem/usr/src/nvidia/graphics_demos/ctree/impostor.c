@@ -0,0 +1,400 @@
+/*
+ * impostor.c
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Impostor billboards for distant trees
+//
+
+#include "nvgldemo.h"
+#include "impostor.h"
+#include "tree.h"
+#include "shaders.h"
+
+// Size of the atlas
+#define ATLAS_WIDTH  (IMPOSTOR_COLUMNS * IMPOSTOR_TILE)
+#define ATLAS_HEIGHT \
+    (((IMPOSTOR_VIEWS + IMPOSTOR_COLUMNS - 1) / IMPOSTOR_COLUMNS) * \
+     IMPOSTOR_TILE)
+
+typedef struct {
+    float3 pos;
+    float4 tc;      // Atlas coordinates in the two closest views
+    float  weight;  // Blend weight of the second view
+} ImpostorVertex;
+
+// Fixed lights the views are rendered with. The fireflies move around
+//   and would be frozen into the atlas, so they are approximated by a
+//   soft ring at their average height.
+#define NUM_BAKE_LIGHTS 3
+static const float bakeLightPos[NUM_BAKE_LIGHTS * 3] = {
+     3.0f,  0.0f, 4.0f,
+    -1.5f,  2.6f, 4.0f,
+    -1.5f, -2.6f, 4.0f,
+};
+static const float bakeLightCol[NUM_BAKE_LIGHTS * 3] = {
+    0.8f, 0.8f, 0.7f,
+    0.8f, 0.8f, 0.7f,
+    0.8f, 0.8f, 0.7f,
+};
+
+// Offscreen targets
+static GLuint atlas = 0;
+static GLuint depth = 0;
+static GLuint fbo   = 0;
+
+// Tree geometry the atlas was rendered from
+static int generation = -1;
+
+// Bounding sphere of the tree when the atlas was rendered
+static float3 center;
+static float  radius;
+
+static float distance = IMPOSTOR_DISTANCE;
+
+// CPU and GPU copy of the batched billboards
+static ImpostorVertex *vertices = NULL;
+static int            vertexCount, vertexSize;
+static GLuint         vbo = 0;
+
+GLboolean
+Impostor_initialize(void)
+{
+    glGenTextures(1, &atlas);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    if (NvGlDemoHasGlesVersion(3, 0)) {
+        glTexStorage2D(GL_TEXTURE_2D,
+                       1 + (int)floor(log2(fmax(ATLAS_WIDTH, ATLAS_HEIGHT))),
+                       GL_RGBA8, ATLAS_WIDTH, ATLAS_HEIGHT);
+    } else {
+        // The mip chain is built after the views are rendered
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ATLAS_WIDTH, ATLAS_HEIGHT, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16,
+                          ATLAS_WIDTH, ATLAS_HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, atlas, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                              GL_RENDERBUFFER, depth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+        GL_FRAMEBUFFER_COMPLETE) {
+        NvGlDemoLog("Impostor framebuffer is incomplete\n");
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        Impostor_deinitialize();
+        return GL_FALSE;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenBuffers(1, &vbo);
+
+    generation = -1;
+    Impostor_clear();
+
+    return GL_TRUE;
+}
+
+void
+Impostor_deinitialize(void)
+{
+    if (vbo)   { glDeleteBuffers(1, &vbo); vbo = 0; }
+    if (fbo)   { glDeleteFramebuffers(1, &fbo); fbo = 0; }
+    if (depth) { glDeleteRenderbuffers(1, &depth); depth = 0; }
+    if (atlas) { glDeleteTextures(1, &atlas); atlas = 0; }
+    if (vertices) { FREE(vertices); vertices = NULL; }
+    vertexCount = vertexSize = 0;
+}
+
+void
+Impostor_setDistance(
+    float d)
+{
+    distance = d;
+}
+
+float
+Impostor_getDistance(void)
+{
+    return distance;
+}
+
+// Set up an orthographic view of the bounding sphere, looking
+//   horizontally at the tree from the given angle
+static void
+viewMatrix(
+    float *mvp,
+    int   view)
+{
+    float a = 2.0f * PI * view / IMPOSTOR_VIEWS;
+    float c = COS(a), s = SIN(a);
+    float r = 1.0f / radius;
+
+    // Screen x follows (-s, c, 0), screen y follows z and depth
+    //   increases away from the viewer along (-c, -s, 0)
+    MEMSET(mvp, 0, 16 * sizeof(float));
+    mvp[0]  = -s * r;
+    mvp[4]  =  c * r;
+    mvp[12] = (s * center[0] - c * center[1]) * r;
+    mvp[9]  = r;
+    mvp[13] = -center[2] * r;
+    mvp[2]  = -c * r;
+    mvp[6]  = -s * r;
+    mvp[14] = (c * center[0] + s * center[1]) * r;
+    mvp[15] = 1.0f;
+}
+
+// Set the matrix and the fixed lights on one of the tree shaders
+static void
+setupProgram(
+    GLint       prog,
+    GLint       lights,
+    GLint       lightpos,
+    GLint       lightcol,
+    GLint       mvpmat,
+    const float *mvp)
+{
+    glUseProgram(prog);
+    glUniform1i(lights, NUM_BAKE_LIGHTS);
+    glUniform3fv(lightpos, NUM_BAKE_LIGHTS, bakeLightPos);
+    glUniform3fv(lightcol, NUM_BAKE_LIGHTS, bakeLightCol);
+    glUniformMatrix4fv(mvpmat, 1, GL_FALSE, mvp);
+}
+
+// Render all views of the tree into the atlas
+static void
+renderAtlas(void)
+{
+    GLint   viewport[4];
+    GLint   prevFbo;
+    GLfloat clearColor[4];
+    float   mvp[16];
+    int     v;
+
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFbo);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, ATLAS_WIDTH, ATLAS_HEIGHT);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+
+    Tree_getBounds(center, &radius);
+
+    for (v = 0; v < IMPOSTOR_VIEWS; v++) {
+        glViewport((v % IMPOSTOR_COLUMNS) * IMPOSTOR_TILE,
+                   (v / IMPOSTOR_COLUMNS) * IMPOSTOR_TILE,
+                   IMPOSTOR_TILE, IMPOSTOR_TILE);
+        viewMatrix(mvp, v);
+
+        setupProgram(prog_solids, uloc_solidsLights, uloc_solidsLightPos,
+                     uloc_solidsLightCol, uloc_solidsMvpMat, mvp);
+        setupProgram(prog_leaves, uloc_leavesLights, uloc_leavesLightPos,
+                     uloc_leavesLightCol, uloc_leavesMvpMat, mvp);
+        if (prog_branches) {
+            setupProgram(prog_branches, uloc_branchesLights,
+                         uloc_branchesLightPos, uloc_branchesLightCol,
+                         uloc_branchesMvpMat, mvp);
+        }
+
+        Tree_draw();
+    }
+
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, prevFbo);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+GLboolean
+Impostor_update(void)
+{
+    if (!fbo) return GL_FALSE;
+
+    Tree_update();
+    if (generation == Tree_generation()) return GL_FALSE;
+
+    renderAtlas();
+    generation = Tree_generation();
+    return GL_TRUE;
+}
+
+void
+Impostor_clear(void)
+{
+    vertexCount = 0;
+}
+
+int
+Impostor_count(void)
+{
+    return vertexCount / 6;
+}
+
+static void
+addVertex(
+    const float3 pos,
+    int          side,
+    int          up,
+    int          view0,
+    int          view1,
+    float        weight)
+{
+    ImpostorVertex *v = vertices + vertexCount++;
+    int views[2] = {view0, view1};
+    int i;
+
+    copy_3(v->pos, pos);
+    for (i = 0; i < 2; i++) {
+        float s = (float)((views[i] % IMPOSTOR_COLUMNS) * IMPOSTOR_TILE);
+        float t = (float)((views[i] / IMPOSTOR_COLUMNS) * IMPOSTOR_TILE);
+        s += side ? (IMPOSTOR_TILE - 0.5f) : 0.5f;
+        t += up   ? (IMPOSTOR_TILE - 0.5f) : 0.5f;
+        v->tc[i * 2 + 0] = s / ATLAS_WIDTH;
+        v->tc[i * 2 + 1] = t / ATLAS_HEIGHT;
+    }
+    v->weight = weight;
+}
+
+// Append the billboard for a tree if it is far enough from the eye
+//   (both in scene space, where z is up)
+GLboolean
+Impostor_add(
+    float        x,
+    float        y,
+    float        angle,
+    const float3 eye)
+{
+    float  dx = eye[0] - x;
+    float  dy = eye[1] - y;
+    float  d2 = dx * dx + dy * dy;
+    float  a, ca, sa, view, weight, d;
+    float3 mid, right, corner[4];
+    int    view0, view1, i;
+
+    if (!fbo || (generation < 0) || (d2 < distance * distance)) {
+        return GL_FALSE;
+    }
+
+    if (vertexCount + 6 > vertexSize) {
+        ImpostorVertex *grown;
+        int size = vertexSize ? vertexSize * 2 : 6 * 64;
+        grown = (ImpostorVertex*)REALLOC(vertices,
+                                         size * sizeof(ImpostorVertex));
+        if (!grown) return GL_FALSE;
+        vertices   = grown;
+        vertexSize = size;
+    }
+
+    // Pick the two views around the direction of the eye in tree space
+    a    = degToRadF(angle);
+    view = (ATAN2(dy, dx) - a) * IMPOSTOR_VIEWS / (2.0f * PI);
+    view -= (float)floor(view / IMPOSTOR_VIEWS) * IMPOSTOR_VIEWS;
+    view0  = (int)view;
+    weight = view - view0;
+    view0 %= IMPOSTOR_VIEWS;
+    view1  = (view0 + 1) % IMPOSTOR_VIEWS;
+
+    // Billboard centered on the bounding sphere, turned towards the eye
+    ca = COS(a);
+    sa = SIN(a);
+    set_3(mid, x + ca * center[0] - sa * center[1],
+               y + sa * center[0] + ca * center[1],
+               center[2]);
+    d = SQRT(d2);
+    set_3(right, -dy / d * radius, dx / d * radius, 0.0f);
+    for (i = 0; i < 4; i++) {
+        float side = (i == 1 || i == 2) ? 1.0f : -1.0f;
+        float up   = (i >= 2) ? radius : -radius;
+        set_3(corner[i], mid[0] + side * right[0],
+                         mid[1] + side * right[1],
+                         mid[2] + up);
+    }
+
+    addVertex(corner[0], 0, 0, view0, view1, weight);
+    addVertex(corner[1], 1, 0, view0, view1, weight);
+    addVertex(corner[2], 1, 1, view0, view1, weight);
+    addVertex(corner[0], 0, 0, view0, view1, weight);
+    addVertex(corner[2], 1, 1, view0, view1, weight);
+    addVertex(corner[3], 0, 1, view0, view1, weight);
+
+    return GL_TRUE;
+}
+
+void
+Impostor_draw(
+    const float *mvp)
+{
+    GLboolean cull;
+
+    if (!vertexCount) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(ImpostorVertex),
+                 vertices, GL_STREAM_DRAW);
+
+    glUseProgram(prog_impostor);
+    glUniformMatrix4fv(uloc_impostorMvpMat, 1, GL_FALSE, mvp);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+
+    // The billboards are drawn from both sides
+    cull = glIsEnabled(GL_CULL_FACE);
+    glDisable(GL_CULL_FACE);
+
+    glEnableVertexAttribArray(aloc_impostorVertex);
+    glEnableVertexAttribArray(aloc_impostorTexcoord);
+    glEnableVertexAttribArray(aloc_impostorWeight);
+    glVertexAttribPointer(aloc_impostorVertex,
+                          3, GL_FLOAT, GL_FALSE, sizeof(ImpostorVertex),
+                          (void*)0);
+    glVertexAttribPointer(aloc_impostorTexcoord,
+                          4, GL_FLOAT, GL_FALSE, sizeof(ImpostorVertex),
+                          (void*)sizeof(float3));
+    glVertexAttribPointer(aloc_impostorWeight,
+                          1, GL_FLOAT, GL_FALSE, sizeof(ImpostorVertex),
+                          (void*)(sizeof(float3) + sizeof(float4)));
+    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    glDisableVertexAttribArray(aloc_impostorVertex);
+    glDisableVertexAttribArray(aloc_impostorTexcoord);
+    glDisableVertexAttribArray(aloc_impostorWeight);
+
+    if (cull) {
+        glEnable(GL_CULL_FACE);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,72 @@
+/*
+ * impostor.h
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Impostor billboards for distant trees
+//
+// The tree is rendered from IMPOSTOR_VIEWS directions around its trunk
+//   into a texture atlas through an offscreen framebuffer. Trees beyond
+//   the impostor distance are then drawn as camera facing quads which
+//   blend the two atlas views closest to the viewing direction, all with
+//   a single draw call. The atlas is only rendered again when the tree
+//   geometry is rebuilt.
+//
+
+#ifndef __IMPOSTOR_H
+#define __IMPOSTOR_H
+
+#include <GLES2/gl2.h>
+#include "vector.h"
+
+// Number of views around the tree and their layout in the atlas
+#define IMPOSTOR_VIEWS   8
+#define IMPOSTOR_COLUMNS 4
+#define IMPOSTOR_TILE    256
+
+// Default distance beyond which trees are drawn as impostors
+#define IMPOSTOR_DISTANCE 40.0f
+
+// Initialization and clean-up
+GLboolean Impostor_initialize(void);
+void      Impostor_deinitialize(void);
+
+// Distance beyond which trees are replaced
+void  Impostor_setDistance(float distance);
+float Impostor_getDistance(void);
+
+// Render the atlas again if the tree geometry changed. This overwrites
+//   the matrix and lighting uniforms of the tree shaders, so it returns
+//   GL_TRUE when the caller needs to restore them.
+GLboolean Impostor_update(void);
+
+// Geometry batching
+//   (Add returns GL_FALSE if the tree is too close for an impostor.)
+void      Impostor_clear(void);
+GLboolean Impostor_add(float x, float y, float angle, const float3 eye);
+int       Impostor_count(void);
+
+// Rendering
+void Impostor_draw(const float *mvp);
+
+#endif // __IMPOSTOR_H
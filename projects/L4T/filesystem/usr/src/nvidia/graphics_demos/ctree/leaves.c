@@ -32,6 +32,7 @@
 #include "array.h"
 #include "vector.h"
 #include "shaders.h"
+#include "meshcache.h"
 
 // Leaf textures
 static GLuint texture;
@@ -41,6 +42,11 @@ static GLuint backTexture;
 static float radius;
 static int count;
 
+// Random state for the leaf colors, restarted with every tree so that
+//   they don't depend on the fireflies
+#define COLOR_SEED 4711.0
+static double colorSeed = COLOR_SEED;
+
 // Leaf vertex info
 static Array vertices;
 static Array normals;
@@ -48,6 +54,11 @@ static Array normalsBack;
 static Array colors;
 static Array texcoords;
 
+// Leaf arrays in mesh cache stream order
+static Array *const streamArrays[] = {
+    &vertices, &normals, &normalsBack, &colors, &texcoords
+};
+
 // VBOs for leaf vertices
 static unsigned long VBOvertices, VBOnormals, VBOnormalsBack, VBOcolors;
 static unsigned long VBOtexcoords;
@@ -94,6 +105,7 @@ Leaves_clear(void)
     Array_clear(&colors);
     Array_clear(&texcoords);
     count = 0;
+    colorSeed = COLOR_SEED;
 }
 
 void
@@ -151,10 +163,10 @@ Leaves_add(
     ++count;
 
     for (i=0; i<3; i++) {
-        c0[i] = (float) GetRandom();
-        c1[i] = (float) GetRandom();
-        c2[i] = (float) GetRandom();
-        c3[i] = (float) GetRandom();
+        c0[i] = (float) GetRandomFrom(&colorSeed);
+        c1[i] = (float) GetRandomFrom(&colorSeed);
+        c2[i] = (float) GetRandomFrom(&colorSeed);
+        c3[i] = (float) GetRandomFrom(&colorSeed);
     }
 
     add_a_set(front, back, t0, v0, c0, mat);
@@ -262,15 +274,116 @@ Leaves_buildVBO(void)
     VBOcolors       = VBO_alloc(v * 3 * sizeof(float));
     VBOtexcoords    = VBO_alloc(v * 2 * sizeof(float));
 
-    glBufferSubData(GL_ARRAY_BUFFER, VBOvertices, v * 3 * sizeof(float),
-                    vertices.buffer);
-    glBufferSubData(GL_ARRAY_BUFFER, VBOnormals, v * 3 * sizeof(float),
-                    normals.buffer);
-    glBufferSubData(GL_ARRAY_BUFFER, VBOnormalsBack, v * 3 * sizeof(float),
-                    normalsBack.buffer);
-    glBufferSubData(GL_ARRAY_BUFFER, VBOcolors, v * 3 * sizeof(float),
-                    colors.buffer);
-    glBufferSubData(GL_ARRAY_BUFFER, VBOtexcoords, v * 2 * sizeof(float),
-                    texcoords.buffer);
+    VBO_write(VBOvertices,    v * 3 * sizeof(float), vertices.buffer);
+    VBO_write(VBOnormals,     v * 3 * sizeof(float), normals.buffer);
+    VBO_write(VBOnormalsBack, v * 3 * sizeof(float), normalsBack.buffer);
+    VBO_write(VBOcolors,      v * 3 * sizeof(float), colors.buffer);
+    VBO_write(VBOtexcoords,   v * 2 * sizeof(float), texcoords.buffer);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
+
+// Free the CPU copies of the leaf vertices once they are in the VBO
+void
+Leaves_release(void)
+{
+    Array_release(&vertices);
+    Array_release(&normals);
+    Array_release(&normalsBack);
+    Array_release(&colors);
+    Array_release(&texcoords);
+}
+
+// Add the bytes of system memory held by the leaf vertices
+void
+Leaves_memoryUsage(
+    unsigned int *cpu)
+{
+    *cpu += vertices.buffSize + normals.buffSize + normalsBack.buffSize +
+            colors.buffSize + texcoords.buffSize;
+}
+
+// Grow a bounding box to include all leaf vertices
+void
+Leaves_extendBounds(
+    float3 lo,
+    float3 hi)
+{
+    int i, j;
+
+    for (i = 0; i < vertices.elemCount; i++) {
+        float *v = (float*)Array_get(&vertices, i);
+        for (j = 0; j < 3; j++) {
+            lo[j] = min(lo[j], v[j]);
+            hi[j] = max(hi[j], v[j]);
+        }
+    }
+}
+
+// Query the front or back leaf texture
+GLuint
+Leaves_getTexture(
+    GLboolean back)
+{
+    return back ? backTexture : texture;
+}
+
+// Point the given attributes at the leaf VBO data. VBO_NAME must be
+//   bound to GL_ARRAY_BUFFER.
+void
+Leaves_bindVBO(
+    GLint     vertex,
+    GLint     normal,
+    GLint     color,
+    GLint     texcoord,
+    GLboolean back)
+{
+    glVertexAttribPointer(vertex,
+                          3, GL_FLOAT, GL_FALSE, 0, (void*)VBOvertices);
+    glVertexAttribPointer(normal,
+                          3, GL_FLOAT, GL_FALSE, 0,
+                          (void*)(back ? VBOnormalsBack : VBOnormals));
+    glVertexAttribPointer(color,
+                          3, GL_FLOAT, GL_FALSE, 0, (void*)VBOcolors);
+    glVertexAttribPointer(texcoord,
+                          2, GL_FLOAT, GL_FALSE, 0, (void*)VBOtexcoords);
+}
+
+// Fill in the mesh cache streams of the leaves
+void
+Leaves_getStreams(
+    MeshStream *streams)
+{
+    int i;
+
+    for (i = 0; i < MESH_BRANCH_VERTICES; i++) {
+        streams[MESH_LEAF_VERTICES + i].data     = streamArrays[i]->buffer;
+        streams[MESH_LEAF_VERTICES + i].count    = streamArrays[i]->elemCount;
+        streams[MESH_LEAF_VERTICES + i].elemSize = streamArrays[i]->elemSize;
+    }
+}
+
+// Use mesh cache streams as the leaf data, after checking that they fit
+//   together. The streams must stay mapped until the leaves are cleared.
+GLboolean
+Leaves_setStreams(
+    const MeshStream *streams,
+    int              leafCount)
+{
+    int i;
+
+    Leaves_clear();
+    for (i = 0; i < MESH_BRANCH_VERTICES; i++) {
+        const MeshStream *s = &streams[MESH_LEAF_VERTICES + i];
+        if ((s->elemSize != streamArrays[i]->elemSize) ||
+            (s->count != leafCount * 6)) {
+            return GL_FALSE;
+        }
+    }
+
+    for (i = 0; i < MESH_BRANCH_VERTICES; i++) {
+        const MeshStream *s = &streams[MESH_LEAF_VERTICES + i];
+        Array_wrap(streamArrays[i], s->data, s->count);
+    }
+    count = leafCount;
+    return GL_TRUE;
+}
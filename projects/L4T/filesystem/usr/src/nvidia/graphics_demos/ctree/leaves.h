@@ -31,6 +31,7 @@
 
 #include <GLES2/gl2.h>
 #include "vector.h"
+#include "meshcache.h"
 
 // Initialization and clean-up
 void Leaves_initialize(GLuint front, GLuint back, float radius);
@@ -38,14 +39,24 @@ void Leaves_deinitialize(void);
 void Leaves_clear(void);
 void Leaves_setRadius(float r);
 void Leaves_add(float4x4 m);
+void Leaves_release(void);
 
 // Query
 int Leaves_polyCount(void);
 int Leaves_leafCount(void);
 int Leaves_sizeVBO(void);
+void Leaves_extendBounds(float3 lo, float3 hi);
+GLuint Leaves_getTexture(GLboolean back);
+void Leaves_memoryUsage(unsigned int *cpu);
+
+// Mesh cache
+void Leaves_getStreams(MeshStream *streams);
+GLboolean Leaves_setStreams(const MeshStream *streams, int leafCount);
 
 // Rendering
 void Leaves_buildVBO(void);
 void Leaves_draw(int use_VBO);
+void Leaves_bindVBO(GLint vertex, GLint normal, GLint color, GLint texcoord,
+                    GLboolean back);
 
 #endif // __LEAVES_H
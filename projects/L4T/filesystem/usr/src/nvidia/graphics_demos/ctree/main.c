@@ -67,8 +67,14 @@ int main(int argc, char **argv)
     GLboolean   fpsFlag  = GL_FALSE;
     GLboolean   demoMode = GL_FALSE;
     GLboolean   startup  = GL_FALSE;
+    int         terrain[2];
+    float       impostorDistance;
+    char        meshCacheDir[256];
+    int         seed;
 
     // Initialize window system and EGL
+    // (A version 2 request gives the newest compatible context. The
+    //  OpenGL ES 3 paths check GL_VERSION at runtime and fall back.)
     if (!NvGlDemoInitialize(&argc, argv, "ctree", 2, 8, 0)) {
         goto done;
     }
@@ -95,6 +101,49 @@ int main(int argc, char **argv)
             Screen_setNoSky();
         }
 
+        // Expand branch cylinders on the GPU
+        else if (NvGlDemoArgMatch(&argc, argv, 1, "-gpubranches")) {
+            Screen_setGPUBranches();
+        }
+
+        // Cull and draw the forest on the GPU
+        else if (NvGlDemoArgMatch(&argc, argv, 1, "-gpuforest")) {
+            Screen_setGPUForest();
+        }
+
+        // Keep the tree geometry only in video memory
+        else if (NvGlDemoArgMatch(&argc, argv, 1, "-resident")) {
+            Screen_setResident();
+        }
+
+        // Cache generated trees in a directory
+        else if (NvGlDemoArgMatchStr(&argc, argv, 1, "-meshcache",
+                                     "<dir>", sizeof(meshCacheDir),
+                                     meshCacheDir)) {
+            Screen_setMeshCache(meshCacheDir);
+        }
+
+        // Tree character
+        else if (NvGlDemoArgMatchInt(&argc, argv, 1, "-seed",
+                                     "<n>", 0, 0x7fffffff,
+                                     1, &seed)) {
+            Screen_setSeed(seed);
+        }
+
+        // Draw distant trees as impostors
+        else if (NvGlDemoArgMatchFlt(&argc, argv, 1, "-impostors",
+                                     "<distance>", 1.0f, 1000.0f,
+                                     1, &impostorDistance)) {
+            Screen_setImpostors(impostorDistance);
+        }
+
+        // Terrain size
+        else if (NvGlDemoArgMatchInt(&argc, argv, 1, "-terrain",
+                                     "<chunks> <resolution>", 1, 512,
+                                     2, terrain)) {
+            Screen_setTerrain(terrain[0], terrain[1]);
+        }
+
         // FPS output
         else if (NvGlDemoArgMatch(&argc, argv, 1, "-fps")) {
             fpsFlag = GL_TRUE;
@@ -172,6 +221,23 @@ int main(int argc, char **argv)
                     "    [-nomenu]\n"
                     "  Disable rendering of the sky:\n"
                     "    [-nosky]\n"
+                    "  Expand branch cylinders on the GPU:\n"
+                    "    [-gpubranches]\n"
+                    "  Cull and draw the forest on the GPU (OpenGL ES 3.1):\n"
+                    "    [-gpuforest]\n"
+                    "  Draw trees beyond <distance> as impostor billboards:\n"
+                    "    [-impostors <distance>]\n"
+                    "  Free the CPU copies of the tree geometry after upload\n"
+                    "  (OpenGL ES 3.0):\n"
+                    "    [-resident]\n"
+                    "  Load and save generated trees in directory <dir>\n"
+                    "  (relative to the current directory):\n"
+                    "    [-meshcache <dir>]\n"
+                    "  Select the character of the first tree:\n"
+                    "    [-seed <n>]\n"
+                    "  Set the terrain to <chunks>x<chunks> tiles of\n"
+                    "  <resolution>x<resolution> cells (default 8 32):\n"
+                    "    [-terrain <chunks> <resolution>]\n"
                     "  Turn on framerate logging:\n"
                     "    [-fps]\n");
         NvGlDemoLog(NvGlDemoArgUsageString());
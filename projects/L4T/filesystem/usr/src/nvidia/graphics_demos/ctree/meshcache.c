@@ -0,0 +1,222 @@
+/*
+ * meshcache.c
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Cache of generated tree meshes
+//
+
+#include "nvgldemo.h"
+#include "meshcache.h"
+#include "buildtree.h"
+#include "branches.h"
+#include "leaves.h"
+
+#define ALIGN(v, a) (((v) + (a) - 1) & ~((a) - 1))
+
+// Cache directory, relative to the current directory like all demo files
+static char directory[256] = "";
+
+// Mapping of the currently loaded cache file
+static const unsigned char *mapping = NULL;
+static unsigned int        mappingSize = 0;
+
+void
+MeshCache_setDirectory(
+    const char *dir)
+{
+    directory[0] = '\0';
+    if (dir) {
+        STRNCPY(directory, dir, sizeof(directory) - 1);
+        directory[sizeof(directory) - 1] = '\0';
+    }
+}
+
+GLboolean
+MeshCache_enabled(void)
+{
+    return directory[0] ? GL_TRUE : GL_FALSE;
+}
+
+// Fill in the header fields identifying the current tree
+static void
+fillKey(
+    MeshCacheHeader *h)
+{
+    MEMSET(h, 0, sizeof(MeshCacheHeader));
+    h->magic       = MESHCACHE_MAGIC;
+    h->version     = MESHCACHE_VERSION;
+    h->seed        = BuildTree_getSeed();
+    h->flags       = Branches_isGPU() ? MESHCACHE_GPU_BRANCHES : 0;
+    h->facets      = BRANCHES_FACETS;
+    h->streamCount = MESH_NUM_STREAMS;
+    MEMCPY(h->params, treeParams, sizeof(h->params));
+}
+
+// Cache file name of a tree, named after a hash (FNV-1a) of its key
+static void
+fileName(
+    const MeshCacheHeader *h,
+    char                  *name,
+    int                   size)
+{
+    const unsigned char *p = (const unsigned char*)h;
+    unsigned int key = 2166136261U;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(MeshCacheHeader); i++) {
+        key = (key ^ p[i]) * 16777619U;
+    }
+    SNPRINTF(name, size, "%s/ctree_%08x.mesh", directory, key);
+}
+
+GLboolean
+MeshCache_load(void)
+{
+    MeshCacheHeader       key;
+    const MeshCacheHeader *h;
+    const MeshCacheStream *s;
+    MeshStream            streams[MESH_NUM_STREAMS];
+    char                  name[300];
+    int                   i;
+
+    MeshCache_release();
+    if (!MeshCache_enabled()) return GL_FALSE;
+
+    fillKey(&key);
+    fileName(&key, name, sizeof(name));
+
+    // A missing file is the normal case for a new tree
+    mapping = (const unsigned char*)NvGlDemoMapFile(name, &mappingSize);
+    if (!mapping) return GL_FALSE;
+
+    // Check that the file really holds this tree. The leaf count is the
+    //   only header field which is not part of the key.
+    h = (const MeshCacheHeader*)mapping;
+    if ((mappingSize < sizeof(MeshCacheHeader) +
+                       MESH_NUM_STREAMS * sizeof(MeshCacheStream))) {
+        goto fail;
+    }
+    key.leafCount = h->leafCount;
+    if (MEMCMP(&key, h, sizeof(MeshCacheHeader))) {
+        goto fail;
+    }
+
+    s = (const MeshCacheStream*)(h + 1);
+    for (i = 0; i < MESH_NUM_STREAMS; i++) {
+        if ((s[i].offset % MESHCACHE_ALIGNMENT) ||
+            (s[i].offset > mappingSize) ||
+            (s[i].elemSize &&
+             (s[i].count > (mappingSize - s[i].offset) / s[i].elemSize))) {
+            goto fail;
+        }
+        streams[i].data     = mapping + s[i].offset;
+        streams[i].count    = s[i].count;
+        streams[i].elemSize = s[i].elemSize;
+    }
+
+    if (!Leaves_setStreams(streams, h->leafCount) ||
+        !Branches_setStreams(streams)) {
+        Leaves_clear();
+        Branches_clear();
+        goto fail;
+    }
+
+    return GL_TRUE;
+
+    fail:
+    NvGlDemoLog("Ignoring invalid mesh cache file %s\n", name);
+    MeshCache_release();
+    return GL_FALSE;
+}
+
+void
+MeshCache_release(void)
+{
+    NvGlDemoUnmapFile((void*)mapping, mappingSize);
+    mapping = NULL;
+    mappingSize = 0;
+}
+
+GLboolean
+MeshCache_save(void)
+{
+    static const unsigned char zeros[MESHCACHE_ALIGNMENT];
+    MeshCacheHeader header;
+    MeshCacheStream table[MESH_NUM_STREAMS];
+    MeshStream      streams[MESH_NUM_STREAMS];
+    char            name[300], path[310], temp[320];
+    unsigned int    offset;
+    GLboolean       ok;
+    FILE            *f;
+    int             i;
+
+    if (!MeshCache_enabled()) return GL_FALSE;
+
+    fillKey(&header);
+    header.leafCount = Leaves_leafCount();
+    fileName(&header, name, sizeof(name));
+
+    MEMSET(streams, 0, sizeof(streams));
+    Leaves_getStreams(streams);
+    Branches_getStreams(streams);
+
+    // Lay out the streams after the table
+    MEMSET(table, 0, sizeof(table));
+    offset = sizeof(header) + sizeof(table);
+    for (i = 0; i < MESH_NUM_STREAMS; i++) {
+        offset = ALIGN(offset, MESHCACHE_ALIGNMENT);
+        table[i].count    = streams[i].count;
+        table[i].elemSize = streams[i].elemSize;
+        table[i].offset   = offset;
+        offset += streams[i].count * streams[i].elemSize;
+    }
+
+    // Write to a temporary file first, so that a concurrently starting
+    //   instance never maps a partial file
+    SNPRINTF(path, sizeof(path), "./%s", name);
+    SNPRINTF(temp, sizeof(temp), "%s.tmp", path);
+    if (!(f = fopen(temp, "wb"))) {
+        NvGlDemoLog("Unable to create mesh cache file %s\n", path);
+        return GL_FALSE;
+    }
+
+    ok = (fwrite(&header, sizeof(header), 1, f) == 1) &&
+         (fwrite(table, sizeof(table), 1, f) == 1);
+    for (i = 0; ok && (i < MESH_NUM_STREAMS); i++) {
+        long pos = ftell(f);
+        unsigned int size = streams[i].count * streams[i].elemSize;
+        ok = (fwrite(zeros, 1, table[i].offset - pos, f) ==
+              table[i].offset - pos) &&
+             (!size || (fwrite(streams[i].data, size, 1, f) == 1));
+    }
+    ok = (fclose(f) == 0) && ok;
+
+    if (!ok || rename(temp, path)) {
+        NvGlDemoLog("Unable to write mesh cache file %s\n", path);
+        remove(temp);
+        return GL_FALSE;
+    }
+
+    return GL_TRUE;
+}
@@ -0,0 +1,111 @@
+/*
+ * meshcache.h
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Cache of generated tree meshes
+//
+// Generated trees are written to a binary file named after a hash of
+//   everything the generator depends on (the tree parameters, the
+//   character seed and the branch mode). When the same tree is needed
+//   again the file is mapped and its streams are uploaded straight from
+//   the mapping, so the tree doesn't have to be generated at all.
+//
+// Layout (native endian, as the file is only read on the machine which
+//   wrote it):
+//   MeshCacheHeader
+//   MeshCacheStream[MESH_NUM_STREAMS]
+//   stream data, each stream aligned to MESHCACHE_ALIGNMENT
+//
+// The branch strips are all BRANCHES_FACETS + 1 vertex pairs long, so the
+//   index stream also defines the draw ranges. The leaf count gives the
+//   number of leaf records, six vertices each.
+//
+
+#ifndef __MESHCACHE_H
+#define __MESHCACHE_H
+
+#include <stdint.h>
+#include <GLES2/gl2.h>
+#include "tree.h"
+
+#define MESHCACHE_MAGIC     0x4d485443 // "CTHM"
+#define MESHCACHE_VERSION   1
+#define MESHCACHE_ALIGNMENT 64
+
+// Mesh streams
+typedef enum {
+    MESH_LEAF_VERTICES,
+    MESH_LEAF_NORMALS,
+    MESH_LEAF_NORMALS_BACK,
+    MESH_LEAF_COLORS,
+    MESH_LEAF_TEXCOORDS,
+    MESH_BRANCH_VERTICES,
+    MESH_BRANCH_NORMALS,
+    MESH_BRANCH_TEXCOORDS,
+    MESH_BRANCH_INDICES,
+    MESH_BRANCH_SEGMENTS,
+    MESH_NUM_STREAMS
+} MeshStreamId;
+
+// Flags
+#define MESHCACHE_GPU_BRANCHES 0x1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seed;                      // Character seed
+    uint32_t flags;
+    uint32_t facets;                    // BRANCHES_FACETS
+    uint32_t leafCount;
+    float    params[NUM_TREE_PARAMS];
+    uint32_t streamCount;               // MESH_NUM_STREAMS
+} MeshCacheHeader;
+
+typedef struct {
+    uint32_t count;                     // Number of elements
+    uint32_t elemSize;                  // Bytes per element
+    uint32_t offset;                    // File offset of the data
+    uint32_t reserved;
+} MeshCacheStream;
+
+// In memory view of a stream
+typedef struct {
+    const void *data;
+    int        count;
+    int        elemSize;
+} MeshStream;
+
+// Select the directory holding the cache files (NULL disables the cache)
+void MeshCache_setDirectory(const char *dir);
+GLboolean MeshCache_enabled(void);
+
+// Map the cache file of the current tree and hand its streams to the
+//   leaves and branches. The mapping stays valid until MeshCache_release.
+GLboolean MeshCache_load(void);
+void      MeshCache_release(void);
+
+// Write the current tree geometry to its cache file
+GLboolean MeshCache_save(void);
+
+#endif // __MESHCACHE_H
@@ -0,0 +1,231 @@
+/*
+ * mkassetpack.c
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Host tool which packs TGA files into a ctree asset pack
+//
+// Host compile line: cc -o mkassetpack mkassetpack.c
+// Usage: mkassetpack [-mips] -o <pack> <file.tga> ...
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ASSETPACK_FORMAT_ONLY
+#include "assetpack.h"
+
+#define ALIGN(v, a) (((v) + (a) - 1) & ~((a) - 1))
+
+typedef struct {
+    AssetPackEntry entry;
+    unsigned char  *level[ASSETPACK_MAX_LEVELS];
+} Texture;
+
+static unsigned int
+dim(
+    unsigned int v,
+    unsigned int level)
+{
+    v >>= level;
+    return v ? v : 1;
+}
+
+// Read an uncompressed RGB/RGBA TGA file and swizzle it to RGB(A) order
+static int
+loadTga(
+    const char *filename,
+    Texture    *tex)
+{
+    unsigned char hdr[18];
+    unsigned int  i, size;
+    const char    *base, *dot;
+    size_t        len;
+    FILE          *f;
+
+    if (!(f = fopen(filename, "rb"))) {
+        fprintf(stderr, "Unable to open %s\n", filename);
+        return 0;
+    }
+    if ((fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr)) ||
+        (hdr[1] != 0) || (hdr[2] != 2) ||
+        ((hdr[16] != 24) && (hdr[16] != 32))) {
+        fprintf(stderr, "%s: only uncompressed RGB/RGBA tga is supported\n",
+                filename);
+        fclose(f);
+        return 0;
+    }
+
+    memset(tex, 0, sizeof(Texture));
+    tex->entry.width  = ((unsigned int)hdr[13] << 8) | hdr[12];
+    tex->entry.height = ((unsigned int)hdr[15] << 8) | hdr[14];
+    tex->entry.bpp    = hdr[16] >> 3;
+    tex->entry.levels = 1;
+
+    // Entry name is the file name without directory and extension
+    base = strrchr(filename, '/');
+    base = base ? base + 1 : filename;
+    dot  = strrchr(base, '.');
+    len  = dot ? (size_t)(dot - base) : strlen(base);
+    if (len >= ASSETPACK_NAME_LEN) {
+        fprintf(stderr, "%s: name is too long\n", filename);
+        fclose(f);
+        return 0;
+    }
+    memcpy(tex->entry.name, base, len);
+
+    // Skip the optional image ID field
+    fseek(f, sizeof(hdr) + hdr[0], SEEK_SET);
+
+    size = tex->entry.width * tex->entry.height * tex->entry.bpp;
+    tex->level[0] = (unsigned char*)malloc(size);
+    if (!tex->level[0] || (fread(tex->level[0], 1, size, f) != size)) {
+        fprintf(stderr, "%s: truncated image data\n", filename);
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+
+    for (i = 0; i < size; i += tex->entry.bpp) {
+        unsigned char c = tex->level[0][i];
+        tex->level[0][i] = tex->level[0][i + 2];
+        tex->level[0][i + 2] = c;
+    }
+
+    return 1;
+}
+
+// Append the 2x2 box filtered mip chain (power of two textures only)
+static void
+buildMips(
+    Texture *tex)
+{
+    AssetPackEntry *e = &tex->entry;
+    unsigned int l, x, y, c;
+
+    if ((e->width & (e->width - 1)) || (e->height & (e->height - 1))) {
+        return;
+    }
+
+    for (l = 1; (dim(e->width, l - 1) > 1) || (dim(e->height, l - 1) > 1);
+         l++) {
+        unsigned int sw = dim(e->width, l - 1), sh = dim(e->height, l - 1);
+        unsigned int dw = dim(e->width, l),     dh = dim(e->height, l);
+        unsigned int sx = (sw > 1) ? 1 : 0,     sy = (sh > 1) ? sw : 0;
+        const unsigned char *src = tex->level[l - 1];
+        unsigned char *dst;
+
+        if (l >= ASSETPACK_MAX_LEVELS) break;
+        dst = tex->level[l] = (unsigned char*)malloc(dw * dh * e->bpp);
+
+        for (y = 0; y < dh; y++) {
+            for (x = 0; x < dw; x++) {
+                unsigned int s = ((y * 2 * sw) + x * 2) * e->bpp;
+                for (c = 0; c < e->bpp; c++) {
+                    *dst++ = (src[s + c] +
+                              src[s + sx * e->bpp + c] +
+                              src[s + sy * e->bpp + c] +
+                              src[s + (sx + sy) * e->bpp + c] + 2) >> 2;
+                }
+            }
+        }
+        e->levels = l + 1;
+    }
+}
+
+int
+main(
+    int  argc,
+    char **argv)
+{
+    const char      *outname = NULL;
+    int             mips = 0;
+    Texture         *tex;
+    AssetPackHeader header;
+    unsigned int    count = 0, offset, i, l;
+    static const unsigned char zeros[ASSETPACK_ALIGNMENT];
+    FILE            *f;
+
+    tex = (Texture*)calloc(argc, sizeof(Texture));
+    for (i = 1; i < (unsigned int)argc; i++) {
+        if (!strcmp(argv[i], "-mips")) {
+            mips = 1;
+        } else if (!strcmp(argv[i], "-o") && (i + 1 < (unsigned int)argc)) {
+            outname = argv[++i];
+        } else {
+            if (!loadTga(argv[i], &tex[count])) return 1;
+            if (mips) buildMips(&tex[count]);
+            count++;
+        }
+    }
+    if (!outname || !count) {
+        fprintf(stderr,
+                "Usage: %s [-mips] -o <pack> <file.tga> ...\n", argv[0]);
+        return 1;
+    }
+
+    // Lay out the payloads after the index
+    offset = sizeof(AssetPackHeader) + count * sizeof(AssetPackEntry);
+    for (i = 0; i < count; i++) {
+        AssetPackEntry *e = &tex[i].entry;
+        offset = ALIGN(offset, ASSETPACK_ALIGNMENT);
+        for (l = 0; l < e->levels; l++) {
+            offset = ALIGN(offset, ASSETPACK_LEVEL_ALIGNMENT);
+            e->offset[l] = offset;
+            offset += dim(e->width, l) * dim(e->height, l) * e->bpp;
+        }
+    }
+
+    if (!(f = fopen(outname, "wb"))) {
+        fprintf(stderr, "Unable to create %s\n", outname);
+        return 1;
+    }
+
+    header.magic    = ASSETPACK_MAGIC;
+    header.version  = ASSETPACK_VERSION;
+    header.count    = count;
+    header.reserved = 0;
+    fwrite(&header, sizeof(header), 1, f);
+    for (i = 0; i < count; i++) {
+        fwrite(&tex[i].entry, sizeof(AssetPackEntry), 1, f);
+    }
+    for (i = 0; i < count; i++) {
+        AssetPackEntry *e = &tex[i].entry;
+        for (l = 0; l < e->levels; l++) {
+            long pos = ftell(f);
+            fwrite(zeros, 1, e->offset[l] - pos, f);
+            fwrite(tex[i].level[l], 1,
+                   dim(e->width, l) * dim(e->height, l) * e->bpp, f);
+            free(tex[i].level[l]);
+        }
+    }
+
+    if (fclose(f) != 0) {
+        fprintf(stderr, "Unable to write %s\n", outname);
+        return 1;
+    }
+    free(tex);
+
+    return 0;
+}
@@ -0,0 +1,314 @@
+/*
+ * overlay.c
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Batched overlay rendering
+//
+
+#include "nvgldemo.h"
+#include "overlay.h"
+#include "shaders.h"
+
+// Gap left between atlas images so linear filtering doesn't bleed
+#define ATLAS_PADDING 2
+
+typedef struct {
+    float2 pos;
+    float3 col;
+} ColVertex;
+
+typedef struct {
+    float2 pos;
+    float2 tc;
+} TexVertex;
+
+// Image atlas and the shelf it is currently being filled from
+static GLuint    atlas = 0;
+static int       shelfX, shelfY, shelfHeight;
+static GLboolean atlasDirty;
+
+// CPU copy of the batched geometry
+static ColVertex colVertices[OVERLAY_MAX_COL_VERTS];
+static TexVertex texVertices[OVERLAY_MAX_TEX_VERTS];
+static int       colCount, texCount;
+
+// GPU copy of the batched geometry, colored vertices followed by textured
+static GLuint    vbo = 0;
+static GLboolean vboDirty;
+
+GLboolean
+Overlay_initialize(void)
+{
+    glGenTextures(1, &atlas);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    if (NvGlDemoHasGlesVersion(3, 0)) {
+        glTexStorage2D(GL_TEXTURE_2D,
+                       1 + (int)floor(log2(fmax(OVERLAY_ATLAS_WIDTH,
+                                                OVERLAY_ATLAS_HEIGHT))),
+                       GL_RGBA8, OVERLAY_ATLAS_WIDTH, OVERLAY_ATLAS_HEIGHT);
+    } else {
+        // Overlay_draw builds the mip chain once images are added
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+                     OVERLAY_ATLAS_WIDTH, OVERLAY_ATLAS_HEIGHT, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+
+    glGenBuffers(1, &vbo);
+
+    shelfX = shelfY = shelfHeight = 0;
+    atlasDirty = GL_FALSE;
+    Overlay_clear();
+
+    if (!atlas || !vbo) {
+        NvGlDemoLog("Unable to create overlay resources\n");
+        return GL_FALSE;
+    }
+    return GL_TRUE;
+}
+
+void
+Overlay_deinitialize(void)
+{
+    if (vbo)   { glDeleteBuffers(1, &vbo); vbo = 0; }
+    if (atlas) { glDeleteTextures(1, &atlas); atlas = 0; }
+}
+
+GLboolean
+Overlay_addImage(
+    const unsigned char *pixels,
+    int                 width,
+    int                 height,
+    int                 bpp,
+    float4              rect)
+{
+    unsigned char *rgba = NULL;
+    int i;
+
+    // Start a new shelf if the image doesn't fit on the current one
+    if (shelfX + width > OVERLAY_ATLAS_WIDTH) {
+        shelfX = 0;
+        shelfY += shelfHeight + ATLAS_PADDING;
+        shelfHeight = 0;
+    }
+    if ((width > OVERLAY_ATLAS_WIDTH) ||
+        (shelfY + height > OVERLAY_ATLAS_HEIGHT)) {
+        NvGlDemoLog("Overlay atlas out of space\n");
+        return GL_FALSE;
+    }
+
+    // The atlas is RGBA, so expand RGB images
+    if (bpp == 3) {
+        rgba = (unsigned char*)MALLOC(width * height * 4);
+        if (!rgba) return GL_FALSE;
+        for (i = 0; i < width * height; i++) {
+            rgba[i*4+0] = pixels[i*3+0];
+            rgba[i*4+1] = pixels[i*3+1];
+            rgba[i*4+2] = pixels[i*3+2];
+            rgba[i*4+3] = 0xff;
+        }
+        pixels = rgba;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, shelfX, shelfY, width, height,
+                    GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    if (rgba) FREE(rgba);
+
+    // Return the region inset by half a texel
+    rect[0] = (shelfX + 0.5f)          / OVERLAY_ATLAS_WIDTH;
+    rect[1] = (shelfY + 0.5f)          / OVERLAY_ATLAS_HEIGHT;
+    rect[2] = (shelfX + width - 0.5f)  / OVERLAY_ATLAS_WIDTH;
+    rect[3] = (shelfY + height - 0.5f) / OVERLAY_ATLAS_HEIGHT;
+
+    shelfX += width + ATLAS_PADDING;
+    if (height > shelfHeight) shelfHeight = height;
+    atlasDirty = GL_TRUE;
+
+    return GL_TRUE;
+}
+
+void
+Overlay_clear(void)
+{
+    colCount = texCount = 0;
+    vboDirty = GL_TRUE;
+}
+
+static void
+addColVertex(
+    const float2 v,
+    const float3 c)
+{
+    if (colCount >= OVERLAY_MAX_COL_VERTS) return;
+    copy_2(colVertices[colCount].pos, v);
+    copy_3(colVertices[colCount].col, c);
+    colCount++;
+}
+
+static void
+addTexVertex(
+    float x,
+    float y,
+    float s,
+    float t)
+{
+    if (texCount >= OVERLAY_MAX_TEX_VERTS) return;
+    set_2(texVertices[texCount].pos, x, y);
+    set_2(texVertices[texCount].tc, s, t);
+    texCount++;
+}
+
+// Append a triangle strip as independent triangles. If indices is NULL,
+//   the vertices are used in order.
+void
+Overlay_addColStrip(
+    const float2         *vertices,
+    const float3         *colors,
+    const unsigned short *indices,
+    int                  count)
+{
+    int i, j;
+
+    if (colCount + (count - 2) * 3 > OVERLAY_MAX_COL_VERTS) {
+        NvGlDemoLog("Overlay batch out of space\n");
+        return;
+    }
+    for (i = 2; i < count; i++) {
+        for (j = i - 2; j <= i; j++) {
+            int k = indices ? indices[j] : j;
+            addColVertex(vertices[k], colors[k]);
+        }
+    }
+    vboDirty = GL_TRUE;
+}
+
+// Append a single colored triangle fan as independent triangles
+void
+Overlay_addColFan(
+    const float2 *vertices,
+    const float3 color,
+    const int    *indices,
+    int          count)
+{
+    int i;
+
+    if (colCount + (count - 2) * 3 > OVERLAY_MAX_COL_VERTS) {
+        NvGlDemoLog("Overlay batch out of space\n");
+        return;
+    }
+    for (i = 2; i < count; i++) {
+        addColVertex(vertices[indices[0]],     color);
+        addColVertex(vertices[indices[i - 1]], color);
+        addColVertex(vertices[indices[i]],     color);
+    }
+    vboDirty = GL_TRUE;
+}
+
+// Append a textured quad mapping the given atlas region
+void
+Overlay_addTexQuad(
+    float        left,
+    float        right,
+    float        bottom,
+    float        top,
+    const float4 rect)
+{
+    if (texCount + 6 > OVERLAY_MAX_TEX_VERTS) {
+        NvGlDemoLog("Overlay batch out of space\n");
+        return;
+    }
+    addTexVertex(left,  bottom, rect[0], rect[1]);
+    addTexVertex(right, bottom, rect[2], rect[1]);
+    addTexVertex(right, top,    rect[2], rect[3]);
+    addTexVertex(left,  bottom, rect[0], rect[1]);
+    addTexVertex(right, top,    rect[2], rect[3]);
+    addTexVertex(left,  top,    rect[0], rect[3]);
+    vboDirty = GL_TRUE;
+}
+
+void
+Overlay_draw(void)
+{
+    GLintptr texOffset = colCount * sizeof(ColVertex);
+
+    // Build the atlas mipmaps once all images have been added
+    if (atlasDirty) {
+        glBindTexture(GL_TEXTURE_2D, atlas);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        atlasDirty = GL_FALSE;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    // Only re-specify the buffer when the overlay contents changed
+    if (vboDirty) {
+        glBufferData(GL_ARRAY_BUFFER,
+                     texOffset + texCount * sizeof(TexVertex),
+                     NULL, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, texOffset, colVertices);
+        glBufferSubData(GL_ARRAY_BUFFER, texOffset,
+                        texCount * sizeof(TexVertex), texVertices);
+        vboDirty = GL_FALSE;
+    }
+
+    // Sliders
+    if (colCount) {
+        glUseProgram(prog_overlaycol);
+        glEnableVertexAttribArray(aloc_overlaycolVertex);
+        glEnableVertexAttribArray(aloc_overlaycolColor);
+        glVertexAttribPointer(aloc_overlaycolVertex,
+                              2, GL_FLOAT, GL_FALSE, sizeof(ColVertex),
+                              (void*)0);
+        glVertexAttribPointer(aloc_overlaycolColor,
+                              3, GL_FLOAT, GL_FALSE, sizeof(ColVertex),
+                              (void*)sizeof(float2));
+        glDrawArrays(GL_TRIANGLES, 0, colCount);
+        glDisableVertexAttribArray(aloc_overlaycolVertex);
+        glDisableVertexAttribArray(aloc_overlaycolColor);
+    }
+
+    // Labels and logo
+    if (texCount) {
+        glUseProgram(prog_overlaytex);
+        glBindTexture(GL_TEXTURE_2D, atlas);
+        glEnableVertexAttribArray(aloc_overlaytexVertex);
+        glEnableVertexAttribArray(aloc_overlaytexTexcoord);
+        glVertexAttribPointer(aloc_overlaytexVertex,
+                              2, GL_FLOAT, GL_FALSE, sizeof(TexVertex),
+                              (void*)texOffset);
+        glVertexAttribPointer(aloc_overlaytexTexcoord,
+                              2, GL_FLOAT, GL_FALSE, sizeof(TexVertex),
+                              (void*)(texOffset + sizeof(float2)));
+        glDrawArrays(GL_TRIANGLES, 0, texCount);
+        glDisableVertexAttribArray(aloc_overlaytexVertex);
+        glDisableVertexAttribArray(aloc_overlaytexTexcoord);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
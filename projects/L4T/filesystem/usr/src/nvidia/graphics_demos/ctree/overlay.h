@@ -0,0 +1,70 @@
+/*
+ * overlay.h
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// Batched rendering of the 2D overlay (sliders, labels and logo)
+//
+// All overlay images share a single texture atlas, and all overlay
+//   geometry is accumulated into one vertex buffer which is drawn with
+//   one draw call for the colored and one for the textured primitives.
+//   The buffer is only re-uploaded after the overlay contents change.
+//
+
+#ifndef __OVERLAY_H
+#define __OVERLAY_H
+
+#include <GLES2/gl2.h>
+#include "vector.h"
+
+// Size of the overlay image atlas
+#define OVERLAY_ATLAS_WIDTH  256
+#define OVERLAY_ATLAS_HEIGHT 512
+
+// Capacity of the overlay geometry batch
+#define OVERLAY_MAX_COL_VERTS 1024
+#define OVERLAY_MAX_TEX_VERTS 256
+
+// Initialization and clean-up
+GLboolean Overlay_initialize(void);
+void      Overlay_deinitialize(void);
+
+// Copy an RGB/RGBA image into the atlas. On success the atlas region
+//   is returned in rect as {s0, t0, s1, t1}.
+GLboolean Overlay_addImage(const unsigned char *pixels,
+                           int width, int height, int bpp, float4 rect);
+
+// Geometry batching
+//   (Contents persist across frames until the next Overlay_clear.)
+void Overlay_clear(void);
+void Overlay_addColStrip(const float2 *vertices, const float3 *colors,
+                         const unsigned short *indices, int count);
+void Overlay_addColFan(const float2 *vertices, const float3 color,
+                       const int *indices, int count);
+void Overlay_addTexQuad(float left, float right, float bottom, float top,
+                        const float4 rect);
+
+// Rendering
+void Overlay_draw(void);
+
+#endif // __OVERLAY_H
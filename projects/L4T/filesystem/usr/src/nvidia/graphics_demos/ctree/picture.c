@@ -28,18 +28,18 @@
 
 #include "nvgldemo.h"
 #include "picture.h"
-#include "shaders.h"
+#include "overlay.h"
 
 Picture*
 Picture_new(
-    GLuint t)
+    const float4 texRect)
 {
     Picture *o = (Picture*)MALLOC(sizeof(Picture));
     o->left = 0.0f;
     o->right = 1.0f;
     o->bottom = 0.0f;
     o->top = 1.0f;
-    o->texture = t;
+    copy_4(o->texRect, texRect);
     return o;
 }
 
@@ -66,35 +66,8 @@ Picture_setPos(
 }
 
 void
-Picture_draw(
+Picture_addToOverlay(
     Picture *o)
 {
-    const float texcoords[] = {
-        0.0f, 0.0f,
-        1.0f, 0.0f,
-        1.0f, 1.0f,
-        0.0f, 1.0f
-    };
-    float vertices[4*2];
-
-    // Load program and bind texture
-    glUseProgram(prog_overlaytex);
-    glBindTexture(GL_TEXTURE_2D, o->texture);
-
-    // Set up vertex coordinates
-    vertices[0] = vertices[6] = o->left;
-    vertices[1] = vertices[3] = o->bottom;
-    vertices[2] = vertices[4] = o->right;
-    vertices[5] = vertices[7] = o->top;
-
-    // Render
-    glEnableVertexAttribArray(aloc_overlaytexVertex);
-    glEnableVertexAttribArray(aloc_overlaytexTexcoord);
-    glVertexAttribPointer(aloc_overlaytexVertex,
-                          2, GL_FLOAT, GL_FALSE, 0 , vertices);
-    glVertexAttribPointer(aloc_overlaytexTexcoord,
-                          2, GL_FLOAT, GL_FALSE, 0, texcoords);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-    glDisableVertexAttribArray(aloc_overlaytexVertex);
-    glDisableVertexAttribArray(aloc_overlaytexTexcoord);
+    Overlay_addTexQuad(o->left, o->right, o->bottom, o->top, o->texRect);
 }
@@ -30,19 +30,20 @@
 #define __PICTURE_H
 
 #include <GLES2/gl2.h>
+#include "vector.h"
 
 typedef struct {
     float  left;
     float  right;
     float  bottom;
     float  top;
-    GLuint texture;
+    float4 texRect;     // Region of the overlay atlas
 } Picture;
 
-Picture* Picture_new(GLuint t);
+Picture* Picture_new(const float4 texRect);
 void     Picture_delete(Picture *o);
 void     Picture_setPos(Picture *o,
                         float left, float right, float bottom, float top);
-void     Picture_draw(Picture *o);
+void     Picture_addToOverlay(Picture *o);
 
 #endif // __PICTURE_H
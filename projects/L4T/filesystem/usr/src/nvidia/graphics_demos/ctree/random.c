@@ -36,8 +36,17 @@ static double seed = 1.0;
 double
 GetRandom(void)
 {
-    double t = a * seed;
-    seed = t - m * (double)((int)(t / m));
+    return GetRandomFrom(&seed);
+}
+
+// Same generator with a caller owned state, for sequences which must not
+//   depend on anything else drawing random numbers
+double
+GetRandomFrom(
+    double *s)
+{
+    double t = a * *s;
+    *s = t - m * (double)((int)(t / m));
 
-    return seed / m;
+    return *s / m;
 }
@@ -30,5 +30,6 @@
 #define __RANDOM_H
 
 double GetRandom(void);
+double GetRandomFrom(double *seed);
 
 #endif // __RANDOM_H
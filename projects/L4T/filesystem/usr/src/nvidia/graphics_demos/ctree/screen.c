@@ -40,10 +40,25 @@
 #include "branches.h"
 #include "firefly.h"
 #include "ground.h"
+#include "forest.h"
+#include "impostor.h"
+#include "buildtree.h"
+#include "meshcache.h"
 #include "sky.h"
 #include "picture.h"
 #include "slider.h"
-
+#include "overlay.h"
+
+#include "assetpack.h"
+
+// Depending on compile options, textures are either built into the
+//   application or loaded from a read-only asset pack which is mapped at
+//   startup. (TEXIMG evaluates to the image data or the pack entry name.)
+#ifdef USE_EXTERN_TEXTURES
+typedef const char *TexImage;
+#define TEXIMG(name) #name
+static AssetPack texPack;
+#else
 #include "ground_img.h"
 #include "ground_s_img.h"
 #include "bark_img.h"
@@ -62,6 +77,9 @@
 #include "label_depth_img.h"
 #include "label_twist_img.h"
 #include "label_fullness_img.h"
+typedef unsigned char *TexImage;
+#define TEXIMG(name) name##_img
+#endif
 
 // Maximum number of lights (fireflies)
 // NOTE: any changes to NUM_LIGHTS must also be made to lighting_vert.glslv
@@ -71,30 +89,30 @@
 NVTexfontRasterFont *nvtxf = NULL;
 
 // Scene textures (full size and small versions)
-static unsigned char* texBark[]         = {bark_img,
-                                            bark_s_img};
-static unsigned char* texLeafFront[]    = {leaf_img,
-                                            leaf_s_img};
-static unsigned char* texLeafBack[]     = {leaf_back_img,
-                                            leaf_back_s_img};
-static unsigned char* texSky[]          = {sky_night_img,
-                                            sky_night_s_img};
-static unsigned char* texGround[]       = {ground_img,
-                                            ground_s_img};
+static TexImage texBark[]         = {TEXIMG(bark),
+                                     TEXIMG(bark_s)};
+static TexImage texLeafFront[]    = {TEXIMG(leaf),
+                                     TEXIMG(leaf_s)};
+static TexImage texLeafBack[]     = {TEXIMG(leaf_back),
+                                     TEXIMG(leaf_back_s)};
+static TexImage texSky[]          = {TEXIMG(sky_night),
+                                     TEXIMG(sky_night_s)};
+static TexImage texGround[]       = {TEXIMG(ground),
+                                     TEXIMG(ground_s)};
 
 // Array of data structures for overlay texture info
 static struct pictInfoStruct {
-    unsigned char *filename;
+    TexImage image;
     float left, right, bottom, top;
 } pictInfo[] = {
-    {label_depth_img,       0, 150, 260, 275},
-    {label_balance_img,     0, 150, 220, 235},
-    {label_twist_img,       0, 150, 180, 195},
-    {label_spread_img,      0, 150, 140, 155},
-    {label_leaf_size_img,   0, 150, 100, 115},
-    {label_branch_size_img, 0, 150,  60,  75},
-    {label_fullness_img,    0, 150,  20,  35},
-    {NVidiaLogo_img,        0, 150, 450, 480},
+    {TEXIMG(label_depth),       0, 150, 260, 275},
+    {TEXIMG(label_balance),     0, 150, 220, 235},
+    {TEXIMG(label_twist),       0, 150, 180, 195},
+    {TEXIMG(label_spread),      0, 150, 140, 155},
+    {TEXIMG(label_leaf_size),   0, 150, 100, 115},
+    {TEXIMG(label_branch_size), 0, 150,  60,  75},
+    {TEXIMG(label_fullness),    0, 150,  20,  35},
+    {TEXIMG(NVidiaLogo),        0, 150, 450, 480},
 };
 #define NUM_PICTS (sizeof(pictInfo) / sizeof(struct pictInfoStruct))
 static int const LOGO_PICT = NUM_PICTS - 1;
@@ -168,6 +186,9 @@ static int selectedSlider = TREE_PARAM_DEPTH;
 static Picture *picts[8];
 static GLboolean overlayFlag = GL_TRUE;
 
+// Overlay batch needs to be rebuilt
+static GLboolean overlayDirty = GL_TRUE;
+
 // FPS is visible on screen
 static GLboolean fpsFlag = GL_TRUE;
 
@@ -194,6 +215,21 @@ static GLboolean smalltex = GL_FALSE;
 // Don't render sky
 static GLboolean nosky = GL_FALSE;
 
+// Expand branch cylinders on the GPU
+static GLboolean gpubranches = GL_FALSE;
+
+// Cull and draw all trees with GPU driven indirect draws
+static GLboolean gpuforest = GL_FALSE;
+
+// Tree placements need to be re-uploaded for the GPU forest
+static GLboolean forestDirty = GL_TRUE;
+
+// Release the CPU copies of the tree geometry after upload
+static GLboolean resident = GL_FALSE;
+
+// Draw distant trees as impostor billboards
+static GLboolean impostors = GL_FALSE;
+
 // Don't render menus
 static GLboolean nomenu = GL_FALSE;
 
@@ -209,7 +245,49 @@ setSlider(
     if (Slider_setValue(sliders[selectedSlider], val) || mustSet)
     {
         Tree_setParam(selectedSlider, val);
+        overlayDirty = GL_TRUE;
+    }
+}
+
+// Create a texture from the built in image or the asset pack entry
+static GLuint
+loadTexture(
+    TexImage img)
+{
+#ifdef USE_EXTERN_TEXTURES
+    return AssetPack_loadTexture(&texPack, img);
+#else
+    return NvGlDemoLoadTgaFromBuffer(GL_TEXTURE_2D, 1, &img);
+#endif
+}
+
+// Get the RGB(A) texels of an image for the overlay atlas
+static const unsigned char*
+getImage(
+    TexImage img,
+    int      *w,
+    int      *h,
+    int      *bpp)
+{
+#ifdef USE_EXTERN_TEXTURES
+    return AssetPack_getImage(&texPack, img, w, h, bpp);
+#else
+    unsigned char *body = img + 18 + img[0];
+    int i;
+
+    if ((img[1] != 0) || (img[2] != 2)) return NULL;
+    *w   = ((int)img[13] << 8) | img[12];
+    *h   = ((int)img[15] << 8) | img[14];
+    *bpp = img[16] >> 3;
+
+    // Convert BGR(A) to RGB(A)
+    for (i = 0; i < *w * *h * *bpp; i += *bpp) {
+        unsigned char c = body[i];
+        body[i] = body[i + 2];
+        body[i + 2] = c;
     }
+    return body;
+#endif
 }
 
 static void
@@ -268,6 +346,38 @@ refreshLights(void)
     glUniform1i(uloc_solidsLights, lightCount);
     glUseProgram(prog_leaves);
     glUniform1i(uloc_leavesLights, lightCount);
+    if (prog_branches) {
+        glUseProgram(prog_branches);
+        glUniform1i(uloc_branchesLights, lightCount);
+    }
+    if (prog_forestcull) {
+        glUseProgram(prog_forestsolids);
+        glUniform1i(uloc_forestsolidsLights, lightCount);
+        glUseProgram(prog_forestleaves);
+        glUniform1i(uloc_forestleavesLights, lightCount);
+    }
+}
+
+// Upload the placements of all trees for the GPU forest
+static void
+refreshForest(void)
+{
+    float4 *instances;
+    int    j;
+
+    instances = (float4*)MALLOC(treePosList.elemCount * sizeof(float4));
+    for (j = 0; j < treePosList.elemCount; j++) {
+        TreePos *treePos = (TreePos*)Array_get(&treePosList, j);
+        float a = degToRadF(treePos->angle);
+        instances[j][0] = treePos->x;
+        instances[j][1] = treePos->y;
+        instances[j][2] = COS(a);
+        instances[j][3] = SIN(a);
+    }
+    Forest_setInstances(instances, treePosList.elemCount);
+    FREE(instances);
+
+    forestDirty = GL_FALSE;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -288,6 +398,12 @@ Screen_initialize(
     // Load shaders
     if (!LoadShaders()) return 0;
 
+#ifdef USE_EXTERN_TEXTURES
+    // Map the texture pack. Only the pages of the textures uploaded below
+    //   will actually be read.
+    if (!AssetPack_open(&texPack, CTREE_PREFIX ASSETPACK_FILE)) return 0;
+#endif
+
     // Initialize the module parameters.
     width  = w;
     height = h;
@@ -300,21 +416,37 @@ Screen_initialize(
     Firefly_global_init(NUM_LIGHTS);
 
     // Initialize trees
-    Tree_initialize(NvGlDemoLoadTgaFromBuffer(GL_TEXTURE_2D, 1, &texBark[smalltex]),
-                    NvGlDemoLoadTgaFromBuffer(GL_TEXTURE_2D, 1, &texLeafFront[smalltex]),
-                    NvGlDemoLoadTgaFromBuffer(GL_TEXTURE_2D, 1, &texLeafBack[smalltex]));
+    Tree_initialize(loadTexture(texBark[smalltex]),
+                    loadTexture(texLeafFront[smalltex]),
+                    loadTexture(texLeafBack[smalltex]));
+    if (gpubranches) {
+        Tree_toggleGPUBranches();
+    }
+    if (resident) {
+        Tree_setResident(GL_TRUE);
+    }
     Array_init(&treePosList, sizeof(TreePos));
     treeposPtr = TreePos_new(0.0f, 0.0f, 0.0f);
     Array_push(&treePosList, treeposPtr);
     TreePos_delete (treeposPtr);
 
+    // Initialize the GPU forest
+    Forest_initialize();
+    forestDirty = GL_TRUE;
+
+    // Initialize the impostor atlas. Trees are always drawn in full if
+    //   it can't be created.
+    if (!Impostor_initialize()) {
+        impostors = GL_FALSE;
+    }
+
     // Initialize sky
     if (!nosky) {
-        Sky_initialize(NvGlDemoLoadTgaFromBuffer(GL_TEXTURE_2D, 1, &texSky[smalltex]));
+        Sky_initialize(loadTexture(texSky[smalltex]));
     }
 
     // Initialize ground
-    Ground_initialize(NvGlDemoLoadTgaFromBuffer(GL_TEXTURE_2D, 1, &texGround[smalltex]));
+    Ground_initialize(loadTexture(texGround[smalltex]));
 
     // Time tracking initialization.
     startTime = currentTime = (double)SYSTIME() / ((long long)1000*1000000);
@@ -334,11 +466,19 @@ Screen_initialize(
     }
     Slider_select(sliders[selectedSlider], GL_TRUE);
 
-    // Picture initialization.
+    // Picture initialization. All pictures share the overlay atlas.
+    if (!Overlay_initialize()) return 0;
     for (i = (nomenu ? LOGO_PICT : 0); i < (int)NUM_PICTS; i++)
     {
-        picts[i] = Picture_new(NvGlDemoLoadTgaFromBuffer(GL_TEXTURE_2D, 1,
-                                               &pictInfo[i].filename));
+        const unsigned char *pixels;
+        int w, h, bpp;
+        float4 rect;
+
+        pixels = getImage(pictInfo[i].image, &w, &h, &bpp);
+        if (!pixels || !Overlay_addImage(pixels, w, h, bpp, rect)) {
+            return 0;
+        }
+        picts[i] = Picture_new(rect);
         Picture_setPos(picts[i],
                        pictInfo[i].left, pictInfo[i].right,
                        pictInfo[i].bottom, pictInfo[i].top);
@@ -364,10 +504,30 @@ Screen_initialize(
     glUniform1i(uloc_simpletexTexUnit, 0);
     glUseProgram(prog_overlaytex);
     glUniform1i(uloc_overlaytexTexUnit, 0);
+    glUseProgram(prog_impostor);
+    glUniform1i(uloc_impostorTexUnit, 0);
+
+    // GPU branch segment records are read from texture unit 1
+    if (prog_branches) {
+        glUseProgram(prog_branches);
+        glUniform1i(uloc_branchesTexUnit, 0);
+        glUniform1i(uloc_branchesSegments, 1);
+    }
+    if (prog_forestcull) {
+        glUseProgram(prog_forestsolids);
+        glUniform1i(uloc_forestsolidsTexUnit, 0);
+        glUseProgram(prog_forestleaves);
+        glUniform1i(uloc_forestleavesTexUnit, 0);
+    }
 
     nvtxf = nvtexfontInitRasterFont(NV_TEXFONT_DEFAULT, 0, GL_TRUE,
                                     GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
 
+#ifdef USE_EXTERN_TEXTURES
+    // Everything has been uploaded, so the mapping is no longer needed
+    AssetPack_close(&texPack);
+#endif
+
     return 1;
 }
 
@@ -388,11 +548,14 @@ Screen_deinitialize(void)
     for (i = (nomenu ? LOGO_PICT : 0); i < (int)NUM_PICTS; i++) {
         Picture_delete(picts[i]);
     }
+    Overlay_deinitialize();
     if (!nomenu) {
         for (i = 0; i < NUM_TREE_PARAMS; i++) {
             Slider_delete(sliders[i]);
         }
     }
+    Impostor_deinitialize();
+    Forest_deinitialize();
     Tree_deinitialize();
 
     Ground_deinitialize();
@@ -405,6 +568,10 @@ Screen_deinitialize(void)
 
     if (nvtxf != NULL)
         nvtexfontUnloadRasterFont(nvtxf);
+
+#ifdef USE_EXTERN_TEXTURES
+    AssetPack_close(&texPack);
+#endif
 }
 
 static void
@@ -420,6 +587,7 @@ addTree(void)
                              ((float) GetRandom()) * 360.0f);
     Array_push(&treePosList, treeposPtr);
     TreePos_delete(treeposPtr);
+    forestDirty = GL_TRUE;
 }
 
 static GLboolean
@@ -441,6 +609,7 @@ sliderControl(
         if (selectedSlider == -1) { selectedSlider = NUM_TREE_PARAMS - 1; }
         if (selectedSlider == NUM_TREE_PARAMS) { selectedSlider = 0; }
         Slider_select(sliders[selectedSlider], GL_TRUE);
+        overlayDirty = GL_TRUE;
         return GL_TRUE;
         }
 
@@ -499,6 +668,7 @@ static GLboolean sceneControl(int key)
     case ' ':
         if (!nomenu) {
             overlayFlag = !overlayFlag;
+            overlayDirty = GL_TRUE;
         }
         return GL_TRUE;
 
@@ -533,6 +703,12 @@ static GLboolean sceneControl(int key)
             "  V    : increase swap interval\n"
             "  1-8  : number of fireflies (colored point lights)\n"
             "  r    : toggle use of VBO\n"
+            "  g    : toggle GPU expansion of branch cylinders\n"
+            "  b    : decrease branch facets (GPU expansion only)\n"
+            "  B    : increase branch facets (GPU expansion only)\n"
+            "  d    : toggle GPU culling and drawing of the forest\n"
+            "  m    : toggle impostor billboards for distant trees\n"
+            "  w    : write the tree to the mesh cache\n"
             "  q    : quit\n"
             "\n");
         return GL_TRUE;
@@ -543,6 +719,7 @@ static GLboolean sceneControl(int key)
 
     case '-':
         if (treePosList.elemCount>1) { Array_pop(&treePosList); }
+        forestDirty = GL_TRUE;
         return GL_TRUE;
 
     case 'c':
@@ -564,12 +741,30 @@ static GLboolean sceneControl(int key)
 
     case 'S':
         {
+        int chunks;
+        unsigned int cpu, gpu;
         int polygons = Leaves_polyCount() +
                        Branches_polyCount() +
                        Ground_polyCount();
         NvGlDemoLog("frames per second   : %d\n", (int)fps);
         NvGlDemoLog("leaves              : %d\n", Leaves_leafCount());
         NvGlDemoLog("branches            : %d\n", Branches_branchCount());
+        NvGlDemoLog("ground chunks drawn : %d of %d\n",
+                    Ground_chunkCount(&chunks), chunks);
+        NvGlDemoLog("ground polygons     : %d\n", Ground_polyCount());
+        if (gpuforest && Forest_isReady()) {
+            int near, far, culled;
+            Forest_getCounts(&near, &far, &culled);
+            NvGlDemoLog("trees near/far/culled: %d/%d/%d\n",
+                        near, far, culled);
+        }
+        if (impostors) {
+            NvGlDemoLog("impostor trees      : %d of %d\n",
+                        Impostor_count(), treePosList.elemCount);
+        }
+        Tree_memoryUsage(&cpu, &gpu);
+        Ground_memoryUsage(&cpu, &gpu);
+        NvGlDemoLog("geometry bytes      : %u CPU, %u GPU\n", cpu, gpu);
         NvGlDemoLog("polygons per frame  : %d\n", polygons);
         NvGlDemoLog("polygons per second : %d\n", (int)(polygons * fps));
 
@@ -588,6 +783,40 @@ static GLboolean sceneControl(int key)
     case 'r':
         Tree_toggleVBO();
         return GL_TRUE;
+
+    case 'g':
+        Tree_toggleGPUBranches();
+        return GL_TRUE;
+
+    case 'd':
+        if (Forest_supported()) {
+            gpuforest = !gpuforest;
+            NvGlDemoLog("GPU forest %s\n", gpuforest ? "on" : "off");
+        } else {
+            NvGlDemoLog("GPU forest requires OpenGL ES 3.1\n");
+        }
+        return GL_TRUE;
+
+    case 'm':
+        impostors = !impostors;
+        NvGlDemoLog("impostors %s beyond %.1f\n", impostors ? "on" : "off",
+                    Impostor_getDistance());
+        return GL_TRUE;
+
+    case 'w':
+        Tree_save();
+        return GL_TRUE;
+
+    case 'b':
+    case 'B':
+        if (Branches_isGPU()) {
+            Branches_setFacets(Branches_getFacets() + (key == 'B' ? 1 : -1));
+            NvGlDemoLog("branch facets set to: %d\n", Branches_getFacets());
+        } else {
+            NvGlDemoLog("branch facets can only be changed with GPU "
+                        "expansion\n");
+        }
+        return GL_TRUE;
     }
     return GL_FALSE;
 }
@@ -615,9 +844,10 @@ Screen_draw(void)
     float  to_h;
     int    i, j;
     float  h, p, sh, ch, sp, cp;
-    float3 forward_vec, tmp;
+    float3 forward_vec, tmp, sceneEye;
     float  scenemvp[16];
     float  treemvp[16];
+    GLboolean forest;
 
     // Update the clock
     tick();
@@ -685,6 +915,24 @@ Screen_draw(void)
     // Enable depth testing for the scene
     glEnable(GL_DEPTH_TEST);
 
+    // Rebuild the tree first, the GPU forest can only be used with some
+    //   geometry modes
+    Tree_update();
+    forest = gpuforest && Forest_isReady();
+    if (forest && forestDirty) {
+        refreshForest();
+    }
+
+    // Render the impostor views if the tree changed. This clobbers the
+    //   light count of the tree shaders.
+    if (impostors && !forest && Impostor_update()) {
+        refreshLights();
+    }
+    Impostor_clear();
+
+    // Eye position in scene space, where z is up
+    set_3(sceneEye, eye[0], -eye[2], eye[1]);
+
     // Render the trees and the ground beneath them
     for (j = 0; j < treePosList.elemCount; j++) {
         TreePos *treePos = (TreePos*)Array_get(&treePosList, j);
@@ -696,6 +944,16 @@ Screen_draw(void)
                 Firefly_move(fireflies + i);
             }
         }
+
+        // The GPU forest draws all trees at once below
+        if (forest) continue;
+
+        // Distant trees are batched into impostors
+        if (impostors &&
+            Impostor_add(treePos->x, treePos->y, treePos->angle, sceneEye)) {
+            continue;
+        }
+
         // Adjust modelview/projection for tree position/orientation
         MEMCPY(treemvp, scenemvp, sizeof(treemvp));
         NvGlDemoMatrixTranslate(treemvp, treePos->x, treePos->y, 0.0f);
@@ -713,10 +971,46 @@ Screen_draw(void)
         glUniform3fv(uloc_leavesLightPos, lightCount, fPos);
         glUniform3fv(uloc_leavesLightCol, lightCount, fColor);
 
+        // Set up GPU branch shader
+        if (prog_branches) {
+            glUseProgram(prog_branches);
+            glUniformMatrix4fv(uloc_branchesMvpMat, 1, GL_FALSE, treemvp);
+            glUniform3fv(uloc_branchesLightPos, lightCount, fPos);
+            glUniform3fv(uloc_branchesLightCol, lightCount, fColor);
+        }
+
         // Render the tree
         Tree_draw();
     }
 
+    // Render all trees with GPU culling. They are lit by the fireflies
+    //   of the last tree.
+    if (forest) {
+        glUseProgram(prog_forestsolids);
+        glUniformMatrix4fv(uloc_forestsolidsMvpMat, 1, GL_FALSE, scenemvp);
+        glUniform3fv(uloc_forestsolidsLightPos, lightCount, fPos);
+        glUniform3fv(uloc_forestsolidsLightCol, lightCount, fColor);
+        glUseProgram(prog_forestleaves);
+        glUniformMatrix4fv(uloc_forestleavesMvpMat, 1, GL_FALSE, scenemvp);
+        glUniform3fv(uloc_forestleavesLightPos, lightCount, fPos);
+        glUniform3fv(uloc_forestleavesLightCol, lightCount, fColor);
+        Forest_draw(scenemvp);
+    }
+
+    // Render all distant trees with one draw
+    Impostor_draw(scenemvp);
+
+    // Render the terrain once for all trees. It is lit by the fireflies
+    //   of the tree at the origin. The loop above may not have set the
+    //   lights (GPU forest, impostors) and the impostor bake leaves its
+    //   own, so set them here.
+    glUseProgram(prog_solids);
+    glUniformMatrix4fv(uloc_solidsMvpMat, 1, GL_FALSE, scenemvp);
+    glUniform1i(uloc_solidsLights, lightCount);
+    glUniform3fv(uloc_solidsLightPos, lightCount, fPos);
+    glUniform3fv(uloc_solidsLightCol, lightCount, fColor);
+    Ground_draw(scenemvp);
+
     // Draw the sky
     if (!nosky) {
         glUseProgram(prog_simplecol);
@@ -751,18 +1045,23 @@ Screen_draw(void)
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
 
-    // Do the sliders and logo
-    if (overlayFlag) {
-        int i;
-        for (i = 0; i < NUM_TREE_PARAMS; i++) {
-            Slider_draw(sliders[i]);
-        }
-        for (i = 0; i < (int)NUM_PICTS; i++) {
-            Picture_draw(picts[i]);
+    // Do the sliders and logo. The batch is only rebuilt (and
+    //   re-uploaded) when a slider or the overlay mode changed.
+    if (overlayDirty) {
+        Overlay_clear();
+        if (overlayFlag) {
+            for (i = 0; i < NUM_TREE_PARAMS; i++) {
+                Slider_addToOverlay(sliders[i]);
+            }
+            for (i = 0; i < (int)NUM_PICTS; i++) {
+                Picture_addToOverlay(picts[i]);
+            }
+        } else {
+            Picture_addToOverlay(picts[LOGO_PICT]);
         }
-    } else {
-        Picture_draw(picts[LOGO_PICT]);
+        overlayDirty = GL_FALSE;
     }
+    Overlay_draw();
 
     if (nvtxf && fpsFlag) {
         char buf[30];
@@ -783,6 +1082,7 @@ Screen_setDemoParams(void)
     lightCount = 8;
     fpsFlag = GL_FALSE;
     overlayFlag = GL_FALSE;
+    overlayDirty = GL_TRUE;
     swapInterval = 1;
     NvGlDemoSwapInterval(demoState.display, swapInterval);
 }
@@ -799,6 +1099,56 @@ Screen_setNoSky(void)
     nosky = 1;
 }
 
+void
+Screen_setGPUBranches(void)
+{
+    gpubranches = 1;
+}
+
+void
+Screen_setGPUForest(void)
+{
+    gpuforest = 1;
+}
+
+void
+Screen_setResident(void)
+{
+    resident = GL_TRUE;
+}
+
+// Reuse generated trees from cache files in the given directory
+void
+Screen_setMeshCache(
+    const char *dir)
+{
+    MeshCache_setDirectory(dir);
+}
+
+// Select the character of the first tree
+void
+Screen_setSeed(
+    int seed)
+{
+    BuildTree_setSeed((unsigned int)seed);
+}
+
+void
+Screen_setImpostors(
+    float distance)
+{
+    impostors = GL_TRUE;
+    Impostor_setDistance(distance);
+}
+
+void
+Screen_setTerrain(
+    int chunks,
+    int resolution)
+{
+    Ground_setSize(chunks, resolution);
+}
+
 void
 Screen_setNoMenu(void)
 {
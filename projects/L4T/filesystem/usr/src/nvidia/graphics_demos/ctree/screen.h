@@ -38,6 +38,13 @@ void Screen_deinitialize(void);
 void Screen_setDemoParams(void);
 void Screen_setSmallTex(void);
 void Screen_setNoSky(void);
+void Screen_setGPUBranches(void);
+void Screen_setGPUForest(void);
+void Screen_setImpostors(float distance);
+void Screen_setResident(void);
+void Screen_setMeshCache(const char *dir);
+void Screen_setSeed(int seed);
+void Screen_setTerrain(int chunks, int resolution);
 void Screen_setNoMenu(void);
 
 void Screen_draw(void);
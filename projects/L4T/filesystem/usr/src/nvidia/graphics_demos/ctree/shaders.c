@@ -29,6 +29,7 @@
 #include <GLES2/gl2.h>
 
 #include "nvgldemo.h"
+#include <GLES3/gl31.h>
 #include "shaders.h"
 
 // Depending on compile options, we either build in the shader sources or
@@ -46,6 +47,13 @@ static const char shad_overlaycolVert[] = { CTREE_PREFIX VERTFILE(overlaycol_ver
 static const char shad_overlaycolFrag[] = { CTREE_PREFIX FRAGFILE(overlaycol_frag) };
 static const char shad_overlaytexVert[] = { CTREE_PREFIX VERTFILE(overlaytex_vert) };
 static const char shad_overlaytexFrag[] = { CTREE_PREFIX FRAGFILE(overlaytex_frag) };
+static const char shad_impostorVert[]   = { CTREE_PREFIX VERTFILE(impostor_vert) };
+static const char shad_impostorFrag[]   = { CTREE_PREFIX FRAGFILE(impostor_frag) };
+static const char shad_branchesVert[]   = { CTREE_PREFIX VERTFILE(branches_vert) };
+static const char shad_branchesFrag[]   = { CTREE_PREFIX FRAGFILE(branches_frag) };
+static const char shad_forestVert[]     = { CTREE_PREFIX VERTFILE(forest_vert) };
+static const char shad_forestleavesFrag[] =
+    { CTREE_PREFIX FRAGFILE(forestleaves_frag) };
 #else
 static const char shad_lightingVert[]   = {
 #   include VERTFILE(lighting_vert)
@@ -80,6 +88,34 @@ static const char shad_overlaytexVert[] = {
 static const char shad_overlaytexFrag[] = {
 #   include FRAGFILE(overlaytex_frag)
 };
+static const char shad_impostorVert[]   = {
+#   include VERTFILE(impostor_vert)
+};
+static const char shad_impostorFrag[]   = {
+#   include FRAGFILE(impostor_frag)
+};
+static const char shad_branchesVert[]   = {
+#   include VERTFILE(branches_vert)
+};
+static const char shad_branchesFrag[]   = {
+#   include FRAGFILE(branches_frag)
+};
+static const char shad_forestVert[]     = {
+#   include VERTFILE(forest_vert)
+};
+static const char shad_forestleavesFrag[] = {
+#   include FRAGFILE(forestleaves_frag)
+};
+#endif
+
+// Compute shaders are always compiled from source at runtime
+#ifdef USE_EXTERN_SHADERS
+static const char shad_forestcullComp[] =
+    { CTREE_PREFIX "forestcull_comp.glslc" };
+#else
+static const char shad_forestcullComp[] = {
+#   include "forestcull_comp.glslch"
+};
 #endif
 
 static const char solidsPrgBin[] = { PROGFILE(solids_prog) };
@@ -88,6 +124,10 @@ static const char simplecolPrgBin[] = { PROGFILE(simplecol_prog) };
 static const char simpletexPrgBin[] = { PROGFILE(simpletex_prog) };
 static const char overlaycolPrgBin[] = { PROGFILE(overlaycol_prog) };
 static const char overlaytexPrgBin[] = { PROGFILE(overlaytex_prog) };
+static const char impostorPrgBin[] = { PROGFILE(impostor_prog) };
+static const char branchesPrgBin[] = { PROGFILE(branches_prog) };
+static const char forestsolidsPrgBin[] = { PROGFILE(forestsolids_prog) };
+static const char forestleavesPrgBin[] = { PROGFILE(forestleaves_prog) };
 
 // Ground and branch shader (lit objects with full opacity)
 GLint prog_solids = 0;
@@ -138,6 +178,217 @@ GLint uloc_overlaytexTexUnit;
 GLint aloc_overlaytexVertex;
 GLint aloc_overlaytexTexcoord;
 
+// Impostor billboard shader
+GLint prog_impostor = 0;
+GLint uloc_impostorMvpMat;
+GLint uloc_impostorTexUnit;
+GLint aloc_impostorVertex;
+GLint aloc_impostorTexcoord;
+GLint aloc_impostorWeight;
+
+// Branch shader expanding segment records on the GPU
+GLint prog_branches = 0;
+GLint uloc_branchesLights;
+GLint uloc_branchesLightPos;
+GLint uloc_branchesLightCol;
+GLint uloc_branchesMvpMat;
+GLint uloc_branchesTexUnit;
+GLint uloc_branchesSegments;
+GLint uloc_branchesFacets;
+GLint uloc_branchesRadius;
+
+// Instanced forest shaders and culling compute shader
+GLint prog_forestsolids = 0;
+GLint uloc_forestsolidsLights;
+GLint uloc_forestsolidsLightPos;
+GLint uloc_forestsolidsLightCol;
+GLint uloc_forestsolidsMvpMat;
+GLint uloc_forestsolidsTexUnit;
+GLint prog_forestleaves = 0;
+GLint uloc_forestleavesLights;
+GLint uloc_forestleavesLightPos;
+GLint uloc_forestleavesLightCol;
+GLint uloc_forestleavesMvpMat;
+GLint uloc_forestleavesTexUnit;
+GLint prog_forestcull = 0;
+GLint uloc_forestcullCount;
+GLint uloc_forestcullCapacity;
+GLint uloc_forestcullPlanes;
+GLint uloc_forestcullDepthRow;
+GLint uloc_forestcullBounds;
+GLint uloc_forestcullLodDistance;
+
+// Compile and link a compute shader program from source
+static GLint
+loadComputeShader(
+    const char *src,
+    int        size)
+{
+    GLuint shader, prog;
+    GLint  status;
+    char   log[1024];
+
+#ifdef USE_EXTERN_SHADERS
+    char *file = NvGlDemoLoadFile(src, (unsigned int*)&size);
+    if (!file) return 0;
+    src = file;
+#endif
+
+    shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 1, &src, &size);
+    glCompileShader(shader);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status) {
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        NvGlDemoLog("Compute shader compile failed:\n%s\n", log);
+        glDeleteShader(shader);
+        prog = 0;
+        goto done;
+    }
+
+    prog = glCreateProgram();
+    glAttachShader(prog, shader);
+    glDeleteShader(shader);
+    glLinkProgram(prog);
+    glGetProgramiv(prog, GL_LINK_STATUS, &status);
+    if (!status) {
+        glGetProgramInfoLog(prog, sizeof(log), NULL, log);
+        NvGlDemoLog("Compute shader link failed:\n%s\n", log);
+        glDeleteProgram(prog);
+        prog = 0;
+    }
+
+    done:
+#ifdef USE_EXTERN_SHADERS
+    FREE(file);
+#endif
+    return prog;
+}
+
+// Load the optional GPU branch expansion shader, which needs OpenGL ES 3.0.
+//   Failure just leaves the CPU branch path as the only one.
+static void
+loadBranchesShader(void)
+{
+    GLboolean success;
+
+    if (!NvGlDemoHasGlesVersion(3, 0)) {
+        NvGlDemoLog("OpenGL ES 3.0 unavailable, GPU branches disabled\n");
+        return;
+    }
+
+    prog_branches = LOADPROGSHADER(shad_branchesVert, shad_branchesFrag,
+                                   GL_TRUE, GL_FALSE,
+                                   branchesPrgBin);
+    if (!prog_branches) {
+        NvGlDemoLog("Error occured loading GPU branch shader\n");
+        return;
+    }
+
+    uloc_branchesLights   = glGetUniformLocation(prog_branches, "lights");
+    uloc_branchesLightPos = glGetUniformLocation(prog_branches, "lightpos");
+    uloc_branchesLightCol = glGetUniformLocation(prog_branches, "lightcol");
+    uloc_branchesMvpMat   = glGetUniformLocation(prog_branches, "mvpmatrix");
+    uloc_branchesTexUnit  = glGetUniformLocation(prog_branches, "texunit");
+    uloc_branchesSegments = glGetUniformLocation(prog_branches, "segments");
+    uloc_branchesFacets   = glGetUniformLocation(prog_branches, "facets");
+    uloc_branchesRadius   = glGetUniformLocation(prog_branches, "radius");
+    success =  (uloc_branchesLights   >= 0)
+            && (uloc_branchesLightPos >= 0)
+            && (uloc_branchesLightCol >= 0)
+            && (uloc_branchesMvpMat   >= 0)
+            && (uloc_branchesTexUnit  >= 0)
+            && (uloc_branchesSegments >= 0)
+            && (uloc_branchesFacets   >= 0)
+            && (uloc_branchesRadius   >= 0);
+    if (!success) {
+        NvGlDemoLog(
+            "Error occured retrieving GPU branch shader locations\n");
+        glDeleteProgram(prog_branches);
+        prog_branches = 0;
+    }
+}
+
+// Load the optional GPU driven forest shaders, which need OpenGL ES 3.1.
+//   Failure just leaves drawing the trees one at a time.
+static void
+loadForestShaders(void)
+{
+    GLboolean success;
+
+    if (!NvGlDemoHasGlesVersion(3, 1)) {
+        NvGlDemoLog("OpenGL ES 3.1 unavailable, GPU forest disabled\n");
+        return;
+    }
+
+    prog_forestsolids = LOADPROGSHADER(shad_forestVert, shad_branchesFrag,
+                                       GL_TRUE, GL_FALSE,
+                                       forestsolidsPrgBin);
+    prog_forestleaves = LOADPROGSHADER(shad_forestVert, shad_forestleavesFrag,
+                                       GL_TRUE, GL_FALSE,
+                                       forestleavesPrgBin);
+    prog_forestcull   = loadComputeShader(shad_forestcullComp,
+                                          sizeof(shad_forestcullComp));
+    success = prog_forestsolids && prog_forestleaves && prog_forestcull;
+    if (success) {
+        uloc_forestsolidsLights   =
+            glGetUniformLocation(prog_forestsolids, "lights");
+        uloc_forestsolidsLightPos =
+            glGetUniformLocation(prog_forestsolids, "lightpos");
+        uloc_forestsolidsLightCol =
+            glGetUniformLocation(prog_forestsolids, "lightcol");
+        uloc_forestsolidsMvpMat   =
+            glGetUniformLocation(prog_forestsolids, "mvpmatrix");
+        uloc_forestsolidsTexUnit  =
+            glGetUniformLocation(prog_forestsolids, "texunit");
+        uloc_forestleavesLights   =
+            glGetUniformLocation(prog_forestleaves, "lights");
+        uloc_forestleavesLightPos =
+            glGetUniformLocation(prog_forestleaves, "lightpos");
+        uloc_forestleavesLightCol =
+            glGetUniformLocation(prog_forestleaves, "lightcol");
+        uloc_forestleavesMvpMat   =
+            glGetUniformLocation(prog_forestleaves, "mvpmatrix");
+        uloc_forestleavesTexUnit  =
+            glGetUniformLocation(prog_forestleaves, "texunit");
+        uloc_forestcullCount       =
+            glGetUniformLocation(prog_forestcull, "count");
+        uloc_forestcullCapacity    =
+            glGetUniformLocation(prog_forestcull, "capacity");
+        uloc_forestcullPlanes      =
+            glGetUniformLocation(prog_forestcull, "planes");
+        uloc_forestcullDepthRow    =
+            glGetUniformLocation(prog_forestcull, "depthrow");
+        uloc_forestcullBounds      =
+            glGetUniformLocation(prog_forestcull, "bounds");
+        uloc_forestcullLodDistance =
+            glGetUniformLocation(prog_forestcull, "loddistance");
+        success =  (uloc_forestsolidsLights    >= 0)
+                && (uloc_forestsolidsLightPos  >= 0)
+                && (uloc_forestsolidsLightCol  >= 0)
+                && (uloc_forestsolidsMvpMat    >= 0)
+                && (uloc_forestsolidsTexUnit   >= 0)
+                && (uloc_forestleavesLights    >= 0)
+                && (uloc_forestleavesLightPos  >= 0)
+                && (uloc_forestleavesLightCol  >= 0)
+                && (uloc_forestleavesMvpMat    >= 0)
+                && (uloc_forestleavesTexUnit   >= 0)
+                && (uloc_forestcullCount       >= 0)
+                && (uloc_forestcullCapacity    >= 0)
+                && (uloc_forestcullPlanes      >= 0)
+                && (uloc_forestcullDepthRow    >= 0)
+                && (uloc_forestcullBounds      >= 0)
+                && (uloc_forestcullLodDistance >= 0);
+    }
+    if (!success) {
+        NvGlDemoLog("Error occured loading GPU forest shaders\n");
+        if (prog_forestsolids) glDeleteProgram(prog_forestsolids);
+        if (prog_forestleaves) glDeleteProgram(prog_forestleaves);
+        if (prog_forestcull)   glDeleteProgram(prog_forestcull);
+        prog_forestsolids = prog_forestleaves = prog_forestcull = 0;
+    }
+}
+
 // Load all the shaders and extract uniform/attribute locations
 int
 LoadShaders(void)
@@ -164,9 +415,13 @@ LoadShaders(void)
     prog_overlaytex = LOADPROGSHADER(shad_overlaytexVert, shad_overlaytexFrag,
                                  GL_TRUE, GL_FALSE,
                                  overlaytexPrgBin);
+    prog_impostor   = LOADPROGSHADER(shad_impostorVert, shad_impostorFrag,
+                                 GL_TRUE, GL_FALSE,
+                                 impostorPrgBin);
     success =  prog_solids && prog_leaves
             && prog_simplecol  && prog_simpletex
-            && prog_overlaycol && prog_overlaytex;
+            && prog_overlaycol && prog_overlaytex
+            && prog_impostor;
     if (!success) {
         NvGlDemoLog("Error occured loading shaders\n");
         return 0;
@@ -275,12 +530,36 @@ LoadShaders(void)
         return 0;
     }
 
+    // Load locations for impostor shader
+    uloc_impostorMvpMat   = glGetUniformLocation(prog_impostor, "mvpmatrix");
+    uloc_impostorTexUnit  = glGetUniformLocation(prog_impostor, "texunit");
+    aloc_impostorVertex   = glGetAttribLocation(prog_impostor,  "vertex");
+    aloc_impostorTexcoord = glGetAttribLocation(prog_impostor,  "texcoord");
+    aloc_impostorWeight   = glGetAttribLocation(prog_impostor,  "weight");
+    success =  (uloc_impostorMvpMat   >= 0)
+            && (uloc_impostorTexUnit  >= 0)
+            && (aloc_impostorVertex   >= 0)
+            && (aloc_impostorTexcoord >= 0)
+            && (aloc_impostorWeight   >= 0);
+    if (!success) {
+        NvGlDemoLog("Error occured retrieving impostor shader locations\n");
+        return 0;
+    }
+
+    loadBranchesShader();
+    loadForestShaders();
+
     return 1;
 }
 
 void
 FreeShaders(void)
 {
+    if (prog_forestcull)   glDeleteProgram(prog_forestcull);
+    if (prog_forestleaves) glDeleteProgram(prog_forestleaves);
+    if (prog_forestsolids) glDeleteProgram(prog_forestsolids);
+    if (prog_branches)   glDeleteProgram(prog_branches);
+    if (prog_impostor)   glDeleteProgram(prog_impostor);
     if (prog_overlaytex) glDeleteProgram(prog_overlaytex);
     if (prog_overlaycol) glDeleteProgram(prog_overlaycol);
     if (prog_simpletex)  glDeleteProgram(prog_simpletex);
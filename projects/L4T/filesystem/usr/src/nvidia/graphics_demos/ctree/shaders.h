@@ -86,6 +86,48 @@ extern GLint uloc_overlaytexTexUnit;
 extern GLint aloc_overlaytexVertex;
 extern GLint aloc_overlaytexTexcoord;
 
+// Impostor billboard shader
+extern GLint prog_impostor;
+extern GLint uloc_impostorMvpMat;
+extern GLint uloc_impostorTexUnit;
+extern GLint aloc_impostorVertex;
+extern GLint aloc_impostorTexcoord;
+extern GLint aloc_impostorWeight;
+
+// Branch shader expanding segment records on the GPU (OpenGL ES 3.0,
+//   optional so it is 0 if unsupported)
+extern GLint prog_branches;
+extern GLint uloc_branchesLights;
+extern GLint uloc_branchesLightPos;
+extern GLint uloc_branchesLightCol;
+extern GLint uloc_branchesMvpMat;
+extern GLint uloc_branchesTexUnit;
+extern GLint uloc_branchesSegments;
+extern GLint uloc_branchesFacets;
+extern GLint uloc_branchesRadius;
+
+// Instanced forest shaders and culling compute shader (OpenGL ES 3.1,
+//   optional so they are 0 if unsupported)
+extern GLint prog_forestsolids;
+extern GLint uloc_forestsolidsLights;
+extern GLint uloc_forestsolidsLightPos;
+extern GLint uloc_forestsolidsLightCol;
+extern GLint uloc_forestsolidsMvpMat;
+extern GLint uloc_forestsolidsTexUnit;
+extern GLint prog_forestleaves;
+extern GLint uloc_forestleavesLights;
+extern GLint uloc_forestleavesLightPos;
+extern GLint uloc_forestleavesLightCol;
+extern GLint uloc_forestleavesMvpMat;
+extern GLint uloc_forestleavesTexUnit;
+extern GLint prog_forestcull;
+extern GLint uloc_forestcullCount;
+extern GLint uloc_forestcullCapacity;
+extern GLint uloc_forestcullPlanes;
+extern GLint uloc_forestcullDepthRow;
+extern GLint uloc_forestcullBounds;
+extern GLint uloc_forestcullLodDistance;
+
 // Load/free shaders
 extern int  LoadShaders(void);
 extern void FreeShaders(void);
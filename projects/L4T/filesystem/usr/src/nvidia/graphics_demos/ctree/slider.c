@@ -29,7 +29,7 @@
 #include "nvgldemo.h"
 #include "vector.h"
 #include "slider.h"
-#include "shaders.h"
+#include "overlay.h"
 
 static int rodGeom[6][2] = {
     {4,  7},
@@ -181,37 +181,21 @@ Slider_setPos(
 }
 
 void
-Slider_draw(
+Slider_addToOverlay(
     Slider *o)
 {
-    unsigned short indices[8] = {0,6,1,7,3,9,5,11};
-    int            k;
-
-    // Load shader program and enable vertex array
-    glUseProgram(prog_overlaycol);
-    glEnableVertexAttribArray(aloc_overlaycolVertex);
-
-    // Draw slider
-    glEnableVertexAttribArray(aloc_overlaycolColor);
-    glVertexAttribPointer(aloc_overlaycolVertex,
-                          2, GL_FLOAT, GL_FALSE, 0, o->rodVertices);
-    glVertexAttribPointer(aloc_overlaycolColor,
-                          3, GL_FLOAT, GL_FALSE, 0, o->rodColors);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 6);
-    glDrawArrays(GL_TRIANGLE_STRIP, 6, 6);
-    glDrawElements(GL_TRIANGLE_STRIP, 8, GL_UNSIGNED_SHORT, indices);
-    glDisableVertexAttribArray(aloc_overlaycolColor);
-
-    // Draw knob
-    glVertexAttribPointer(aloc_overlaycolVertex,
-                          2, GL_FLOAT, GL_FALSE, 0, o->knobVertices);
+    static const unsigned short indices[8] = {0,6,1,7,3,9,5,11};
+    int k;
+
+    // Rod: the two edges and the highlight between them
+    Overlay_addColStrip(o->rodVertices, o->rodColors, NULL, 6);
+    Overlay_addColStrip(o->rodVertices + 6, o->rodColors + 6, NULL, 6);
+    Overlay_addColStrip(o->rodVertices, o->rodColors, indices, 8);
+
+    // Knob
     for (k=0; k<5; ++k) {
-        glVertexAttrib3fv(aloc_overlaycolColor, o->knobColors[k]);
-        glDrawElements(GL_TRIANGLE_FAN, 4, GL_UNSIGNED_INT, knobPolys[k]);
+        Overlay_addColFan(o->knobVertices, o->knobColors[k], knobPolys[k], 4);
     }
-
-    // Disable vertex array
-    glDisableVertexAttribArray(aloc_overlaycolVertex);
 }
 
 GLboolean
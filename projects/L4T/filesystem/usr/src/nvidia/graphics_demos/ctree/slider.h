@@ -65,6 +65,6 @@ float Slider_getValue(Slider *o);
 void Slider_select(Slider *o, GLboolean sel);
 
 // Rendering
-void Slider_draw(Slider *o);
+void Slider_addToOverlay(Slider *o);
 
 #endif // __SLIDER_H
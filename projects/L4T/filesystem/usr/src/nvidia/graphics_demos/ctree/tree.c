@@ -31,8 +31,8 @@
 #include "tree.h"
 #include "branches.h"
 #include "leaves.h"
-#include "ground.h"
 #include "buildtree.h"
+#include "meshcache.h"
 
 // parameters to control the tree generation.
 float treeParams[NUM_TREE_PARAMS] = {
@@ -70,6 +70,18 @@ float treeParamsMax[NUM_TREE_PARAMS] = {
 static GLboolean geometryDirty = GL_FALSE;
 static GLboolean isVBO;
 
+// Write the next generated tree to the mesh cache. Only the first tree
+//   and the ones requested by Tree_save are written, so that dragging a
+//   slider doesn't leave a file behind for every step.
+static GLboolean saveGenerated = GL_TRUE;
+
+// Incremented each time the geometry is rebuilt
+static int generation = 0;
+
+// Bounding sphere of the tree geometry
+static float3 boundsCenter;
+static float  boundsRadius;
+
 void
 Tree_newCharacter()
 {
@@ -81,20 +93,28 @@ Tree_newCharacter()
 static void
 build(void)
 {
+    // The arrays may still point into the previous cache file
     Branches_clear();
     Leaves_clear();
+    MeshCache_release();
 
-    BuildTree_generate();
+    if (!MeshCache_load()) {
+        BuildTree_generate();
+        if (saveGenerated && MeshCache_enabled()) {
+            MeshCache_save();
+            saveGenerated = GL_FALSE;
+        }
+    }
+    Branches_buildSegments();
 
     isVBO = useVBO;
 
     if (useVBO) {
         // initialize the VBO area.
-        if (VBO_setup(Leaves_sizeVBO()+Branches_sizeVBO()+Ground_sizeVBO()))
+        if (VBO_setup(Leaves_sizeVBO()+Branches_sizeVBO()))
         {
             Leaves_buildVBO();
             Branches_buildVBO();
-            Ground_buildVBO();
 
             isVBO = GL_TRUE;
         } else {
@@ -105,8 +125,29 @@ build(void)
         isVBO = GL_FALSE;
     }
 
+    // Bound the tree for culling
+    {
+        float3 lo = { 1e10f,  1e10f,  1e10f};
+        float3 hi = {-1e10f, -1e10f, -1e10f};
+        float3 d;
+        Leaves_extendBounds(lo, hi);
+        Branches_extendBounds(lo, hi);
+        add_f3(boundsCenter, lo, hi);
+        multi_f3f(boundsCenter, 0.5f);
+        set_3(d, hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]);
+        boundsRadius = 0.5f * SQRT(dot_3(d, d));
+    }
+
+    // Everything needed for drawing is on the GPU now
+    if (isVBO && gpuResident) {
+        Leaves_release();
+        Branches_release();
+        MeshCache_release();
+    }
+
     // Mark the dirty bit false.
     geometryDirty = GL_FALSE;
+    generation++;
 }
 
 void
@@ -130,6 +171,7 @@ Tree_deinitialize(void)
 {
     Leaves_deinitialize();
     Branches_deinitialize();
+    MeshCache_release();
     if (useVBO) {
         VBO_deinit();
     }
@@ -138,16 +180,23 @@ Tree_deinitialize(void)
 
 
 
-void
-Tree_draw(void)
+// Rebuild the geometry if needed, returns whether it was rebuilt
+GLboolean
+Tree_update(void)
 {
     if (geometryDirty) {
         build();
+        return GL_TRUE;
     }
+    return GL_FALSE;
+}
+
+void
+Tree_draw(void)
+{
+    Tree_update();
     Leaves_draw(isVBO);
     Branches_draw(isVBO);
-
-    Ground_draw(isVBO);
 }
 
 
@@ -168,3 +217,82 @@ Tree_toggleVBO(void)
         geometryDirty = GL_TRUE;
     }
 }
+
+void
+Tree_toggleGPUBranches(void)
+{
+    if (Branches_gpuSupported()) {
+        Branches_setGPU(!Branches_isGPU());
+        geometryDirty = GL_TRUE;
+        NvGlDemoLog("GPU branch expansion %s\n",
+                    Branches_isGPU() ? "enabled" : "disabled");
+    } else {
+        NvGlDemoLog("GPU branch expansion is not supported\n");
+    }
+}
+
+// Keep the geometry only in video memory once it is built. Client arrays
+//   (Tree_toggleVBO) still work, they just keep the CPU copies. The
+//   branch strips then need primitive restart, so this is OpenGL ES 3 only.
+void
+Tree_setResident(
+    GLboolean enable)
+{
+    if (enable && !NvGlDemoHasGlesVersion(3, 0)) {
+        NvGlDemoLog("GPU resident geometry requires OpenGL ES 3.0\n");
+        enable = GL_FALSE;
+    }
+    gpuResident = enable;
+    geometryDirty = GL_TRUE;
+}
+
+// Make sure the current tree is in the mesh cache. The tree is rebuilt,
+//   which loads it if it's already there and writes it otherwise.
+void
+Tree_save(void)
+{
+    if (!MeshCache_enabled()) {
+        NvGlDemoLog("Mesh cache is disabled (-meshcache <dir>)\n");
+        return;
+    }
+    saveGenerated = GL_TRUE;
+    geometryDirty = GL_TRUE;
+}
+
+// Query the bytes of system and video memory held by the tree geometry
+void
+Tree_memoryUsage(
+    unsigned int *cpu,
+    unsigned int *gpu)
+{
+    *cpu = *gpu = 0;
+    Leaves_memoryUsage(cpu);
+    Branches_memoryUsage(cpu, gpu);
+    if (isVBO) {
+        *gpu += VBO_size();
+    }
+}
+
+// Query whether the geometry currently lives in the VBO
+GLboolean
+Tree_isVBO(void)
+{
+    return isVBO;
+}
+
+// Query the geometry build count, to detect rebuilds
+int
+Tree_generation(void)
+{
+    return generation;
+}
+
+// Query the bounding sphere of the tree in tree space
+void
+Tree_getBounds(
+    float center[3],
+    float *radius)
+{
+    copy_3(center, boundsCenter);
+    *radius = boundsRadius;
+}
@@ -52,13 +52,23 @@ void Tree_deinitialize(void);
 
 // Control
 void Tree_toggleVBO(void);
+void Tree_toggleGPUBranches(void);
+void Tree_setResident(GLboolean enable);
 void Tree_setParam(int param, float val);
 
 // Geometry setup
 void Tree_newCharacter(void);
 void Tree_build(void);
+void Tree_save(void);
+
+// Query
+GLboolean Tree_isVBO(void);
+int  Tree_generation(void);
+void Tree_getBounds(float center[3], float *radius);
+void Tree_memoryUsage(unsigned int *cpu, unsigned int *gpu);
 
 // Rendering
+GLboolean Tree_update(void);
 void Tree_draw(void);
 
 #endif // __TREE_H
@@ -31,8 +31,11 @@
 
 static long vboptr = 0;
 static unsigned int vbosize = 0;
+static unsigned int vbototal = 0;
+GLuint vboName = 0;
 int vboInitialized = 0;
 int useVBO = 0;
+int gpuResident = 0;
 
 GLboolean
 VBO_init(void)
@@ -45,13 +48,12 @@ VBO_init(void)
 void
 VBO_deinit(void)
 {
-    GLuint bufs[] = { VBO_NAME };
-
-    if (vboInitialized) {
-        glDeleteBuffers(sizeof bufs / sizeof *bufs, bufs);
+    if (vboInitialized && vboName) {
+        glDeleteBuffers(1, &vboName);
+        vboName = 0;
     }
 
-    vbosize = vboptr = 0;
+    vbosize = vboptr = vbototal = 0;
 }
 
 GLboolean
@@ -64,10 +66,11 @@ VBO_setup(
     while (glGetError() != GL_NO_ERROR);
 
     VBO_deinit();
+    glGenBuffers(1, &vboName);
     glBindBuffer(GL_ARRAY_BUFFER, VBO_NAME);
     glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
     if ((res = glGetError()) == GL_NO_ERROR) {
-        vbosize = size;
+        vbosize = vbototal = size;
         return GL_TRUE;
     }
     else {
@@ -94,3 +97,36 @@ VBO_alloc(
     }
     return ret;
 }
+
+// Copy data into an allocated range of the VBO, which must be bound to
+//   GL_ARRAY_BUFFER. In GPU resident mode the data is written through a
+//   mapping of just that range, so the driver doesn't need to keep its
+//   own staging copy alive alongside ours.
+void
+VBO_write(
+    unsigned long offset,
+    int           size,
+    const void    *data)
+{
+    void *dst;
+
+    if (!size) return;
+
+    if (gpuResident) {
+        dst = glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+                               GL_MAP_WRITE_BIT |
+                               GL_MAP_INVALIDATE_RANGE_BIT);
+        if (dst) {
+            MEMCPY(dst, data, size);
+            if (glUnmapBuffer(GL_ARRAY_BUFFER)) return;
+        }
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+}
+
+// Query the size of the VBO in bytes
+unsigned int
+VBO_size(void)
+{
+    return vbototal;
+}
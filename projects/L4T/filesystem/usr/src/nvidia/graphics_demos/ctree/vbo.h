@@ -45,7 +45,8 @@ extern int   vertCount;
 #endif
 
 // All objects share a single VBO
-#define VBO_NAME 1
+extern GLuint vboName;
+#define VBO_NAME vboName
 
 // Macro to align elements properly when packed into the VBO
 #define VBO_ALIGNMENT 4
@@ -55,10 +56,16 @@ extern int   vertCount;
 extern int   vboInitialized;
 extern int   useVBO;
 
+// Flag requesting that the CPU copies of the geometry are released once
+//   it has been written to the VBO
+extern int   gpuResident;
+
 // Initialization and clean-up
 GLboolean    VBO_init  (void);
 void         VBO_deinit(void);
 unsigned long VBO_alloc (int size);
 GLboolean    VBO_setup (int size);
+void         VBO_write (unsigned long offset, int size, const void *data);
+unsigned int VBO_size  (void);
 
 #endif // __VBO_H
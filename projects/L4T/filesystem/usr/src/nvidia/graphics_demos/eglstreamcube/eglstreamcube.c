@@ -108,6 +108,7 @@ typedef struct ClientState
     EGLStreamKHR    stream;
     EGLNativeFileDescriptorKHR fd;
     GLuint          texture;
+    NvGlDemoStreamStats stats;          // Telemetry, if -streamstats is given
 } ClientState;
 
 ClientState clientList[CUBE_MAX_CLIENTS];
@@ -377,6 +378,11 @@ deadClient(ClientState *client)
     client->texture = CLIENT_NO_TEXTURE;
     if (client->stream != EGL_NO_STREAM_KHR) {
         EGLint state = 0;
+
+        if (demoOptions.streamStats >= 0.0f) {
+            NvGlDemoStreamStatsReport(&client->stats, SYSTIME());
+        }
+
         eglQueryStreamKHR(demoState.display, client->stream,
                           EGL_STREAM_STATE_KHR, &state);
         // Release the acquired frame if the stream hasn't disconnected yet.
@@ -405,6 +411,7 @@ newClient(int socketFD, ClientState *client, GLuint texture)
 {
     EGLint streamAttr[7] = { EGL_STREAM_FIFO_LENGTH_KHR, 4, EGL_NONE };
     int numAttrs= 0;
+    char name[16];
     struct sockaddr_un conn_addr = { 0 };
     struct msghdr msg = { 0 };
     struct cmsghdr *cmsg;
@@ -441,6 +448,13 @@ newClient(int socketFD, ClientState *client, GLuint texture)
         goto fail;
     }
 
+    if (demoOptions.streamStats >= 0.0f) {
+        SNPRINTF(name, sizeof(name), "face%d", (int)(client - clientList));
+        NvGlDemoStreamStatsInit(&client->stats, name, NvGlDemoStreamEglOps(),
+                                (void*)client->stream, demoOptions.nFifo,
+                                0, SYSTIME());
+    }
+
     client->fd = eglGetStreamFileDescriptorKHR(demoState.display, client->stream);
     if (client->fd == EGL_NO_FILE_DESCRIPTOR_KHR) {
         NvGlDemoLog("Couldn't get stream file descriptor.\n");
@@ -489,6 +503,7 @@ static GLboolean
 clientMethodPoll(void)
 {
     unsigned char i;
+    long long now = SYSTIME();
 
     for (i = 0; i < CUBE_MAX_CLIENTS; i++) {
         clientList[i].texture = CLIENT_NO_TEXTURE;
@@ -518,6 +533,11 @@ clientMethodPoll(void)
                     deadClient(&clientList[i]);
                     break;
                 case EGL_STREAM_STATE_EMPTY_KHR:
+                    /* No new frame, the face shows the previous one */
+                    if (demoOptions.streamStats >= 0.0f) {
+                        NvGlDemoStreamStatsAcquire(&clientList[i].stats,
+                                                   EGL_FALSE);
+                    }
                     break;
                 case EGL_STREAM_STATE_CONNECTING_KHR:
                     break;
@@ -533,8 +553,18 @@ clientMethodPoll(void)
                 /* We have a valid texture this time around. */
                 clientList[i].texture = clientTexturePool[i];
 
+                if (demoOptions.streamStats >= 0.0f) {
+                    NvGlDemoStreamStatsAcquire(&clientList[i].stats,
+                                               EGL_TRUE);
+                }
             }
         }
+
+        if ((clientList[i].stream != EGL_NO_STREAM_KHR)
+            && (demoOptions.streamStats >= 0.0f)) {
+            NvGlDemoStreamStatsPoll(&clientList[i].stats,
+                                    demoOptions.streamStats, now);
+        }
     }
 
     return GL_TRUE;
@@ -758,7 +788,7 @@ int main(int argc, char **argv)
     // If any frames were generated, print the framerate
     if (frames) {
         NvGlDemoLog("Total FPS: %f\n",
-                    (float)frames / ((currTime - startTime) / 1000000000ull));
+                    (float)frames / ((currTime - startTime) / 1000000000.0));
     }
 
     // Otherwise something went wrong. Print usage message in case it
@@ -35,6 +35,9 @@
 // The default number of seconds after which the test will end.
 #define TIME_LIMIT 5.0
 
+// Largest gear field allowed for the stress mode
+#define MAX_FIELD 1000000
+
 // Flag indicating it is time to shut down
 static GLboolean shutdown = GL_FALSE;
 
@@ -72,6 +75,9 @@ int main(int argc, char **argv)
     int         frames     = 0;
     float       angle      = 0.0;
     float       color[4];
+    int         field      = 0;
+    int         instancing = 1;
+    double      seconds;
     int         i;
 
     // Initialize window system and EGL
@@ -89,15 +95,47 @@ int main(int argc, char **argv)
     NvGlDemoSetResizeCB(resizeCB);
     NvGlDemoSetKeyCB(keyCB);
 
-    // Querying -clearColor arguments
-    if (argc > 2) {
-        for (i = 1; i < argc; i++) {
-            if (NvGlDemoArgMatchFlt(&argc, argv, i, "-clearColor",
-                        "<R G B A> (float)", 0.0f, 1.0f, 4, color)) {
-                glClearColor(color[0], color[1], color[2], color[3]);
-                break;
-            }
+    // Parse non-generic command line options, leaving anything else for
+    //   the legacy runtime argument
+    i = 1;
+    while (i < argc) {
+        // Background color
+        if (NvGlDemoArgMatchFlt(&argc, argv, i, "-clearColor",
+                    "<R G B A> (float)", 0.0f, 1.0f, 4, color)) {
+            glClearColor(color[0], color[1], color[2], color[3]);
+        }
+
+        // Stress field of gears
+        else if (NvGlDemoArgMatchInt(&argc, argv, i, "-gears",
+                                     "<count>", 1, MAX_FIELD,
+                                     1, &field)) {
+            // No additional action needed
+        }
+
+        // Draw the field one gear at a time
+        else if (NvGlDemoArgMatch(&argc, argv, i, "-noinstancing")) {
+            instancing = 0;
+        }
+
+        // Bad option value
+        else if (NvGlDemoArgFailed()) {
+            goto done;
         }
+
+        // Something else
+        else {
+            i++;
+        }
+    }
+
+    // Set up the stress field
+    if (field) {
+        if (!gearsFieldInit(field, instancing)) {
+            goto done;
+        }
+        NvGlDemoLog(" drawing %d gears, %d triangles in %d draws per frame\n",
+                    gearsFieldCount(), gearsFieldTriangles(),
+                    gearsFieldDraws());
     }
 
     // If -1 wasn't specified, and a duration <= 0.0 was given, it means the
@@ -137,7 +175,11 @@ int main(int argc, char **argv)
     // Main loop.
     do {
         // Draw a frame
-        gearsRender(angle);
+        if (field) {
+            gearsFieldRender(angle);
+        } else {
+            gearsRender(angle);
+        }
 
         // Execute PreSwap functions
         if (!NvGlDemoPreSwapExec()) {
@@ -169,10 +211,16 @@ int main(int argc, char **argv)
 
     done:
 
-    // If any frames were generated, print the framerate
+    // If any frames were generated, print the framerate, and the gear and
+    //   triangle rates of the stress field
     if (frames) {
-        NvGlDemoLog("Total FPS: %f\n",
-                    (float)frames / ((currTime - startTime) / 1000000000ull));
+        seconds = (double)(currTime - startTime) / 1000000000.0;
+        NvGlDemoLog("Total FPS: %f\n", (float)(frames / seconds));
+        if (field) {
+            NvGlDemoLog("Gears/sec: %.0f, triangles/sec: %.0f\n",
+                        frames * (double)gearsFieldCount() / seconds,
+                        frames * (double)gearsFieldTriangles() / seconds);
+        }
     }
 
     // Otherwise something went wrong. Print usage message in case it
@@ -181,7 +229,12 @@ int main(int argc, char **argv)
         NvGlDemoLog("Usage: gears [options] [runtime]\n"
                     "  (negative runtime means \"forever\")\n" );
         NvGlDemoLog("\n  Clear color option:\n"
-                    "    [-clearColor <r> <g> <b> <a>] (background color)\n\n");
+                    "    [-clearColor <r> <g> <b> <a>] (background color)\n");
+        NvGlDemoLog("\n  Stress options:\n"
+                    "    [-gears <count>]  (draw a field of gears, instanced "
+                    "if the context is ES 3)\n"
+                    "    [-noinstancing]   (draw the field one gear at a "
+                    "time)\n\n");
         NvGlDemoLog(NvGlDemoArgUsageString());
     }
 
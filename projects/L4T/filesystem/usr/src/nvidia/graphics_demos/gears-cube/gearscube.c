@@ -69,12 +69,19 @@ static GLboolean shutdown = GL_FALSE;
 //    which did not provide framebuffer objects without extension.
 //    Binding is preferable to copying, but is not required to be
 //    supported by all platforms.
+// 4) Texture bound to framebuffer object of the main context:
+//    Like 1), but the gears are rendered by the same context as the
+//    cube, so no eglMakeCurrent is needed each frame. The gears' GL
+//    state is kept apart by their own program and vertex array objects.
+//    Each cube face can have its own independently animated texture,
+//    and the gears can be rendered multisampled and resolved into them.
 // Note: Two other possible variants which we don't recommend and don't
 //   provide examples for are creating a texture or renderbuffer, binding
 //   that to an EGLImage, and then binding that to a renderbuffer or
 //   texture. These paths add the extra overhead of involving EGL without
 //   any benefit over the other methods.
 #define METHOD_FRAMEBUFFER
+#define METHOD_MAINFRAMEBUFFER
 #define METHOD_PBUFFER
 #if defined(EGL_KHR_image_pixmap) && defined(GL_OES_EGL_image)
 #define METHOD_PIXMAP
@@ -85,6 +92,9 @@ typedef enum {
     #ifdef METHOD_FRAMEBUFFER
     Method_Framebuffer,
     #endif
+    #ifdef METHOD_MAINFRAMEBUFFER
+    Method_MainFramebuffer,
+    #endif
     #ifdef METHOD_PIXMAP
     Method_Pixmap,
     #endif
@@ -93,7 +103,38 @@ typedef enum {
     #endif
     Method_Count
 } Methods;
-Methods method = (Methods)0;
+
+// Selected method. Method_Count means the fastest method is chosen by
+//   calibration at startup.
+Methods method = Method_Count;
+
+// Names of the methods, as given to -method
+static const char* methodNames[Method_Count] = {
+    #ifdef METHOD_FRAMEBUFFER
+    "fbo",
+    #endif
+    #ifdef METHOD_MAINFRAMEBUFFER
+    "fbomain",
+    #endif
+    #ifdef METHOD_PIXMAP
+    "pixmap",
+    #endif
+    #ifdef METHOD_PBUFFER
+    "pbuffercopy",
+    #endif
+};
+
+// Number of frames each method is timed over when calibrating by default
+#define CALIBRATE_FRAMES 60
+
+// Time spent in each stage of getting a gears frame onto the cube, in
+//   nanoseconds, accumulated over the calibration frames
+typedef struct {
+    long long switching;    // eglMakeCurrent to and from the gears context
+    long long render;       // Rendering the gears
+    long long copy;         // Copying the gears to the texture, if needed
+    long long draw;         // Drawing the cube with the texture
+} MethodTiming;
 
 // Pixmap/image support fields
 #ifdef METHOD_PIXMAP
@@ -110,6 +151,36 @@ GLuint          gearsFBO = 0;
 GLuint          gearsRBO = 0;
 #endif // METHOD_FRAMEBUFFER
 
+// Main context framebuffer object support fields
+//   Target 0 renders to gearsTexture, and the others to textures of their
+//   own. When multisampling, the gears are rendered to one shared set of
+//   multisampled buffers and resolved into each target.
+#ifdef METHOD_MAINFRAMEBUFFER
+#define MAX_TARGETS 6
+GLint           targetCount = 1;
+GLint           msaaSamples = 0;
+GLuint          targetTex[MAX_TARGETS];
+GLuint          targetFBO[MAX_TARGETS];
+GLuint          targetDepth = 0;
+GLuint          msaaFBO     = 0;
+GLuint          msaaColor   = 0;
+#endif // METHOD_MAINFRAMEBUFFER
+
+// Policies for how often the gears texture is rendered. In between, the
+//   cube reuses the last texture.
+typedef enum {
+    Update_EveryFrame,      // Each displayed frame
+    Update_Rate,            // At most a fixed number of times per second
+    Update_Interval,        // Every Nth displayed frame
+    Update_Density          // Less often the more the texture is minified
+} UpdatePolicy;
+UpdatePolicy    updatePolicy   = Update_EveryFrame;
+GLfloat         updateRate     = 30.0f;
+GLint           updateInterval = 1;
+
+// Longest interval in frames for the density driven policy
+#define MAX_DENSITY_INTERVAL 8
+
 // Gears rendering context/surfaces
 GLint           texSize = 256;
 EGLConfig       gearsConfig;
@@ -122,9 +193,20 @@ GLint           prog_cube = 0;
 GLint           uloc_cubeCameraMat;
 GLint           uloc_cubeObjectMat;
 GLint           uloc_cubeTexUnit;
+GLint           aloc_cubeVtxPos;
+GLint           aloc_cubeVtxTex;
+GLint           cubeWidth;
+GLint           cubeHeight;
+GLfloat         cubeCameraMat[16];
+GLfloat         cubeObjectMat[16];
+GLboolean       cubeDrawn = GL_FALSE;
 const GLfloat   depthnear =  5.0f;
 const GLfloat   depthfar  = 60.0f;
 
+// Distance to the center of the cube and its half size
+#define CUBE_DISTANCE 30.0f
+#define CUBE_SCALE     3.0f
+
 // Cube vertex positions and texture coordinates
 //   Shader maps texture coordinates [-1,+1] to [0,1] and solid fills
 //   anything outside the texture. We pass +/- 1.1 to leave a small border.
@@ -192,9 +274,37 @@ cubeViewSet(
                               depthnear, depthfar);
     }
     glUniformMatrix4fv(uloc_cubeCameraMat, 1, GL_FALSE, matrix);
+    MEMCPY(cubeCameraMat, matrix, sizeof(cubeCameraMat));
 
-    // Set viewport
+    // Set viewport, and remember it in case gears rendering changes it
     glViewport(0, 0, width, height);
+    cubeWidth  = width;
+    cubeHeight = height;
+}
+
+// Point the cube attributes at the client side vertex array. This is
+//   redone each frame in case the gears were rendered in this context.
+static void
+cubeAttribSet(void)
+{
+    glVertexAttribPointer(aloc_cubeVtxPos, 3, GL_FLOAT, GL_FALSE,
+                          5*sizeof(GLfloat), &cubeVert[0][0]);
+    glEnableVertexAttribArray(aloc_cubeVtxPos);
+    glVertexAttribPointer(aloc_cubeVtxTex, 2, GL_FLOAT, GL_FALSE,
+                          5*sizeof(GLfloat), &cubeVert[0][3]);
+    glEnableVertexAttribArray(aloc_cubeVtxTex);
+}
+
+// Texture to apply to a cube face
+static GLuint
+cubeFaceTexture(
+    int face)
+{
+    #ifdef METHOD_MAINFRAMEBUFFER
+    if ((method == Method_MainFramebuffer) && targetTex[face % targetCount])
+        return targetTex[face % targetCount];
+    #endif // METHOD_MAINFRAMEBUFFER
+    return gearsTexture;
 }
 
 // Initialize cube rendering context
@@ -203,8 +313,6 @@ cubeSceneInit(
     int     width,
     int     height)
 {
-    GLuint  aloc;
-
     // Make main context current
     eglMakeCurrent(demoState.display,
                    demoState.surface, demoState.surface,
@@ -222,14 +330,9 @@ cubeSceneInit(
     uloc_cubeTexUnit   = glGetUniformLocation(prog_cube, "texunit");
 
     // Set and enable cube coordinates
-    aloc = glGetAttribLocation(prog_cube, "vtxpos");
-    glVertexAttribPointer(aloc, 3, GL_FLOAT, GL_FALSE, 5*sizeof(GLfloat),
-                          &cubeVert[0][0]);
-    glEnableVertexAttribArray(aloc);
-    aloc = glGetAttribLocation(prog_cube, "vtxtex");
-    glVertexAttribPointer(aloc, 2, GL_FLOAT, GL_FALSE, 5*sizeof(GLfloat),
-                          &cubeVert[0][3]);
-    glEnableVertexAttribArray(aloc);
+    aloc_cubeVtxPos = glGetAttribLocation(prog_cube, "vtxpos");
+    aloc_cubeVtxTex = glGetAttribLocation(prog_cube, "vtxtex");
+    cubeAttribSet();
 
     // Set up texture to be used for the gears
     glUniform1i(uloc_cubeTexUnit, 0);
@@ -259,34 +362,84 @@ cubeSceneRender(void)
     GLfloat                 matrix[16];
     GLint                   i;
 
-    // Make main context current
-    eglMakeCurrent(demoState.display,
-                   demoState.surface, demoState.surface,
-                   demoState.context);
+    // Make main context current, if gears are rendered in another
+    if (gearsContext != EGL_NO_CONTEXT)
+        eglMakeCurrent(demoState.display,
+                       demoState.surface, demoState.surface,
+                       demoState.context);
 
-    // Clear buffer
+    // Restore the viewport and clear color, and clear buffer
+    glViewport(0, 0, cubeWidth, cubeHeight);
+    glClearColor(0.2f, 0.1f, 0.2f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Make sure cube program is current
+    // Make sure cube program and vertex arrays are current
     glUseProgram(prog_cube);
+    cubeAttribSet();
 
     // Rotate the cube and set up object transformation matrix
     angA += 0.175f;
     angB += 0.050f;
     NvGlDemoMatrixIdentity(matrix);
-    NvGlDemoMatrixTranslate(matrix, 0.0f, 0.0f, -30.0f);
+    NvGlDemoMatrixTranslate(matrix, 0.0f, 0.0f, -CUBE_DISTANCE);
     NvGlDemoMatrixRotate(matrix, angA, 0.6f, 0.8f, 0.0f);
     NvGlDemoMatrixRotate(matrix, angB, 0.0f, 1.0f, 1.0f);
-    NvGlDemoMatrixScale(matrix, 3.0f, 3.0f, 3.0f);
+    NvGlDemoMatrixScale(matrix, CUBE_SCALE, CUBE_SCALE, CUBE_SCALE);
     glUniformMatrix4fv(uloc_cubeObjectMat, 1, GL_FALSE, matrix);
+    MEMCPY(cubeObjectMat, matrix, sizeof(cubeObjectMat));
+    cubeDrawn = GL_TRUE;
 
     // Draw each face of the cube
-    for (i=0; i<6; ++i)
+    for (i=0; i<6; ++i) {
+        glBindTexture(GL_TEXTURE_2D, cubeFaceTexture(i));
         glDrawArrays(GL_TRIANGLE_STRIP, 4*i, 4);
+    }
 
     return (glGetError() == GL_NO_ERROR) ? GL_TRUE : GL_FALSE;
 }
 
+// Approximate on-screen pixels per gears texel along a face edge, for the
+//   largest face in the last cube frame drawn. Each face's corners are
+//   projected with the cube's matrices, and the face area in pixels is
+//   compared with the texels shown on it. The texture covers 1/1.1 of the
+//   face in each direction (see cubeVert).
+static GLfloat
+cubeTexelDensity(void)
+{
+    GLfloat mvp[16];
+    GLfloat largest = 0.0f;
+    int     i, j;
+
+    // Nothing to measure yet, so treat the texture as fully visible
+    if (!cubeDrawn) return 1.0f;
+
+    MEMCPY(mvp, cubeCameraMat, sizeof(mvp));
+    NvGlDemoMatrixMultiply(mvp, cubeObjectMat);
+
+    for (i=0; i<6; ++i) {
+        // Corners in outline order (the strip is 0, 1, 2, 3)
+        static const int outline[4] = { 0, 1, 3, 2 };
+        GLfloat x[4], y[4], area = 0.0f;
+
+        for (j=0; j<4; ++j) {
+            const GLfloat *vtx = cubeVert[4*i + outline[j]];
+            GLfloat pos[4];
+
+            pos[0] = vtx[0]; pos[1] = vtx[1]; pos[2] = vtx[2]; pos[3] = 1.0f;
+            NvGlDemoMatrixVectorMultiply(mvp, pos);
+            x[j] = 0.5f * cubeWidth  * pos[0] / pos[3];
+            y[j] = 0.5f * cubeHeight * pos[1] / pos[3];
+        }
+        for (j=0; j<4; ++j) {
+            area += x[j] * y[(j+1) & 3] - x[(j+1) & 3] * y[j];
+        }
+        area = 0.5f * ((area < 0.0f) ? -area : area);
+        if (area > largest) largest = area;
+    }
+
+    return SQRT(largest) / (1.1f * texSize);
+}
+
 // Clean up GL resources for cube
 static void
 cubeSceneTerm(void)
@@ -311,6 +464,186 @@ cubeSceneTerm(void)
 
 //===========================================================================
 
+// Wait for the GPU, then add the time since the mark to a stage total
+//   and move the mark up to now
+static void
+methodLap(
+    long long *total,
+    long long *mark)
+{
+    long long now;
+
+    glFinish();
+    now = SYSTIME();
+    *total += now - *mark;
+    *mark = now;
+}
+
+#ifdef METHOD_MAINFRAMEBUFFER
+// Set up framebuffers of the main context to render the gears into
+static GLboolean
+gearsTargetsInit(void)
+{
+    GLint maxSamples = 0;
+    int   t;
+
+    // Everything happens in the main context
+    eglMakeCurrent(demoState.display,
+                   demoState.surface, demoState.surface,
+                   demoState.context);
+
+    // Multisampling needs OpenGL ES 3, and is limited by the driver
+    if (msaaSamples && !NvGlDemoHasGlesVersion(3, 0)) {
+        NvGlDemoLog("Multisampling needs OpenGL ES 3, disabled\n");
+        msaaSamples = 0;
+    }
+    if (msaaSamples) {
+        glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+        if (msaaSamples > maxSamples) {
+            NvGlDemoLog("Multisampling limited to %d samples\n", maxSamples);
+            msaaSamples = maxSamples;
+        }
+    }
+
+    // Create the multisampled buffers, or a plain depth buffer
+    glGenRenderbuffers(1, &targetDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, targetDepth);
+    if (msaaSamples) {
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, msaaSamples,
+                                         GL_DEPTH_COMPONENT16,
+                                         texSize, texSize);
+        glGenRenderbuffers(1, &msaaColor);
+        glBindRenderbuffer(GL_RENDERBUFFER, msaaColor);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, msaaSamples,
+                                         GL_RGBA8, texSize, texSize);
+        glGenFramebuffers(1, &msaaFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                  GL_RENDERBUFFER, msaaColor);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                  GL_RENDERBUFFER, targetDepth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER)
+            != GL_FRAMEBUFFER_COMPLETE) {
+            NvGlDemoLog("Couldn't create multisampled framebuffer\n");
+            return GL_FALSE;
+        }
+    } else {
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16,
+                              texSize, texSize);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // Create a fresh texture image and framebuffer for each target. The
+    //   format matches the multisampled color buffer, as resolving needs.
+    for (t=0; t<targetCount; t++) {
+        if (t) {
+            glGenTextures(1, &targetTex[t]);
+            glBindTexture(GL_TEXTURE_2D, targetTex[t]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
+                            GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
+                            GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        } else {
+            targetTex[t] = gearsTexture;
+            glBindTexture(GL_TEXTURE_2D, targetTex[t]);
+        }
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texSize, texSize, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+        glGenFramebuffers(1, &targetFBO[t]);
+        glBindFramebuffer(GL_FRAMEBUFFER, targetFBO[t]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D, targetTex[t], 0);
+        if (!msaaSamples) {
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                      GL_RENDERBUFFER, targetDepth);
+        }
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER)
+            != GL_FRAMEBUFFER_COMPLETE) {
+            NvGlDemoLog("Couldn't create framebuffer for target %d\n", t);
+            return GL_FALSE;
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, gearsTexture);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Initialize the resources needed for gears rendering
+    if (!gearsInit(texSize, texSize))
+        return GL_FALSE;
+
+    // Check for GL errors
+    return (glGetError() == GL_NO_ERROR) ? GL_TRUE : GL_FALSE;
+}
+
+// Render a gears frame to each target, each with its own speed and phase
+static void
+gearsTargetsRender(
+    int           angle,
+    MethodTiming *timing,
+    long long    *mark)
+{
+    static const GLenum discard[2] = {
+        GL_COLOR_ATTACHMENT0, GL_DEPTH_ATTACHMENT
+    };
+    int t;
+
+    for (t=0; t<targetCount; t++) {
+        int speed = (t % 3) + 1;
+
+        // Render into the multisampled buffers or the target directly,
+        //   restoring the gears state the cube pass changed
+        glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO ? msaaFBO : targetFBO[t]);
+        glViewport(0, 0, texSize, texSize);
+        gearsSetState();
+        gearsRender((GLfloat)(((t & 1) ? -speed : speed) * angle + 60 * t));
+        if (timing) methodLap(&timing->render, mark);
+
+        // Resolve into the target, then let the multisampled contents go
+        if (msaaFBO) {
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFBO[t]);
+            glBlitFramebuffer(0, 0, texSize, texSize,
+                              0, 0, texSize, texSize,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glInvalidateFramebuffer(GL_READ_FRAMEBUFFER, 2, discard);
+            if (timing) methodLap(&timing->copy, mark);
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Clean up the main context framebuffers
+static void
+gearsTargetsTerm(void)
+{
+    int t;
+
+    for (t=0; t<MAX_TARGETS; t++) {
+        if (targetFBO[t]) {
+            glDeleteFramebuffers(1, &targetFBO[t]);
+            targetFBO[t] = 0;
+        }
+        if (targetTex[t] && (targetTex[t] != gearsTexture))
+            glDeleteTextures(1, &targetTex[t]);
+        targetTex[t] = 0;
+    }
+    if (msaaFBO) {
+        glDeleteFramebuffers(1, &msaaFBO);
+        msaaFBO = 0;
+    }
+    if (msaaColor) {
+        glDeleteRenderbuffers(1, &msaaColor);
+        msaaColor = 0;
+    }
+    if (targetDepth) {
+        glDeleteRenderbuffers(1, &targetDepth);
+        targetDepth = 0;
+    }
+}
+#endif // METHOD_MAINFRAMEBUFFER
+
 // Initialize the gears rendering methods
 static GLboolean
 gearsMethodInit(void)
@@ -345,6 +678,12 @@ gearsMethodInit(void)
         };
     #endif // METHOD_PBUFFER
 
+    // Rendering in the main context needs no config or context of its own
+    #ifdef METHOD_MAINFRAMEBUFFER
+    if (method == Method_MainFramebuffer)
+        return gearsTargetsInit();
+    #endif // METHOD_MAINFRAMEBUFFER
+
     // Adjust config settings based on method
     switch (method) {
 
@@ -530,18 +869,37 @@ gearsMethodInit(void)
     return (glGetError() == GL_NO_ERROR) ? GL_TRUE : GL_FALSE;
 }
 
-// Render a gears frame to the texture
+// Render a gears frame to the texture. If timing is requested, each stage
+//   is waited for and its time accumulated.
 static GLboolean
 gearsMethodRender(
-    int angle)
+    int           angle,
+    MethodTiming *timing)
 {
+    long long mark = 0;
+
+    if (timing) {
+        glFinish();
+        mark = SYSTIME();
+    }
+
+    // Rendering in the main context needs no switch
+    #ifdef METHOD_MAINFRAMEBUFFER
+    if (method == Method_MainFramebuffer) {
+        gearsTargetsRender(angle, timing, &mark);
+        return GL_TRUE;
+    }
+    #endif // METHOD_MAINFRAMEBUFFER
+
     // Make context and appropriate surface current
     eglMakeCurrent(demoState.display,
                    gearsSurface, gearsSurface,
                    gearsContext);
+    if (timing) methodLap(&timing->switching, &mark);
 
     // Render a gears frame
     gearsRender(angle);
+    if (timing) methodLap(&timing->render, &mark);
 
     // For pbuffer copy, copy results to texture
     #ifdef METHOD_PBUFFER
@@ -550,6 +908,7 @@ gearsMethodRender(
         glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, texSize, texSize);
         glBindTexture(GL_TEXTURE_2D, 0);
     }
+    if (timing) methodLap(&timing->copy, &mark);
     #endif // METHOD_PBUFFER
 
     return GL_TRUE;
@@ -568,6 +927,11 @@ gearsMethodTerm(void)
     // Clean up the gears resources
     gearsTerm();
 
+    #ifdef METHOD_MAINFRAMEBUFFER
+    // Delete the main context framebuffers
+    gearsTargetsTerm();
+    #endif // METHOD_MAINFRAMEBUFFER
+
     #ifdef METHOD_FRAMEBUFFER
     // Delete the framebuffer and renderbuffer
     if (gearsFBO) {
@@ -612,6 +976,127 @@ gearsMethodTerm(void)
     #endif // METHOD_PIXMAP
 }
 
+// Select the gears texture update policy from the command line. The
+//   policies are alternatives, so only one may be given.
+static GLboolean
+gearsUpdatePolicySet(
+    UpdatePolicy policy)
+{
+    if (updatePolicy != Update_EveryFrame) {
+        NvGlDemoLog("Only one of -texrate, -texevery and -texdensity"
+                    " may be given\n");
+        return GL_FALSE;
+    }
+    updatePolicy = policy;
+    return GL_TRUE;
+}
+
+// Decide whether the gears texture should be rendered for this frame,
+//   given the time and number of frames since it last was
+static GLboolean
+gearsUpdateDue(
+    long long sinceTime,
+    int       sinceFrames)
+{
+    GLfloat density;
+    int     interval;
+
+    switch (updatePolicy) {
+
+        case Update_Rate:
+            return (sinceTime >= (long long)(1000000000.0 / updateRate))
+                 ? GL_TRUE : GL_FALSE;
+
+        case Update_Interval:
+            return (sinceFrames + 1 >= updateInterval) ? GL_TRUE : GL_FALSE;
+
+        case Update_Density:
+            density  = cubeTexelDensity();
+            interval = (density >= 1.0f) ? 1 : (int)(1.0f / density + 0.999f);
+            if (interval > MAX_DENSITY_INTERVAL)
+                interval = MAX_DENSITY_INTERVAL;
+            return (sinceFrames + 1 >= interval) ? GL_TRUE : GL_FALSE;
+
+        default:
+            return GL_TRUE;
+    }
+}
+
+// Time each available method over a number of frames, print a comparison,
+//   and return the fastest. The methods are left uninitialized.
+static Methods
+gearsMethodCalibrate(
+    int frames)
+{
+    MethodTiming timing[Method_Count];
+    long long    total, bestTotal = 0;
+    long long    mark;
+    Methods      best = Method_Count;
+    int          m, i;
+
+    MEMSET(timing, 0, sizeof(timing));
+
+    NvGlDemoLog("Calibrating render-to-texture methods,"
+                " %d frames of %dx%d each:\n", frames, texSize, texSize);
+    NvGlDemoLog("  %-12s %9s %9s %9s %9s %9s  (ms/frame)\n",
+                "method", "switch", "render", "copy", "draw", "total");
+
+    for (m=0; m<Method_Count; m++) {
+
+        // Set up the method, skipping it if the driver can't support it
+        method = (Methods)m;
+        if (!gearsMethodInit()) {
+            gearsMethodTerm();
+            NvGlDemoLog("  %-12s unavailable\n", methodNames[m]);
+            continue;
+        }
+
+        // Draw an untimed frame to get past any first use costs
+        gearsMethodRender(0, NULL);
+        cubeSceneRender();
+        glFinish();
+
+        // Time the frames. Switching back to the main context is timed
+        //   separately from the cube drawing, which would otherwise do it.
+        for (i=0; i<frames; i++) {
+            gearsMethodRender((6 * i) % 360, &timing[m]);
+            mark = SYSTIME();
+            if (gearsContext != EGL_NO_CONTEXT)
+                eglMakeCurrent(demoState.display,
+                               demoState.surface, demoState.surface,
+                               demoState.context);
+            methodLap(&timing[m].switching, &mark);
+            cubeSceneRender();
+            methodLap(&timing[m].draw, &mark);
+        }
+        gearsMethodTerm();
+
+        // Report and keep track of the fastest
+        total = timing[m].switching + timing[m].render
+              + timing[m].copy + timing[m].draw;
+        NvGlDemoLog("  %-12s %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+                    methodNames[m],
+                    timing[m].switching / (1000000.0 * frames),
+                    timing[m].render    / (1000000.0 * frames),
+                    timing[m].copy      / (1000000.0 * frames),
+                    timing[m].draw      / (1000000.0 * frames),
+                    total               / (1000000.0 * frames));
+        if ((best == Method_Count) || (total < bestTotal)) {
+            best      = (Methods)m;
+            bestTotal = total;
+        }
+    }
+
+    if (best != Method_Count) {
+        NvGlDemoLog(" fastest method is %s\n", methodNames[best]);
+    } else {
+        NvGlDemoLog(" no render-to-texture method is available\n");
+    }
+
+    method = best;
+    return best;
+}
+
 //===========================================================================
 
 // Callback to close window
@@ -648,6 +1133,12 @@ int main(int argc, char **argv)
     int         runforever = 0;
     int         frames     = 0;
     float       angle      = 0.0;
+    int         calibrate  = 0;
+    int         updates    = 0;
+    int         sinceFrames = 0;
+    long long   lastUpdate, mark;
+    long long   offscreenTime = 0;
+    long long   onscreenTime  = 0;
 
     // Initialize window system and EGL
     if (!NvGlDemoInitialize(&argc, argv, "gearscube", 2, 8, 0)) {
@@ -663,9 +1154,13 @@ int main(int argc, char **argv)
         // Method
         if (NvGlDemoArgMatchStr(&argc, argv, 1, "-method",
                                 "{"
+                                " auto "
                                 #ifdef METHOD_FRAMEBUFFER
                                 " fbo "
                                 #endif // METHOD_FRAMEBUFFER
+                                #ifdef METHOD_MAINFRAMEBUFFER
+                                " fbomain "
+                                #endif // METHOD_MAINFRAMEBUFFER
                                 #ifdef METHOD_PIXMAP
                                 " pixmap "
                                 #endif // METHOD_PIXMAP
@@ -676,11 +1171,19 @@ int main(int argc, char **argv)
                                 NVGLDEMO_MAX_NAME,
                                 methodName)) {
 
+            if (!STRCMP(methodName, "auto"))
+                method = Method_Count;
+            else
             #ifdef METHOD_FRAMEBUFFER
             if (!STRCMP(methodName, "fbo"))
                 method = Method_Framebuffer;
             else
             #endif // METHOD_FRAMEBUFFER
+            #ifdef METHOD_MAINFRAMEBUFFER
+            if (!STRCMP(methodName, "fbomain"))
+                method = Method_MainFramebuffer;
+            else
+            #endif // METHOD_MAINFRAMEBUFFER
             #ifdef METHOD_PIXMAP
             if (!STRCMP(methodName, "pixmap"))
                 method = Method_Pixmap;
@@ -705,6 +1208,47 @@ int main(int argc, char **argv)
             // No additional action needed
         }
 
+        #ifdef METHOD_MAINFRAMEBUFFER
+        // Number of textures rendered in the main context
+        else if (NvGlDemoArgMatchInt(&argc, argv, 1, "-targets",
+                                     "<count>", 1, MAX_TARGETS,
+                                     1, &targetCount)) {
+            // No additional action needed
+        }
+
+        // Multisampling of gears rendered in the main context
+        else if (NvGlDemoArgMatchInt(&argc, argv, 1, "-msaa",
+                                     "<samples>", 0, 16,
+                                     1, &msaaSamples)) {
+            // No additional action needed
+        }
+        #endif // METHOD_MAINFRAMEBUFFER
+
+        // Gears texture update policy (only one may be given)
+        else if (NvGlDemoArgMatchFlt(&argc, argv, 1, "-texrate",
+                                     "<updates/sec>", 0.1f, 1000.0f,
+                                     1, &updateRate)) {
+            if (!gearsUpdatePolicySet(Update_Rate))
+                goto done;
+        }
+        else if (NvGlDemoArgMatchInt(&argc, argv, 1, "-texevery",
+                                     "<frames>", 1, 1000,
+                                     1, &updateInterval)) {
+            if (!gearsUpdatePolicySet(Update_Interval))
+                goto done;
+        }
+        else if (NvGlDemoArgMatch(&argc, argv, 1, "-texdensity")) {
+            if (!gearsUpdatePolicySet(Update_Density))
+                goto done;
+        }
+
+        // Calibration only
+        else if (NvGlDemoArgMatchInt(&argc, argv, 1, "-calibrate",
+                                     "<frames>", 1, 100000,
+                                     1, &calibrate)) {
+            // No additional action needed
+        }
+
         // Unknown or failure
         else {
             if (!NvGlDemoArgFailed())
@@ -717,6 +1261,18 @@ int main(int argc, char **argv)
     if (!cubeSceneInit(demoState.width, demoState.height))
         goto done;
 
+    // If asked to, just compare the methods
+    if (calibrate) {
+        if (gearsMethodCalibrate(calibrate) != Method_Count)
+            failure = 0;
+        goto done;
+    }
+
+    // Pick the fastest method unless one was given
+    if ((method == Method_Count)
+        && (gearsMethodCalibrate(CALIBRATE_FRAMES) == Method_Count))
+        goto done;
+
     // Intialize the gears rendering
     if (!gearsMethodInit())
         goto done;
@@ -727,7 +1283,7 @@ int main(int argc, char **argv)
     NvGlDemoSetKeyCB(keyCB);
 
     // Draw a frame. It will cause libraries to load before counting for fps
-    gearsMethodRender(angle);
+    gearsMethodRender(angle, NULL);
     cubeSceneRender();
     glFinish();
 
@@ -742,15 +1298,31 @@ int main(int argc, char **argv)
     // Get start time and compute end time
     startTime = endTime = currTime = SYSTIME();
     endTime += (long long)(1000000000.0 * demoOptions.duration);
+    lastUpdate = startTime;
 
     // Main loop.
     do {
         // Execute PreSwap functions
         NvGlDemoPreSwapExec();
 
+        // Render the gears if the update policy says they're due, keeping
+        //   track of the offscreen and onscreen submission time
+        mark = SYSTIME();
+        if (gearsUpdateDue(mark - lastUpdate, sinceFrames)) {
+            gearsMethodRender(angle, NULL);
+            lastUpdate  = mark;
+            sinceFrames = 0;
+            updates++;
+            currTime = SYSTIME();
+            offscreenTime += currTime - mark;
+            mark = currTime;
+        } else {
+            sinceFrames++;
+        }
+
         // Draw and swap a frame
-        gearsMethodRender(angle);
         cubeSceneRender();
+        onscreenTime += SYSTIME() - mark;
         if (eglSwapBuffers(demoState.display, demoState.surface) != EGL_TRUE) {
             if (demoState.stream) {
                 NvGlDemoLog("Consumer has disconnected, exiting.");
@@ -775,22 +1347,38 @@ int main(int argc, char **argv)
 
     done:
 
-    // If any frames were generated, print the framerate
+    // If any frames were generated, print the framerate, and how the
+    //   submission time was split between the gears and the cube
     if (frames) {
         NvGlDemoLog("Total FPS: %f\n",
                     (float)frames /(((currTime - startTime) / 1000000ull) / 1000.0));
+        NvGlDemoLog("Gears texture updates: %d (%.1f%% of frames)\n",
+                    updates, 100.0 * updates / frames);
+        if (updates) {
+            NvGlDemoLog("Submission time: offscreen %.3f ms/update, "
+                        "onscreen %.3f ms/frame, %.1f%% offscreen\n",
+                        offscreenTime / (1000000.0 * updates),
+                        onscreenTime  / (1000000.0 * frames),
+                        100.0 * offscreenTime
+                            / (double)(offscreenTime + onscreenTime));
+        }
     }
 
-    // Otherwise something went wrong. Print usage message in case it
-    //   was due to bad command line arguments.
-    else {
+    // Otherwise, unless only calibrating, something went wrong. Print usage
+    //   message in case it was due to bad command line arguments.
+    else if (failure) {
         NvGlDemoLog("Usage: gearscube [options]\n"
                     "    (negative runTime means \"forever\")\n"
-                    "  Method to use for render-to-texture:\n"
+                    "  Method to use for render-to-texture (default auto,\n"
+                    "  which times them all and uses the fastest):\n"
                     "    [-method {"
+                            " auto "
                             #ifdef METHOD_FRAMEBUFFER
                             " fbo "
                             #endif // METHOD_FRAMEBUFFER
+                            #ifdef METHOD_MAINFRAMEBUFFER
+                            " fbomain "
+                            #endif // METHOD_MAINFRAMEBUFFER
                             #ifdef METHOD_PIXMAP
                             " pixmap "
                             #endif // METHOD_PIXMAP
@@ -799,7 +1387,17 @@ int main(int argc, char **argv)
                             #endif // METHOD_PBUFFER
                             "}\n"
                     "  Texture size:\n"
-                    "    [-texsize <size>]\n");
+                    "    [-texsize <size>]\n"
+                    #ifdef METHOD_MAINFRAMEBUFFER
+                    "  Textures and multisampling for fbomain:\n"
+                    "    [-targets <1-6>] [-msaa <samples>]\n"
+                    #endif // METHOD_MAINFRAMEBUFFER
+                    "  Gears texture update policy (default every frame,"
+                    " at most one):\n"
+                    "    [-texrate <updates/sec>] | [-texevery <frames>] |"
+                    " [-texdensity]\n"
+                    "  Time each method and exit:\n"
+                    "    [-calibrate <frames>]\n");
         NvGlDemoLog(NvGlDemoArgUsageString());
     }
 
@@ -32,6 +32,7 @@
 
 #include "nvgldemo.h"
 #include "gearslib.h"
+#include <GLES2/gl2ext.h>
 
 // Camera orientation
 #define VIEW_ROTX 20.0f
@@ -49,6 +50,7 @@
 #ifdef USE_EXTERN_SHADERS
 static const char gearVertShader[] = { VERTFILE(gears_vert) };
 static const char gearFragShader[] = { FRAGFILE(gears_frag) };
+static const char fieldVertShader[] = { VERTFILE(gearfield_vert) };
 #else
 static const char gearVertShader[] = {
 #   include VERTFILE(gears_vert)
@@ -56,23 +58,31 @@ static const char gearVertShader[] = {
 static const char gearFragShader[] = {
 #   include FRAGFILE(gears_frag)
 };
+static const char fieldVertShader[] = {
+#   include VERTFILE(gearfield_vert)
+};
 #endif
 
 static const char gearPrgBin[] = { PROGFILE(gears_prog) };
+static const char fieldPrgBin[] = { PROGFILE(gearfield_prog) };
 
-// Vertex data describing the gears
+// GL objects describing the gears
+//   Each gear is baked at creation into a static buffer of interleaved
+//   positions and normals and a single triangle list, so it can be drawn
+//   with one call. Where vertex array objects are supported, the attribute
+//   setup is captured as well.
 typedef struct {
     int      teeth;
-    GLfloat  *vertices;
-    GLfloat  *normals;
-    GLushort *frontbody;
-    GLushort *frontteeth;
-    GLushort *backbody;
-    GLushort *backteeth;
-    GLushort *outer;
-    GLushort *inner;
+    GLuint   vbo;
+    GLuint   ibo;
+    GLuint   vao;
+    GLsizei  numIndices;
 } Gear;
 
+// Each vertex holds a position and a normal
+#define GEAR_VERTEX_FLOATS 6
+#define GEAR_VERTEX_STRIDE (GEAR_VERTEX_FLOATS * sizeof(GLfloat))
+
 // Gear structures and matrices
 static Gear* gear1 = NULL;
 static Gear* gear2 = NULL;
@@ -89,6 +99,178 @@ static GLuint material_index;
 static GLuint pos_index;
 static GLuint nrm_index;
 
+// Current projection, shared by both programs
+static GLfloat proj_mat[16];
+
+// Shapes of the gears in the stress field. Speeds relative to the base
+//   angle are whole numbers, so the rotation stays continuous when the
+//   base angle wraps around.
+typedef struct {
+    GLfloat inner;
+    GLfloat outer;
+    GLfloat width;
+    int     teeth;
+    GLfloat speed;
+} GearShape;
+
+static const GearShape fieldShapes[] = {
+    { 1.0f, 4.0f, 1.0f, 20, 1.0f },
+    { 0.5f, 2.0f, 2.0f, 10, 2.0f },
+    { 1.3f, 2.0f, 0.5f, 10, 2.0f },
+    { 1.5f, 6.0f, 0.8f, 30, 1.0f },
+};
+#define FIELD_SHAPES ((int)(sizeof(fieldShapes) / sizeof(fieldShapes[0])))
+
+static const GLfloat fieldColors[][3] = {
+    { 0.8f, 0.1f, 0.0f },
+    { 0.0f, 0.8f, 0.2f },
+    { 0.2f, 0.2f, 1.0f },
+    { 0.9f, 0.7f, 0.1f },
+    { 0.1f, 0.7f, 0.8f },
+    { 0.7f, 0.2f, 0.8f },
+};
+#define FIELD_COLORS ((int)(sizeof(fieldColors) / sizeof(fieldColors[0])))
+
+// Grid spacing of the field, which clears the largest gear, and the
+//   half size of the view area the field is scaled to fill
+#define FIELD_CELL   13.0f
+#define FIELD_EXTENT  8.0f
+
+// Placement and material of one gear in the field
+typedef struct {
+    GLfloat place[4];       // Position (xy), phase and speed (zw)
+    GLfloat material[4];    // Ambient and diffuse material (xyz)
+} FieldGear;
+
+// Stress field state. The gears are sorted by shape, so each shape is a
+//   contiguous run of the instance buffer.
+static GLuint     fieldProgram = 0;
+static GLuint     field_mview_index;
+static GLuint     field_angle_index;
+static GLuint     field_pos_index;
+static GLuint     field_nrm_index;
+static GLuint     field_place_index;
+static GLuint     field_mat_index;
+static Gear*      fieldGears[FIELD_SHAPES];
+static GLuint     fieldVaos[FIELD_SHAPES];
+static int        fieldFirst[FIELD_SHAPES];
+static int        fieldCount[FIELD_SHAPES];
+static FieldGear* fieldData = NULL;
+static GLuint     fieldBuffer = 0;
+static int        fieldTotal = 0;
+static int        fieldTris = 0;
+static GLboolean  fieldInstanced = GL_FALSE;
+static GLfloat    field_mat[16];
+
+// Whether the context is OpenGL ES 3, which instancing needs
+static GLboolean gles3 = GL_FALSE;
+
+// Vertex array object entry points, from OES_vertex_array_object or
+//   OpenGL ES 3. They are left NULL if the context supports neither.
+static PFNGLGENVERTEXARRAYSOESPROC    pGenVertexArrays    = NULL;
+static PFNGLBINDVERTEXARRAYOESPROC    pBindVertexArray    = NULL;
+static PFNGLDELETEVERTEXARRAYSOESPROC pDeleteVertexArrays = NULL;
+
+// Look up vertex array object support in the current context
+static void
+initvertexarrays(void)
+{
+    const char *extensions = (const char*)glGetString(GL_EXTENSIONS);
+
+    gles3 = NvGlDemoHasGlesVersion(3, 0);
+
+    if (extensions && STRSTR(extensions, "GL_OES_vertex_array_object")) {
+        pGenVertexArrays = (PFNGLGENVERTEXARRAYSOESPROC)
+            eglGetProcAddress("glGenVertexArraysOES");
+        pBindVertexArray = (PFNGLBINDVERTEXARRAYOESPROC)
+            eglGetProcAddress("glBindVertexArrayOES");
+        pDeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSOESPROC)
+            eglGetProcAddress("glDeleteVertexArraysOES");
+    } else if (gles3) {
+        pGenVertexArrays = (PFNGLGENVERTEXARRAYSOESPROC)
+            eglGetProcAddress("glGenVertexArrays");
+        pBindVertexArray = (PFNGLBINDVERTEXARRAYOESPROC)
+            eglGetProcAddress("glBindVertexArray");
+        pDeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSOESPROC)
+            eglGetProcAddress("glDeleteVertexArrays");
+    }
+
+    if (!pGenVertexArrays || !pBindVertexArray || !pDeleteVertexArrays) {
+        pGenVertexArrays    = NULL;
+        pBindVertexArray    = NULL;
+        pDeleteVertexArrays = NULL;
+    }
+}
+
+// Point the gear attributes at the currently bound vertex buffer
+static void
+setgearattribs(
+    GLuint pos,
+    GLuint nrm)
+{
+    glVertexAttribPointer(pos, 3, GL_FLOAT, GL_FALSE,
+                          GEAR_VERTEX_STRIDE, (const void*)0);
+    glVertexAttribPointer(nrm, 3, GL_FLOAT, GL_FALSE,
+                          GEAR_VERTEX_STRIDE,
+                          (const void*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(pos);
+    glEnableVertexAttribArray(nrm);
+}
+
+// Returns whether two of the gear's vertices are at the same position
+static int
+samepos(
+    const GLfloat *vertices,
+    GLushort      a,
+    GLushort      b)
+{
+    return (vertices[3*a+0] == vertices[3*b+0])
+        && (vertices[3*a+1] == vertices[3*b+1])
+        && (vertices[3*a+2] == vertices[3*b+2]);
+}
+
+// Append the triangles of a strip to a triangle list, preserving winding
+//   The strips repeat vertices to change normals, and the resulting
+//   zero area triangles are dropped.
+static GLushort*
+addstrip(
+    GLushort       *tri,
+    const GLfloat  *vertices,
+    const GLushort *strip,
+    int            count,
+    GLushort       base)
+{
+    int k;
+    for (k=0; k<count-2; k++) {
+        if (samepos(vertices, strip[k], strip[k+1])
+            || samepos(vertices, strip[k+1], strip[k+2])
+            || samepos(vertices, strip[k], strip[k+2])) {
+            continue;
+        }
+        tri[0] = base + strip[k + (k & 1)];
+        tri[1] = base + strip[k + 1 - (k & 1)];
+        tri[2] = base + strip[k + 2];
+        tri += 3;
+    }
+    return tri;
+}
+
+// Append the two triangles of a four vertex fan to a triangle list
+static GLushort*
+addquad(
+    GLushort       *tri,
+    const GLushort *fan,
+    GLushort       base)
+{
+    tri[0] = base + fan[0];
+    tri[1] = base + fan[1];
+    tri[2] = base + fan[2];
+    tri[3] = base + fan[0];
+    tri[4] = base + fan[2];
+    tri[5] = base + fan[3];
+    return tri + 6;
+}
+
 //  Make a gear wheel.
 //
 //  Input:  inner_radius - radius of hole at center
@@ -106,21 +288,44 @@ makegear(
 {
     Gear     *gear;
     GLfloat  r0, r1, r2, da, hw;
+    GLfloat  *vertices, *normals, *baked;
     GLfloat  *vert, *norm;
+    GLushort *frontbody, *frontteeth, *backbody, *backteeth, *outer, *inner;
+    GLushort *triangles, *tri;
     GLushort *index, *indexF, *indexB;
-    int      i;
+    GLushort sideVerts, frontBase, backBase;
+    int      numVerts;
+    int      i, k;
 
-    // Create gear structure and arrays of vertex/index data
+    // Create gear structure and temporary arrays of vertex/index data
     gear = (Gear*)MALLOC(sizeof(Gear));
+    if (!gear) return NULL;
+    MEMSET(gear, 0, sizeof(Gear));
     gear->teeth = teeth;
-    gear->vertices   = (GLfloat*) MALLOC(20*teeth*3*sizeof(GLfloat));
-    gear->normals    = (GLfloat*) MALLOC(20*teeth*3*sizeof(GLfloat));
-    gear->frontbody  = (GLushort*)MALLOC((4*teeth+2)*sizeof(GLushort));
-    gear->frontteeth = (GLushort*)MALLOC(4*teeth*sizeof(GLushort));
-    gear->backbody   = (GLushort*)MALLOC((4*teeth+2)*sizeof(GLushort));
-    gear->backteeth  = (GLushort*)MALLOC(4*teeth*sizeof(GLushort));
-    gear->outer      = (GLushort*)MALLOC((16*teeth+2)*sizeof(GLushort));
-    gear->inner      = (GLushort*)MALLOC((4*teeth+2)*sizeof(GLushort));
+    vertices   = (GLfloat*) MALLOC(20*teeth*3*sizeof(GLfloat));
+    normals    = (GLfloat*) MALLOC(20*teeth*3*sizeof(GLfloat));
+    frontbody  = (GLushort*)MALLOC((4*teeth+2)*sizeof(GLushort));
+    frontteeth = (GLushort*)MALLOC(4*teeth*sizeof(GLushort));
+    backbody   = (GLushort*)MALLOC((4*teeth+2)*sizeof(GLushort));
+    backteeth  = (GLushort*)MALLOC(4*teeth*sizeof(GLushort));
+    outer      = (GLushort*)MALLOC((16*teeth+2)*sizeof(GLushort));
+    inner      = (GLushort*)MALLOC((4*teeth+2)*sizeof(GLushort));
+
+    // The side vertices are followed by copies for the front and back
+    //   faces, which carry the constant face normals
+    sideVerts = (GLushort)(20 * teeth);
+    frontBase = sideVerts;
+    backBase  = (GLushort)(2 * sideVerts);
+    numVerts  = 3 * sideVerts;
+    baked     = (GLfloat*) MALLOC(numVerts*GEAR_VERTEX_STRIDE);
+    triangles = (GLushort*)MALLOC(96*teeth*sizeof(GLushort));
+
+    if (!vertices || !normals || !frontbody || !frontteeth || !backbody
+        || !backteeth || !outer || !inner || !baked || !triangles) {
+        FREE(gear);
+        gear = NULL;
+        goto done;
+    }
 
     // Set up vertices
     r0 = inner_radius;
@@ -128,8 +333,8 @@ makegear(
     r2 = outer_radius + 0.5f * tooth_depth;
     hw = 0.5f * width;
     da = (GLfloat)(0.5f * PI / teeth);
-    vert = gear->vertices;
-    norm = gear->normals;
+    vert = vertices;
+    norm = normals;
     for (i=0; i<teeth; ++i) {
         GLfloat angA, angB, angC, angD;
         GLfloat cosA, cosB, cosC, cosD;
@@ -249,8 +454,8 @@ makegear(
     }
 
     // Build index lists for circular parts of front and back faces
-    indexF = gear->frontbody;
-    indexB = gear->backbody;
+    indexF = frontbody;
+    indexB = backbody;
     for (i=0; i<teeth; i++) {
         indexF[0] = 20 * i;
         indexF[1] = 20 * i + 2;
@@ -269,8 +474,8 @@ makegear(
     indexB[1] = 3;
 
     // Build index lists for front and back sides of teeth
-    indexF = gear->frontteeth;
-    indexB = gear->backteeth;
+    indexF = frontteeth;
+    indexB = backteeth;
     for (i=0; i<teeth; ++i) {
         indexF[0] = 20 * i + 2;
         indexF[1] = 20 * i + 6;
@@ -285,7 +490,7 @@ makegear(
     }
 
     // Build index list for inner core
-    index = gear->inner;
+    index = inner;
     for (i=0; i<teeth; i++) {
         index[0] = 20 * i;
         index[1] = 20 * i + 1;
@@ -297,7 +502,7 @@ makegear(
     index[1] = 1;
 
     // Build index list for outsides of teeth
-    index = gear->outer;
+    index = outer;
     for (i=0; i<teeth; i++) {
         index[0]  = 20 * i + 2;
         index[1]  = 20 * i + 3;
@@ -320,6 +525,76 @@ makegear(
     index[0] = 2;
     index[1] = 3;
 
+    // Interleave the positions and normals of all three vertex copies
+    vert = baked;
+    for (k=0; k<3; k++) {
+        for (i=0; i<sideVerts; i++) {
+            vert[0] = vertices[3*i+0];
+            vert[1] = vertices[3*i+1];
+            vert[2] = vertices[3*i+2];
+            if (k == 0) {
+                vert[3] = normals[3*i+0];
+                vert[4] = normals[3*i+1];
+                vert[5] = normals[3*i+2];
+            } else {
+                vert[3] = 0.0f;
+                vert[4] = 0.0f;
+                vert[5] = (k == 1) ? 1.0f : -1.0f;
+            }
+            vert += GEAR_VERTEX_FLOATS;
+        }
+    }
+
+    // Flatten the strips and fans into a single triangle list
+    tri = triangles;
+    tri = addstrip(tri, vertices, frontbody, 4*teeth+2, frontBase);
+    for (i=0; i<teeth; i++) {
+        tri = addquad(tri, &frontteeth[4*i], frontBase);
+    }
+    tri = addstrip(tri, vertices, backbody, 4*teeth+2, backBase);
+    for (i=0; i<teeth; i++) {
+        tri = addquad(tri, &backteeth[4*i], backBase);
+    }
+    tri = addstrip(tri, vertices, outer, 16*teeth+2, 0);
+    tri = addstrip(tri, vertices, inner, 4*teeth+2, 0);
+    gear->numIndices = (GLsizei)(tri - triangles);
+
+    // Upload the static buffers
+    glGenBuffers(1, &gear->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, gear->vbo);
+    glBufferData(GL_ARRAY_BUFFER, numVerts*GEAR_VERTEX_STRIDE,
+                 baked, GL_STATIC_DRAW);
+    glGenBuffers(1, &gear->ibo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gear->ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 gear->numIndices*sizeof(GLushort),
+                 triangles, GL_STATIC_DRAW);
+
+    // Capture the buffer bindings and attribute setup if possible
+    if (pGenVertexArrays) {
+        pGenVertexArrays(1, &gear->vao);
+        pBindVertexArray(gear->vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gear->ibo);
+        setgearattribs(pos_index, nrm_index);
+        pBindVertexArray(0);
+    }
+
+    // Leave the default bindings for any client array rendering
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+done:
+    FREE(triangles);
+    FREE(baked);
+    FREE(inner);
+    FREE(outer);
+    FREE(backteeth);
+    FREE(backbody);
+    FREE(frontteeth);
+    FREE(frontbody);
+    FREE(normals);
+    FREE(vertices);
+
     return gear;
 }
 
@@ -328,54 +603,20 @@ static void
 drawgear(
     Gear *gear)
 {
-    int i;
-
-    // Set up constant normals for the front and back of the gear
-    static float norm_front[3] = {0.0f, 0.0f, 1.0f};
-    static float norm_back[3]  = {0.0f, 0.0f, -1.0f};
-
-    // Enable vertex pointers, and initially disable normal pointers
-    glVertexAttribPointer(pos_index, 3, GL_FLOAT, 0, 0, gear->vertices);
-    glVertexAttribPointer(nrm_index, 3, GL_FLOAT, 0, 0, gear->normals);
-    glEnableVertexAttribArray(pos_index);
-    glDisableVertexAttribArray(nrm_index);
-
-    // Set the constant normal for front side
-    glVertexAttrib3fv(nrm_index, norm_front);
-
-    // Draw circular part of front side
-    glDrawElements(GL_TRIANGLE_STRIP, 4*gear->teeth + 2,
-                   GL_UNSIGNED_SHORT, gear->frontbody);
-
-    // Draw front side teeth
-    for (i=0; i<gear->teeth; i++) {
-        glDrawElements(GL_TRIANGLE_FAN, 4,
-                       GL_UNSIGNED_SHORT, &gear->frontteeth[4*i]);
-    }
-
-    // Set the constant normal for back side
-    glVertexAttrib3fv(nrm_index, norm_back);
-
-    // Draw circular part of front side
-    glDrawElements(GL_TRIANGLE_STRIP, 4*gear->teeth + 2,
-                   GL_UNSIGNED_SHORT, gear->backbody);
-
-    // Draw back side teeth
-    for (i = 0; i < gear->teeth; i++) {
-        glDrawElements(GL_TRIANGLE_FAN, 4,
-                       GL_UNSIGNED_SHORT, &gear->backteeth[4*i]);
+    if (gear->vao) {
+        pBindVertexArray(gear->vao);
+        glDrawElements(GL_TRIANGLES, gear->numIndices,
+                       GL_UNSIGNED_SHORT, (const void*)0);
+        pBindVertexArray(0);
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, gear->vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gear->ibo);
+        setgearattribs(pos_index, nrm_index);
+        glDrawElements(GL_TRIANGLES, gear->numIndices,
+                       GL_UNSIGNED_SHORT, (const void*)0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
-
-    // Enable normal pointers for the inner and outer faces
-    glEnableVertexAttribArray(nrm_index);
-
-    // Draw outer faces of teeth
-    glDrawElements(GL_TRIANGLE_STRIP, 16*gear->teeth + 2,
-                   GL_UNSIGNED_SHORT, gear->outer);
-
-    // Draw inside radius cylinder
-    glDrawElements(GL_TRIANGLE_STRIP, 4*gear->teeth + 2,
-                   GL_UNSIGNED_SHORT, gear->inner);
 }
 
 // Free a gear structure
@@ -383,29 +624,63 @@ static void
 freegear(
     Gear *gear)
 {
-    FREE(gear->inner);
-    FREE(gear->outer);
-    FREE(gear->backteeth);
-    FREE(gear->backbody);
-    FREE(gear->frontteeth);
-    FREE(gear->frontbody);
-    FREE(gear->normals);
-    FREE(gear->vertices);
+    if (gear->vao) pDeleteVertexArrays(1, &gear->vao);
+    if (gear->ibo) glDeleteBuffers(1, &gear->ibo);
+    if (gear->vbo) glDeleteBuffers(1, &gear->vbo);
     FREE(gear);
 }
 
-// Top level initialization of gears library
-int
-gearsInit(int width, int height)
+// Load the light direction into the current program
+static void
+setlight(
+    GLuint program)
 {
     // Scene constants
     const GLfloat light_pos[4] = {1.0f, 3.0f, 5.0f, 0.0f};
 
     GLuint  index;
-    GLfloat scene_mat[16];
     GLfloat light_norm, light_dir[4];
 
+    // Using a directional light, so find the normalized vector and load
+    light_norm = (GLfloat)(ISQRT(light_pos[0]*light_pos[0]
+                                +light_pos[1]*light_pos[1]
+                                +light_pos[2]*light_pos[2]
+                                +light_pos[3]*light_pos[3]));
+    light_dir[0] = light_pos[0] * light_norm;
+    light_dir[1] = light_pos[1] * light_norm;
+    light_dir[2] = light_pos[2] * light_norm;
+    light_dir[3] = light_pos[3] * light_norm;
+    index = glGetUniformLocation(program, "light_dir");
+    glUniform3fv(index, 1, light_dir);
+}
+
+// Set up the global scene matrix
+static void
+setscene(
+    GLfloat *scene_mat)
+{
+    NvGlDemoMatrixIdentity(scene_mat);
+    NvGlDemoMatrixTranslate(scene_mat, 0.0f, 0.0f, -VIEW_ZGEAR);
+    NvGlDemoMatrixRotate(scene_mat, VIEW_ROTX, 1.0f, 0.0f, 0.0f);
+    NvGlDemoMatrixRotate(scene_mat, VIEW_ROTY, 0.0f, 1.0f, 0.0f);
+    NvGlDemoMatrixRotate(scene_mat, VIEW_ROTZ, 0.0f, 0.0f, 1.0f);
+}
+
+// Set the global GL state the gears are drawn with. Callers which share
+//   the context with other rendering call this before gearsRender.
+void
+gearsSetState(void)
+{
     glClearColor(0.10f, 0.20f, 0.15f, 1.0f);
+    glEnable(GL_DEPTH_TEST);
+    glUseProgram(gearShaderProgram);
+}
+
+// Top level initialization of gears library
+int
+gearsInit(int width, int height)
+{
+    GLfloat scene_mat[16];
 
     // Load the shaders (The macro handles the details of binary vs.
     //   source and external vs. internal)
@@ -420,17 +695,8 @@ gearsInit(int width, int height)
     // Initialize projection matrix
     gearsResize(width, height);
 
-    // Using a directional light, so find the normalized vector and load
-    light_norm = (GLfloat)(ISQRT(light_pos[0]*light_pos[0]
-                                +light_pos[1]*light_pos[1]
-                                +light_pos[2]*light_pos[2]
-                                +light_pos[3]*light_pos[3]));
-    light_dir[0] = light_pos[0] * light_norm;
-    light_dir[1] = light_pos[1] * light_norm;
-    light_dir[2] = light_pos[2] * light_norm;
-    light_dir[3] = light_pos[3] * light_norm;
-    index = glGetUniformLocation(gearShaderProgram, "light_dir");
-    glUniform3fv(index, 1, light_dir);
+    // Load the light direction
+    setlight(gearShaderProgram);
 
     // Get indices for uniforms and attributes updated each frame
     mview_mat_index = glGetUniformLocation(gearShaderProgram, "mview_mat");
@@ -439,16 +705,14 @@ gearsInit(int width, int height)
     nrm_index       = glGetAttribLocation(gearShaderProgram, "nrm_attr");
 
     // Create gear data
+    initvertexarrays();
     gear1 = makegear(1.0f, 4.0f, 1.0f, 20, 0.7f);
     gear2 = makegear(0.5f, 2.0f, 2.0f, 10, 0.7f);
     gear3 = makegear(1.3f, 2.0f, 0.5f, 10, 0.7f);
+    if (!gear1 || !gear2 || !gear3) return 0;
 
     // Set up the global scene matrix
-    NvGlDemoMatrixIdentity(scene_mat);
-    NvGlDemoMatrixTranslate(scene_mat, 0.0f, 0.0f, -VIEW_ZGEAR);
-    NvGlDemoMatrixRotate(scene_mat, VIEW_ROTX, 1.0f, 0.0f, 0.0f);
-    NvGlDemoMatrixRotate(scene_mat, VIEW_ROTY, 0.0f, 1.0f, 0.0f);
-    NvGlDemoMatrixRotate(scene_mat, VIEW_ROTZ, 0.0f, 0.0f, 1.0f);
+    setscene(scene_mat);
 
     // Set up the individual gear matrices
     MEMCPY(gear1_mat, scene_mat, 16*sizeof(GLfloat));
@@ -458,8 +722,8 @@ gearsInit(int width, int height)
     MEMCPY(gear3_mat, scene_mat, 16*sizeof(GLfloat));
     NvGlDemoMatrixTranslate(gear3_mat, -3.1f,  4.2f, 0.0f);
 
-    // Enable depth testing
-    glEnable(GL_DEPTH_TEST);
+    // Clear color and depth testing
+    gearsSetState();
 
     return 1;
 }
@@ -470,7 +734,6 @@ gearsResize(
     int width,
     int height)
 {
-    GLfloat proj_mat[16];
     GLfloat aspect;
     GLuint  index;
 
@@ -490,6 +753,14 @@ gearsResize(
     }
     index = glGetUniformLocation(gearShaderProgram, "proj_mat");
     glUniformMatrix4fv(index, 1, 0, proj_mat);
+
+    // The field program, if any, needs the same projection
+    if (fieldProgram) {
+        glUseProgram(fieldProgram);
+        index = glGetUniformLocation(fieldProgram, "proj_mat");
+        glUniformMatrix4fv(index, 1, 0, proj_mat);
+        glUseProgram(gearShaderProgram);
+    }
 }
 
 // Draw a frame
@@ -530,12 +801,232 @@ gearsRender(
     drawgear(gear3);
 }
 
+// Point the field attributes at the buffers for one shape. The per-gear
+//   attributes either step through the shape's run of the instance buffer
+//   or are left as constant values to be set for each draw.
+static void
+setfieldattribs(
+    int       shape,
+    GLboolean instanced)
+{
+    const GLubyte *first = (const GLubyte*)0
+                         + fieldFirst[shape] * sizeof(FieldGear);
+
+    glBindBuffer(GL_ARRAY_BUFFER, fieldGears[shape]->vbo);
+    setgearattribs(field_pos_index, field_nrm_index);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, fieldGears[shape]->ibo);
+
+    if (instanced) {
+        glBindBuffer(GL_ARRAY_BUFFER, fieldBuffer);
+        glVertexAttribPointer(field_place_index, 4, GL_FLOAT, GL_FALSE,
+                              sizeof(FieldGear), first);
+        glVertexAttribPointer(field_mat_index, 3, GL_FLOAT, GL_FALSE,
+                              sizeof(FieldGear),
+                              first + 4 * sizeof(GLfloat));
+        glEnableVertexAttribArray(field_place_index);
+        glEnableVertexAttribArray(field_mat_index);
+        glVertexAttribDivisor(field_place_index, 1);
+        glVertexAttribDivisor(field_mat_index, 1);
+    } else {
+        glDisableVertexAttribArray(field_place_index);
+        glDisableVertexAttribArray(field_mat_index);
+    }
+}
+
+// Set up a field of gears to stress the GPU and driver. Must be called
+//   after gearsInit. The gears are drawn with one instanced draw per shape
+//   if requested and the context is OpenGL ES 3, and one draw per gear
+//   otherwise.
+int
+gearsFieldInit(
+    int count,
+    int instanced)
+{
+    int     filled[FIELD_SHAPES];
+    int     side, i, s;
+    GLfloat scale;
+
+    // Load the field program and look up its inputs
+    fieldProgram = LOADPROGSHADER(fieldVertShader, gearFragShader,
+                                  GL_TRUE, GL_FALSE,
+                                  fieldPrgBin);
+    if (!fieldProgram) return 0;
+    glUseProgram(fieldProgram);
+    setlight(fieldProgram);
+    glUniformMatrix4fv(glGetUniformLocation(fieldProgram, "proj_mat"),
+                       1, 0, proj_mat);
+    field_mview_index = glGetUniformLocation(fieldProgram, "mview_mat");
+    field_angle_index = glGetUniformLocation(fieldProgram, "angle");
+    field_pos_index   = glGetAttribLocation(fieldProgram, "pos_attr");
+    field_nrm_index   = glGetAttribLocation(fieldProgram, "nrm_attr");
+    field_place_index = glGetAttribLocation(fieldProgram, "place_attr");
+    field_mat_index   = glGetAttribLocation(fieldProgram, "mat_attr");
+
+    // Instancing needs OpenGL ES 3, and its vertex array objects
+    fieldInstanced = (instanced && gles3 && pGenVertexArrays)
+                   ? GL_TRUE : GL_FALSE;
+    if (instanced && !fieldInstanced) {
+        NvGlDemoLog("Instancing not supported, drawing each gear.\n");
+    }
+
+    // Create one mesh per shape
+    for (s=0; s<FIELD_SHAPES; s++) {
+        fieldGears[s] = makegear(fieldShapes[s].inner, fieldShapes[s].outer,
+                                 fieldShapes[s].width, fieldShapes[s].teeth,
+                                 0.7f);
+        if (!fieldGears[s]) return 0;
+        fieldCount[s] = 0;
+    }
+
+    // Lay the gears out on a square grid, varying the shape, direction,
+    //   phase and color from cell to cell
+    fieldData = (FieldGear*)MALLOC(count * sizeof(FieldGear));
+    if (!fieldData) return 0;
+    side = 1;
+    while (side * side < count) side++;
+    for (i=0; i<count; i++) {
+        fieldCount[(i / side + 3 * (i % side)) % FIELD_SHAPES]++;
+    }
+    for (s=0, fieldTris=0; s<FIELD_SHAPES; s++) {
+        fieldFirst[s] = s ? (fieldFirst[s-1] + fieldCount[s-1]) : 0;
+        filled[s] = 0;
+        fieldTris += fieldCount[s] * (fieldGears[s]->numIndices / 3);
+    }
+    for (i=0; i<count; i++) {
+        int row = i / side;
+        int col = i % side;
+        FieldGear *g;
+
+        s = (row + 3 * col) % FIELD_SHAPES;
+        g = &fieldData[fieldFirst[s] + filled[s]++];
+        g->place[0] = (col - 0.5f * (side - 1)) * FIELD_CELL;
+        g->place[1] = (row - 0.5f * (side - 1)) * FIELD_CELL;
+        g->place[2] = (GLfloat)((i * 137) % 360);
+        g->place[3] = ((row + col) & 1) ? -fieldShapes[s].speed
+                                        :  fieldShapes[s].speed;
+        MEMCPY(g->material, fieldColors[(row + col + s) % FIELD_COLORS],
+               3 * sizeof(GLfloat));
+        g->material[3] = 1.0f;
+    }
+    fieldTotal = count;
+
+    // Scale the field to fill the view of the classic gears
+    scale = FIELD_EXTENT / (0.5f * side * FIELD_CELL);
+    setscene(field_mat);
+    NvGlDemoMatrixScale(field_mat, scale, scale, scale);
+
+    // Upload the instances and capture the setup of each shape
+    if (fieldInstanced) {
+        glGenBuffers(1, &fieldBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, fieldBuffer);
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(FieldGear),
+                     fieldData, GL_STATIC_DRAW);
+        pGenVertexArrays(FIELD_SHAPES, fieldVaos);
+        for (s=0; s<FIELD_SHAPES; s++) {
+            pBindVertexArray(fieldVaos[s]);
+            setfieldattribs(s, GL_TRUE);
+        }
+        pBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    return 1;
+}
+
+// Number of gears and triangles drawn per field frame
+int
+gearsFieldCount(void)
+{
+    return fieldTotal;
+}
+
+int
+gearsFieldTriangles(void)
+{
+    return fieldTris;
+}
+
+// Number of draw calls issued per field frame
+int
+gearsFieldDraws(void)
+{
+    int s, draws = 0;
+
+    if (!fieldInstanced) return fieldTotal;
+    for (s=0; s<FIELD_SHAPES; s++) {
+        if (fieldCount[s]) draws++;
+    }
+    return draws;
+}
+
+// Draw a frame of the gear field
+void
+gearsFieldRender(
+    GLfloat angle)
+{
+    int s, i;
+
+    // Clear the buffers
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Make sure the field program is current and load the frame's values
+    glUseProgram(fieldProgram);
+    glUniformMatrix4fv(field_mview_index, 1, 0, field_mat);
+    glUniform1f(field_angle_index, angle);
+
+    for (s=0; s<FIELD_SHAPES; s++) {
+        if (!fieldCount[s]) continue;
+
+        if (fieldInstanced) {
+            pBindVertexArray(fieldVaos[s]);
+            glDrawElementsInstanced(GL_TRIANGLES, fieldGears[s]->numIndices,
+                                    GL_UNSIGNED_SHORT, (const void*)0,
+                                    fieldCount[s]);
+            pBindVertexArray(0);
+        } else {
+            setfieldattribs(s, GL_FALSE);
+            for (i=fieldFirst[s]; i<fieldFirst[s]+fieldCount[s]; i++) {
+                glVertexAttrib4fv(field_place_index, fieldData[i].place);
+                glVertexAttrib3fv(field_mat_index, fieldData[i].material);
+                glDrawElements(GL_TRIANGLES, fieldGears[s]->numIndices,
+                               GL_UNSIGNED_SHORT, (const void*)0);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+    }
+}
+
+// Clean up the gear field
+static void
+fieldTerm(void)
+{
+    int s;
+
+    if (fieldVaos[0]) {
+        pDeleteVertexArrays(FIELD_SHAPES, fieldVaos);
+        MEMSET(fieldVaos, 0, sizeof(fieldVaos));
+    }
+    if (fieldBuffer) { glDeleteBuffers(1, &fieldBuffer); fieldBuffer = 0; }
+    for (s=0; s<FIELD_SHAPES; s++) {
+        if (fieldGears[s]) { freegear(fieldGears[s]); fieldGears[s] = NULL; }
+        fieldCount[s] = 0;
+    }
+    if (fieldData) { FREE(fieldData); fieldData = NULL; }
+    if (fieldProgram) { glDeleteProgram(fieldProgram); fieldProgram = 0; }
+    fieldTotal = fieldTris = 0;
+}
+
 // Clean up graphics objects
 void
 gearsTerm(void)
 {
+    fieldTerm();
     if (gearShaderProgram) { glDeleteProgram(gearShaderProgram); }
     if (gear1) freegear(gear1);
     if (gear2) freegear(gear2);
     if (gear3) freegear(gear3);
+    gear1 = gear2 = gear3 = NULL;
+    gearShaderProgram = 0;
 }
@@ -29,7 +29,15 @@
 
 int  gearsInit(int width, int height);
 void gearsResize(int width, int height);
+void gearsSetState(void);
 void gearsRender(GLfloat angle);
 void gearsTerm(void);
 
+// Stress field of many gears, set up after gearsInit
+int  gearsFieldInit(int count, int instanced);
+void gearsFieldRender(GLfloat angle);
+int  gearsFieldCount(void);
+int  gearsFieldTriangles(void);
+int  gearsFieldDraws(void);
+
 #endif // __GEARSLIB_H
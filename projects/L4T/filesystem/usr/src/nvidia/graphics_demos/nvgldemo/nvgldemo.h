@@ -59,6 +59,7 @@ extern "C" {
 #define FREE    free
 #define MEMSET  memset
 #define MEMCPY  memcpy
+#define MEMCMP  memcmp
 #define STRLEN  strlen
 #define STRCMP  strcmp
 #define STRNCMP strncmp
@@ -108,6 +109,18 @@ NvGlDemoLoadFile(
     const char *file,
     unsigned int *size);
 
+// Maps a data file read-only into memory. The pages are shared with any
+//   other process mapping the same file and are only faulted in on access.
+void*
+NvGlDemoMapFile(
+    const char *file,
+    unsigned int *size);
+
+void
+NvGlDemoUnmapFile(
+    void *data,
+    unsigned int size);
+
 // window system interface type
 typedef enum NvGlDemoInterfaceEnum
 {
@@ -294,6 +307,8 @@ typedef struct {
     float inactivityTime;                   // Interval for inactivity testing
     int isSmart;                            // can detect termination of cross-partition stream
     int isProtected;                        // Set protected content
+    float streamStats;                      // Stream telemetry report interval
+                                            // (<0 off, 0 at exit only)
 } NvGlDemoOptions;
 
 // Values for displayBlend option
@@ -452,6 +467,18 @@ NvGlDemoLoadTgaFromBuffer(
     unsigned int count,
     unsigned char** buffer);
 
+//
+// Context queries
+//
+
+// Check whether the current context provides at least OpenGL ES
+//   major.minor. Demos request a version 2 context, which may be any
+//   later version, and use this to find out what they can use.
+GLboolean
+NvGlDemoHasGlesVersion(
+    int major,
+    int minor);
+
 //
 // Shader setup
 //
@@ -689,6 +716,19 @@ NvGlDemoInactivityInit(void);
 void
 NvGlDemoInactivitySleep(void);
 
+//
+// Producer stream telemetry (-streamstats)
+//
+
+void
+NvGlDemoProducerStatsInit(void);
+
+void
+NvGlDemoProducerStatsUpdate(void);
+
+void
+NvGlDemoProducerStatsShutdown(void);
+
 //
 // Renderahead implementation
 //
@@ -702,6 +742,114 @@ NvGlDemoThrottleInit(void);
 void
 NvGlDemoThrottleShutdown(void);
 
+//
+// EGLStream telemetry
+//
+
+// Queries used by the stream telemetry. Each returns EGL_FALSE if the
+//   attribute is not supported, and the matching counters are left out.
+//   queryFrame takes EGL_PRODUCER_FRAME_KHR/EGL_CONSUMER_FRAME_KHR and
+//   queryTime takes EGL_STREAM_TIME_{NOW,CONSUMER,PRODUCER}_KHR.
+typedef struct {
+    EGLBoolean (*queryFrame)(void* handle, EGLenum attrib,
+                             EGLuint64KHR* value);
+    EGLBoolean (*queryTime)(void* handle, EGLenum attrib,
+                            EGLTimeKHR* value);
+} NvGlDemoStreamOps;
+
+// Counters for one report period
+typedef struct {
+    long long startTime;
+    unsigned long long frames;              // Frames acquired or presented
+    unsigned long long missed;              // Acquires with no new frame
+    unsigned long long skipped;             // Frames replaced before acquire
+    unsigned long long occupancySum;        // Producer frame - consumer frame
+    unsigned long long occupancyMax;
+    unsigned long long occupancySamples;
+    long long latencySum;                   // Age of acquired frames (ns)
+    long long latencyMax;
+    unsigned long long latencySamples;
+} NvGlDemoStreamCounters;
+
+typedef struct {
+    char name[32];
+    const NvGlDemoStreamOps* ops;
+    void* handle;
+    int fifoLength;                         // 0 -> mailbox
+    int producer;                           // Counting presents, not acquires
+    int haveConsumerFrame;
+    EGLuint64KHR consumerFrame;             // Last consumer frame seen
+    long long lastReport;
+    NvGlDemoStreamCounters total;
+    NvGlDemoStreamCounters interval;
+} NvGlDemoStreamStats;
+
+// In-process stand-in for an EGLStream, for exercising the telemetry
+//   without EGLStream support.
+#define NVGLDEMO_FAKE_STREAM_MAX_FIFO 8
+typedef struct {
+    int fifoLength;                         // 0 -> mailbox
+    int head;
+    int queued;
+    EGLTimeKHR queue[NVGLDEMO_FAKE_STREAM_MAX_FIFO];
+    EGLuint64KHR producerFrame;
+    EGLuint64KHR consumerFrame;
+    EGLTimeKHR now;
+    EGLTimeKHR producerTime;
+    EGLTimeKHR consumerTime;
+} NvGlDemoFakeStream;
+
+const NvGlDemoStreamOps*
+NvGlDemoStreamEglOps(void);
+
+const NvGlDemoStreamOps*
+NvGlDemoStreamFakeOps(void);
+
+void
+NvGlDemoFakeStreamInit(
+    NvGlDemoFakeStream* fake,
+    int fifoLength);
+
+EGLBoolean
+NvGlDemoFakeStreamPresent(
+    NvGlDemoFakeStream* fake,
+    EGLTimeKHR now);
+
+EGLBoolean
+NvGlDemoFakeStreamAcquire(
+    NvGlDemoFakeStream* fake,
+    EGLTimeKHR now);
+
+void
+NvGlDemoStreamStatsInit(
+    NvGlDemoStreamStats* stats,
+    const char* name,
+    const NvGlDemoStreamOps* ops,
+    void* handle,
+    int fifoLength,
+    int producer,
+    long long now);
+
+void
+NvGlDemoStreamStatsAcquire(
+    NvGlDemoStreamStats* stats,
+    EGLBoolean acquired);
+
+void
+NvGlDemoStreamStatsPresent(
+    NvGlDemoStreamStats* stats);
+
+void
+NvGlDemoStreamStatsPoll(
+    NvGlDemoStreamStats* stats,
+    float interval,
+    long long now);
+
+void
+NvGlDemoStreamStatsReport(
+    NvGlDemoStreamStats* stats,
+    long long now);
+
 #ifdef __cplusplus
 }
 #endif
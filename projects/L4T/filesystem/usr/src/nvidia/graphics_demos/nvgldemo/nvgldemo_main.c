@@ -430,7 +430,8 @@ NvGlDemoInitializeParsed(
 
     // Request GL version
     cfgAttrs[cfgAttrIndex++] = EGL_RENDERABLE_TYPE;
-    cfgAttrs[cfgAttrIndex++] = (glversion == 2) ? EGL_OPENGL_ES2_BIT
+    cfgAttrs[cfgAttrIndex++] = (glversion >= 3) ? EGL_OPENGL_ES3_BIT
+                             : (glversion == 2) ? EGL_OPENGL_ES2_BIT
                                                 : EGL_OPENGL_ES_BIT;
     ctxAttrs[ctxAttrIndex++] = EGL_CONTEXT_CLIENT_VERSION;
     ctxAttrs[ctxAttrIndex++] = glversion;
@@ -36,6 +36,8 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <string.h>
@@ -129,6 +131,61 @@ NvGlDemoLoadFile(
     return data;
 }
 
+// Maps a data file read-only into memory
+void*
+NvGlDemoMapFile(
+    const char *file,
+    unsigned int *size)
+{
+    const char *filename;
+    char path[1024];
+    void *data;
+    struct stat st;
+    int fd;
+
+#ifdef ANDROID
+    snprintf(path, sizeof(path), "/data/graphics/demo/%s", file);
+    if ((fd = open(filename = path, O_RDONLY)) < 0) {
+        printf("Unable to open file %s\n", filename);
+        return 0;
+    }
+#else
+    // Look in both the current and parent dir
+    snprintf(path, sizeof(path), "../%s", file);
+    if (((fd = open(filename = path + 1, O_RDONLY)) < 0) &&
+        ((fd = open(filename = path, O_RDONLY)) < 0)) {
+        return 0;
+    }
+#endif
+
+    if ((fstat(fd, &st) != 0) || (st.st_size <= 0)) {
+        printf("Unable to get file size: %s\n", filename);
+        close(fd);
+        return 0;
+    }
+
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Unable to map file: %s\n", filename);
+        return 0;
+    }
+
+    if (size) *size = st.st_size;
+    return data;
+}
+
+// Releases a mapping returned by NvGlDemoMapFile
+void
+NvGlDemoUnmapFile(
+    void *data,
+    unsigned int size)
+{
+    if (data) {
+        munmap(data, size);
+    }
+}
+
 int
 NvGlDemoSaveFile(
     const char *file,
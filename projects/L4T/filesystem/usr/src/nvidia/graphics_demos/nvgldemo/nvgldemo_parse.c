@@ -262,6 +262,8 @@ NvGlDemoArgUsageString(void)
         "                                                   throttle mailbox mode.)\n"
         "    [-latency <usec>]                              (0 min, 2147483647 max)\n"
         "    [-timeout <usec>]                              (0 min, 2147483647 max)\n"
+        "    [-streamstats <seconds>]                       (EGLStream telemetry report\n"
+        "                                                   interval, 0 at exit only)\n"
         "    [-frames <#>]                                  (max numnber of frames to run)\n"
         "    [-ip <IP address>]                             (IP address)\n"
         "    [-port <int>]                                  (port number for multiple "
@@ -316,6 +318,7 @@ NvGlDemoArgParse(
     demoOptions.port = 8888;
 
     demoOptions.inactivityTime = -1.0f;
+    demoOptions.streamStats = -1.0f;
 
     // Parse all recognized arguments. Skip unrecognized.
     for (i=1; i<*argc && !parseFailed; /*nop*/) {
@@ -529,6 +532,13 @@ NvGlDemoArgParse(
             // No additional action needed
         }
 
+        // EGLStream telemetry report interval
+        else if (NvGlDemoArgMatchFlt(argc, argv, i, "-streamstats",
+                                    "<seconds>", 0.0f, 3600.0f,
+                                    1, &demoOptions.streamStats)) {
+            // No additional action needed
+        }
+
         // To set producer/consumer
         else if (NvGlDemoArgMatchStr(argc, argv, i, "-proctype",
                                  "{producer|consumer}[#]",
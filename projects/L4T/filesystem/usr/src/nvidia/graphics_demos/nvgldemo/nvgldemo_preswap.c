@@ -28,6 +28,8 @@
 static long long sleepTime;
 static long long sleepInterval;
 static GLsync *syncobjarr;
+static NvGlDemoStreamStats producerStats;
+static int producerStatsActive;
 
 //
 // This file contains utility functions which a producer is expected to run
@@ -47,6 +49,7 @@ NvGlDemoPreSwapInit(void) {
     }
 
     NvGlDemoInactivityInit();
+    NvGlDemoProducerStatsInit();
     return 1;
 }
 
@@ -60,6 +63,7 @@ NvGlDemoPreSwapExec(void) {
     }
 
     NvGlDemoInactivitySleep();
+    NvGlDemoProducerStatsUpdate();
 
     return 1;
 }
@@ -69,6 +73,7 @@ void
 NvGlDemoPreSwapShutdown(void) {
     // Deallocate the resources used by renderahead
     NvGlDemoThrottleShutdown();
+    NvGlDemoProducerStatsShutdown();
 }
 
 //
@@ -98,6 +103,54 @@ NvGlDemoInactivitySleep(void) {
     }
 }
 
+//
+// Producer stream telemetry
+//
+
+// Start counting frames if we render into an EGLStream and telemetry was
+//   requested. The FIFO length is chosen by the consumer, so ask the stream.
+void
+NvGlDemoProducerStatsInit(void) {
+    PFNEGLQUERYSTREAMKHRPROC peglQueryStreamKHR;
+    EGLint fifoLength = demoOptions.nFifo;
+
+    producerStatsActive = 0;
+    if ((demoOptions.streamStats < 0.0f)
+        || (demoState.stream == EGL_NO_STREAM_KHR)) {
+        return;
+    }
+
+    peglQueryStreamKHR = (PFNEGLQUERYSTREAMKHRPROC)
+        eglGetProcAddress("eglQueryStreamKHR");
+    if (peglQueryStreamKHR) {
+        peglQueryStreamKHR(demoState.display, demoState.stream,
+                           EGL_STREAM_FIFO_LENGTH_KHR, &fifoLength);
+    }
+
+    NvGlDemoStreamStatsInit(&producerStats, "producer",
+                            NvGlDemoStreamEglOps(),
+                            (void*)demoState.stream,
+                            fifoLength, 1, SYSTIME());
+    producerStatsActive = 1;
+}
+
+void
+NvGlDemoProducerStatsUpdate(void) {
+    if (producerStatsActive) {
+        NvGlDemoStreamStatsPresent(&producerStats);
+        NvGlDemoStreamStatsPoll(&producerStats, demoOptions.streamStats,
+                                SYSTIME());
+    }
+}
+
+void
+NvGlDemoProducerStatsShutdown(void) {
+    if (producerStatsActive) {
+        NvGlDemoStreamStatsReport(&producerStats, SYSTIME());
+        producerStatsActive = 0;
+    }
+}
+
 //
 // Required logic for renderahead
 //
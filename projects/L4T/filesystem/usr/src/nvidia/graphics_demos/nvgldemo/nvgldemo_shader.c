@@ -34,6 +34,24 @@
 typedef void (*PFNGLPROGRAMBINARY)(GLuint, GLenum, const void *, GLsizei);
 typedef void (*PFNGLGETPROGRAMBINARY)(GLuint, GLsizei, GLsizei *,GLenum *,void *);
 
+// Check whether the current context provides at least OpenGL ES major.minor
+GLboolean
+NvGlDemoHasGlesVersion(
+    int major,
+    int minor)
+{
+    const char *version = (const char*)glGetString(GL_VERSION);
+
+    if (!version || STRNCMP(version, "OpenGL ES ", 10)) {
+        return GL_FALSE;
+    }
+    if (version[10] != '0' + major) {
+        return (version[10] > '0' + major) ? GL_TRUE : GL_FALSE;
+    }
+    return ((version[11] == '.') && (version[12] >= '0' + minor))
+           ? GL_TRUE : GL_FALSE;
+}
+
 // Function to print logs when shader compilation fails
 static void
 NvGlDemoShaderDebug(
@@ -0,0 +1,475 @@
+/*
+ * nvgldemo_stream.c
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// This file contains per-stream telemetry for EGLStream producers and
+//   consumers. The counters only talk to the stream through a small table
+//   of query functions, so they can be driven by a fake stream as well as
+//   by a real EGLStream.
+//
+
+#include "nvgldemo.h"
+
+//
+// EGLStream queries
+//
+
+static PFNEGLQUERYSTREAMU64KHRPROC  peglQueryStreamu64KHR  = NULL;
+static PFNEGLQUERYSTREAMTIMEKHRPROC peglQueryStreamTimeKHR = NULL;
+static int eglStreamOpsLoaded = 0;
+
+static EGLBoolean
+eglStreamQueryFrame(
+    void* handle,
+    EGLenum attrib,
+    EGLuint64KHR* value)
+{
+    if (!peglQueryStreamu64KHR) {
+        return EGL_FALSE;
+    }
+    return peglQueryStreamu64KHR(demoState.display, (EGLStreamKHR)handle,
+                                 attrib, value);
+}
+
+static EGLBoolean
+eglStreamQueryTime(
+    void* handle,
+    EGLenum attrib,
+    EGLTimeKHR* value)
+{
+    if (!peglQueryStreamTimeKHR) {
+        return EGL_FALSE;
+    }
+    return peglQueryStreamTimeKHR(demoState.display, (EGLStreamKHR)handle,
+                                  attrib, value);
+}
+
+static const NvGlDemoStreamOps eglStreamOps = {
+    eglStreamQueryFrame,
+    eglStreamQueryTime
+};
+
+// Returns the queries for a real EGLStream. Queries whose extension is not
+//   exposed by the implementation simply fail, and the matching counters
+//   are reported as unavailable.
+const NvGlDemoStreamOps*
+NvGlDemoStreamEglOps(void)
+{
+    if (!eglStreamOpsLoaded) {
+        const char* extensions =
+            NVGLDEMO_EGL_QUERY_STRING(demoState.display, EGL_EXTENSIONS);
+
+        if (extensions && STRSTR(extensions, "EGL_KHR_stream")) {
+            peglQueryStreamu64KHR = (PFNEGLQUERYSTREAMU64KHRPROC)
+                eglGetProcAddress("eglQueryStreamu64KHR");
+        }
+        if (extensions && STRSTR(extensions, "EGL_KHR_stream_fifo")) {
+            peglQueryStreamTimeKHR = (PFNEGLQUERYSTREAMTIMEKHRPROC)
+                eglGetProcAddress("eglQueryStreamTimeKHR");
+        }
+        eglStreamOpsLoaded = 1;
+    }
+    return &eglStreamOps;
+}
+
+//
+// Fake stream
+//
+
+static EGLBoolean
+fakeStreamQueryFrame(
+    void* handle,
+    EGLenum attrib,
+    EGLuint64KHR* value)
+{
+    NvGlDemoFakeStream* fake = (NvGlDemoFakeStream*)handle;
+
+    switch (attrib) {
+    case EGL_PRODUCER_FRAME_KHR:
+        *value = fake->producerFrame;
+        return EGL_TRUE;
+    case EGL_CONSUMER_FRAME_KHR:
+        *value = fake->consumerFrame;
+        return EGL_TRUE;
+    default:
+        return EGL_FALSE;
+    }
+}
+
+static EGLBoolean
+fakeStreamQueryTime(
+    void* handle,
+    EGLenum attrib,
+    EGLTimeKHR* value)
+{
+    NvGlDemoFakeStream* fake = (NvGlDemoFakeStream*)handle;
+
+    switch (attrib) {
+    case EGL_STREAM_TIME_NOW_KHR:
+        *value = fake->now;
+        return EGL_TRUE;
+    case EGL_STREAM_TIME_CONSUMER_KHR:
+        *value = fake->consumerTime;
+        return EGL_TRUE;
+    case EGL_STREAM_TIME_PRODUCER_KHR:
+        *value = fake->producerTime;
+        return EGL_TRUE;
+    default:
+        return EGL_FALSE;
+    }
+}
+
+static const NvGlDemoStreamOps fakeStreamOps = {
+    fakeStreamQueryFrame,
+    fakeStreamQueryTime
+};
+
+const NvGlDemoStreamOps*
+NvGlDemoStreamFakeOps(void)
+{
+    return &fakeStreamOps;
+}
+
+// Set up a fake stream. A fifoLength of 0 selects mailbox mode.
+void
+NvGlDemoFakeStreamInit(
+    NvGlDemoFakeStream* fake,
+    int fifoLength)
+{
+    MEMSET(fake, 0, sizeof(*fake));
+    if (fifoLength > NVGLDEMO_FAKE_STREAM_MAX_FIFO) {
+        fifoLength = NVGLDEMO_FAKE_STREAM_MAX_FIFO;
+    }
+    fake->fifoLength = fifoLength;
+}
+
+// Insert a frame produced at time <now>. In FIFO mode this fails when the
+//   FIFO is full, which is where a real producer would block. In mailbox
+//   mode the pending frame, if any, is replaced.
+EGLBoolean
+NvGlDemoFakeStreamPresent(
+    NvGlDemoFakeStream* fake,
+    EGLTimeKHR now)
+{
+    fake->now = now;
+    if (fake->fifoLength) {
+        if (fake->queued == fake->fifoLength) {
+            return EGL_FALSE;
+        }
+        fake->queue[(fake->head + fake->queued) % fake->fifoLength] = now;
+        fake->queued++;
+    } else {
+        fake->queue[0] = now;
+        fake->queued = 1;
+    }
+    fake->producerFrame++;
+    fake->producerTime = now;
+    return EGL_TRUE;
+}
+
+// Acquire the oldest pending frame at time <now>. Fails if there is none,
+//   in which case the consumer keeps the frame it already holds.
+EGLBoolean
+NvGlDemoFakeStreamAcquire(
+    NvGlDemoFakeStream* fake,
+    EGLTimeKHR now)
+{
+    fake->now = now;
+    if (!fake->queued) {
+        return EGL_FALSE;
+    }
+    if (fake->fifoLength) {
+        fake->consumerTime = fake->queue[fake->head];
+        fake->head = (fake->head + 1) % fake->fifoLength;
+    } else {
+        fake->consumerTime = fake->queue[0];
+    }
+    fake->queued--;
+    fake->consumerFrame = fake->producerFrame - fake->queued;
+    return EGL_TRUE;
+}
+
+//
+// Telemetry
+//
+
+static void
+countersReset(
+    NvGlDemoStreamCounters* counters,
+    long long now)
+{
+    MEMSET(counters, 0, sizeof(*counters));
+    counters->startTime = now;
+}
+
+static void
+countersOccupancy(
+    NvGlDemoStreamCounters* counters,
+    unsigned long long occupancy)
+{
+    counters->occupancySum += occupancy;
+    counters->occupancySamples++;
+    if (occupancy > counters->occupancyMax) {
+        counters->occupancyMax = occupancy;
+    }
+}
+
+static void
+countersLatency(
+    NvGlDemoStreamCounters* counters,
+    long long latency)
+{
+    counters->latencySum += latency;
+    counters->latencySamples++;
+    if (latency > counters->latencyMax) {
+        counters->latencyMax = latency;
+    }
+}
+
+// Sample the stream frame numbers. Returns the FIFO occupancy, or -1 if
+//   the frame queries are not supported, and how far the consumer frame
+//   number moved since the last sample.
+static long long
+statsSampleFrames(
+    NvGlDemoStreamStats* stats,
+    unsigned long long* advanced)
+{
+    EGLuint64KHR producerFrame, consumerFrame;
+
+    *advanced = 1;
+    if (!stats->ops->queryFrame(stats->handle, EGL_PRODUCER_FRAME_KHR,
+                                &producerFrame)
+     || !stats->ops->queryFrame(stats->handle, EGL_CONSUMER_FRAME_KHR,
+                                &consumerFrame)) {
+        return -1;
+    }
+
+    if (stats->haveConsumerFrame) {
+        *advanced = (consumerFrame > stats->consumerFrame) ?
+                        consumerFrame - stats->consumerFrame : 0;
+    }
+    stats->consumerFrame = consumerFrame;
+    stats->haveConsumerFrame = 1;
+
+    return (producerFrame > consumerFrame) ?
+               (long long)(producerFrame - consumerFrame) : 0;
+}
+
+// Set up telemetry for one end of a stream. <handle> is passed back to the
+//   query functions; for EGLStreams it is the EGLStreamKHR itself. A
+//   fifoLength of 0 means the stream is in mailbox mode.
+void
+NvGlDemoStreamStatsInit(
+    NvGlDemoStreamStats* stats,
+    const char* name,
+    const NvGlDemoStreamOps* ops,
+    void* handle,
+    int fifoLength,
+    int producer,
+    long long now)
+{
+    MEMSET(stats, 0, sizeof(*stats));
+    STRNCPY(stats->name, name, sizeof(stats->name) - 1);
+    stats->ops = ops;
+    stats->handle = handle;
+    stats->fifoLength = fifoLength;
+    stats->producer = producer;
+    stats->lastReport = now;
+    countersReset(&stats->total, now);
+    countersReset(&stats->interval, now);
+
+    // Start from the frame the consumer holds now, so frames replaced in
+    //   the mailbox before the first acquire are counted as skipped.
+    if (ops->queryFrame(handle, EGL_CONSUMER_FRAME_KHR,
+                        &stats->consumerFrame)) {
+        stats->haveConsumerFrame = 1;
+    }
+}
+
+// Record a consumer acquire attempt. A failed attempt means the consumer
+//   had no new frame and reused the one it already held.
+void
+NvGlDemoStreamStatsAcquire(
+    NvGlDemoStreamStats* stats,
+    EGLBoolean acquired)
+{
+    unsigned long long advanced;
+    long long occupancy;
+    EGLTimeKHR now, frameTime;
+
+    // Some implementations succeed and hand back the frame the consumer
+    //   already held; the unchanged frame number tells those apart.
+    occupancy = acquired ? statsSampleFrames(stats, &advanced) : -1;
+    if (!acquired || (advanced == 0)) {
+        stats->total.missed++;
+        stats->interval.missed++;
+        return;
+    }
+
+    stats->total.frames++;
+    stats->interval.frames++;
+
+    // A jump of more than one frame means the frames in between were
+    //   replaced in the mailbox before they could be acquired.
+    if (occupancy >= 0) {
+        stats->total.skipped += advanced - 1;
+        stats->interval.skipped += advanced - 1;
+        countersOccupancy(&stats->total, occupancy);
+        countersOccupancy(&stats->interval, occupancy);
+    }
+
+    // Age of the acquired frame, from its insertion by the producer (or its
+    //   requested display time, if a consumer latency was set) until now.
+    if (stats->ops->queryTime(stats->handle, EGL_STREAM_TIME_NOW_KHR, &now)
+     && stats->ops->queryTime(stats->handle, EGL_STREAM_TIME_CONSUMER_KHR,
+                              &frameTime)) {
+        long long latency = (now > frameTime) ? (long long)(now - frameTime) : 0;
+        countersLatency(&stats->total, latency);
+        countersLatency(&stats->interval, latency);
+    }
+}
+
+// Record a frame about to be presented by the producer.
+void
+NvGlDemoStreamStatsPresent(
+    NvGlDemoStreamStats* stats)
+{
+    unsigned long long advanced;
+    long long occupancy;
+
+    stats->total.frames++;
+    stats->interval.frames++;
+
+    // The consumer may take several frames between two presents, so frame
+    //   number jumps seen from here say nothing about skipped frames.
+    occupancy = statsSampleFrames(stats, &advanced);
+    if (occupancy >= 0) {
+        countersOccupancy(&stats->total, occupancy);
+        countersOccupancy(&stats->interval, occupancy);
+    }
+}
+
+// Guess which side of the stream limits the frame rate. A queue that stays
+//   full, or frames being replaced in mailbox mode, means the consumer is
+//   not keeping up; a queue that stays empty, or a consumer that often
+//   finds no new frame, means it is waiting on the producer.
+static const char*
+statsBound(
+    const NvGlDemoStreamStats* stats,
+    const NvGlDemoStreamCounters* counters)
+{
+    float occupancy;
+    int full;
+
+    if (!counters->frames) {
+        return "idle";
+    }
+
+    if (!stats->producer && (counters->missed * 10 >= counters->frames)) {
+        return "producer-bound";
+    }
+
+    if (!counters->occupancySamples) {
+        return "balanced";
+    }
+
+    occupancy = (float)counters->occupancySum / counters->occupancySamples;
+    if (counters->skipped * 10 >= counters->frames) {
+        return "consumer-bound";
+    }
+    // The consumer samples right after taking a frame off the queue
+    full = stats->producer ? stats->fifoLength : stats->fifoLength - 1;
+    if ((full > 0) && (occupancy >= full - 0.5f)) {
+        return "consumer-bound";
+    }
+    if (stats->producer && (occupancy < 0.5f)) {
+        return "producer-bound";
+    }
+    return "balanced";
+}
+
+static void
+statsPrint(
+    const NvGlDemoStreamStats* stats,
+    const NvGlDemoStreamCounters* counters,
+    const char* label,
+    long long now)
+{
+    char mode[16] = "mailbox";
+    char occupancy[64] = "n/a";
+    char latency[64] = "n/a";
+    float seconds = (float)(now - counters->startTime) / 1000000000.0f;
+
+    if (stats->fifoLength) {
+        SNPRINTF(mode, sizeof(mode), "fifo %d", stats->fifoLength);
+    }
+    if (counters->occupancySamples) {
+        SNPRINTF(occupancy, sizeof(occupancy), "%.2f avg %llu max",
+                 (float)counters->occupancySum / counters->occupancySamples,
+                 counters->occupancyMax);
+    }
+    if (counters->latencySamples) {
+        SNPRINTF(latency, sizeof(latency), "%.2f avg %.2f max ms",
+                 (float)counters->latencySum / counters->latencySamples
+                     / 1000000.0f,
+                 (float)counters->latencyMax / 1000000.0f);
+    }
+
+    NvGlDemoLog("%s stream %s (%s): %llu %s (%.1f/s), %llu missed, "
+                "%llu skipped, occupancy %s, latency %s, %s\n",
+                label, stats->name, mode,
+                counters->frames, stats->producer ? "presented" : "acquired",
+                (seconds > 0.0f) ? counters->frames / seconds : 0.0f,
+                counters->missed, counters->skipped,
+                occupancy, latency, statsBound(stats, counters));
+}
+
+// Print and restart the interval counters if the report interval has
+//   elapsed. An interval of 0 or less only reports at exit.
+void
+NvGlDemoStreamStatsPoll(
+    NvGlDemoStreamStats* stats,
+    float interval,
+    long long now)
+{
+    if (interval <= 0.0f) {
+        return;
+    }
+    if (now - stats->lastReport < (long long)(1000000000.0 * interval)) {
+        return;
+    }
+
+    statsPrint(stats, &stats->interval, "", now);
+    countersReset(&stats->interval, now);
+    stats->lastReport = now;
+}
+
+// Print the counters accumulated over the lifetime of the stream.
+void
+NvGlDemoStreamStatsReport(
+    NvGlDemoStreamStats* stats,
+    long long now)
+{
+    statsPrint(stats, &stats->total, "Total", now);
+}
@@ -0,0 +1,170 @@
+/*
+ * nvgldemo_streamtest.c
+ *
+ * Copyright (c) 2026, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+//
+// This file drives the stream telemetry with the fake stream through a few
+//   scripted runs and checks the consumer counters against the values
+//   worked out by hand. It needs no display and exits non-zero on failure.
+//
+
+#include "nvgldemo.h"
+
+#define MS 1000000LL
+
+// One step of a script: at <ms>, the producer presents ('P') or the
+//   consumer tries to acquire ('A')
+typedef struct {
+    long long ms;
+    char op;
+} StreamStep;
+
+typedef struct {
+    const char* name;
+    int fifoLength;                         // 0 -> mailbox
+    const StreamStep* steps;
+    int numSteps;
+    int blocked;                            // Presents refused, FIFO full
+    NvGlDemoStreamCounters expect;          // Consumer totals
+} StreamScript;
+
+// FIFO of 2 with a slow consumer. The third present finds the FIFO full;
+//   each acquire then leaves one frame behind.
+static const StreamStep fifoFullSteps[] = {
+    { 1, 'P' }, { 2, 'P' }, { 3, 'P' },
+    { 4, 'A' },
+    { 5, 'P' },
+    { 6, 'A' }
+};
+
+// FIFO of 2 with a slow producer. The consumer finds nothing new twice.
+static const StreamStep fifoEmptySteps[] = {
+    { 1, 'P' },
+    { 2, 'A' }, { 3, 'A' }, { 4, 'A' },
+    { 5, 'P' },
+    { 6, 'A' }
+};
+
+// Mailbox with a slow consumer. Frames 1-2 are replaced before the first
+//   acquire, and frame 5 before the third; the last acquire finds nothing.
+static const StreamStep mailboxSteps[] = {
+    { 1, 'P' }, { 2, 'P' }, { 3, 'P' },
+    { 4, 'A' },
+    { 5, 'P' },
+    { 6, 'A' },
+    { 7, 'P' }, { 8, 'P' },
+    { 9, 'A' }, { 10, 'A' }
+};
+
+#define ARRAY_LEN(_arr) ((int)(sizeof(_arr) / sizeof(_arr[0])))
+
+// Expected totals: startTime, frames, missed, skipped,
+//   occupancy sum/max/samples, latency sum/max/samples
+static const StreamScript scripts[] = {
+    { "fifo full", 2, fifoFullSteps, ARRAY_LEN(fifoFullSteps), 1,
+      { 0, 2, 0, 0, 2, 1, 2, 7 * MS, 4 * MS, 2 } },
+    { "fifo empty", 2, fifoEmptySteps, ARRAY_LEN(fifoEmptySteps), 0,
+      { 0, 2, 2, 0, 0, 0, 2, 2 * MS, 1 * MS, 2 } },
+    { "mailbox", 0, mailboxSteps, ARRAY_LEN(mailboxSteps), 0,
+      { 0, 3, 1, 3, 0, 0, 3, 3 * MS, 1 * MS, 3 } }
+};
+
+static int
+checkValue(
+    const char* script,
+    const char* counter,
+    long long value,
+    long long expect)
+{
+    if (value != expect) {
+        NvGlDemoLog("%s: %s is %lld, expected %lld\n",
+                    script, counter, value, expect);
+        return 0;
+    }
+    return 1;
+}
+
+static int
+runScript(
+    const StreamScript* script)
+{
+    NvGlDemoFakeStream fake;
+    NvGlDemoStreamStats stats;
+    const NvGlDemoStreamCounters* got = &stats.total;
+    const NvGlDemoStreamCounters* expect = &script->expect;
+    int blocked = 0;
+    int ok = 1;
+    int i;
+
+    NvGlDemoFakeStreamInit(&fake, script->fifoLength);
+    NvGlDemoStreamStatsInit(&stats, script->name, NvGlDemoStreamFakeOps(),
+                            &fake, script->fifoLength, 0, 0);
+
+    for (i = 0; i < script->numSteps; i++) {
+        EGLTimeKHR now = script->steps[i].ms * MS;
+
+        if (script->steps[i].op == 'P') {
+            if (!NvGlDemoFakeStreamPresent(&fake, now)) {
+                blocked++;
+            }
+        } else {
+            NvGlDemoStreamStatsAcquire(&stats,
+                                       NvGlDemoFakeStreamAcquire(&fake, now));
+        }
+    }
+
+    ok &= checkValue(script->name, "blocked", blocked, script->blocked);
+    ok &= checkValue(script->name, "frames",
+                     got->frames, expect->frames);
+    ok &= checkValue(script->name, "missed",
+                     got->missed, expect->missed);
+    ok &= checkValue(script->name, "skipped",
+                     got->skipped, expect->skipped);
+    ok &= checkValue(script->name, "occupancy sum",
+                     got->occupancySum, expect->occupancySum);
+    ok &= checkValue(script->name, "occupancy max",
+                     got->occupancyMax, expect->occupancyMax);
+    ok &= checkValue(script->name, "occupancy samples",
+                     got->occupancySamples, expect->occupancySamples);
+    ok &= checkValue(script->name, "latency sum",
+                     got->latencySum, expect->latencySum);
+    ok &= checkValue(script->name, "latency max",
+                     got->latencyMax, expect->latencyMax);
+    ok &= checkValue(script->name, "latency samples",
+                     got->latencySamples, expect->latencySamples);
+
+    NvGlDemoLog("%s: %s\n", script->name, ok ? "passed" : "FAILED");
+    return ok;
+}
+
+int
+main(void)
+{
+    int ok = 1;
+    int i;
+
+    for (i = 0; i < ARRAY_LEN(scripts); i++) {
+        ok &= runScript(&scripts[i]);
+    }
+    return ok ? 0 : 1;
+}